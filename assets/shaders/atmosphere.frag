@@ -0,0 +1,136 @@
+#version 330 core
+
+// Single scattering ray-marched through the atmosphere shell, with the sun's transmittance and
+// all higher scattering orders looked up from the tables Atmosphere builds. Lengths are in
+// kilometres, relative to the body's centre. The output is premultiplied: in-scattered light,
+// and one minus the average transmittance to dim what is behind.
+
+in vec3 world_position;
+
+layout (std140) uniform FrameData
+{
+    mat4 view_matrix;
+    mat4 projection_matrix;
+    vec4 camera_position; // w unused
+};
+
+// only the sun is used here, see EclipseShadows
+layout (std140) uniform Eclipses
+{
+    vec4 sun;             // xyz centre, w radius
+    uvec4 eclipse_info;   // x = occluder count
+    vec4 occluders[16];   // xyz centre, w radius
+};
+
+// see UniformBlocks.hpp
+layout (std140) uniform Atmosphere
+{
+    vec4 radii;               // x ground, y top, z Mie asymmetry, w ground albedo
+    vec4 rayleigh_scattering; // rgb per km, w scale height
+    vec4 mie;                 // x scattering, y extinction, z scale height
+    vec4 ozone_absorption;    // rgb per km, w peak height
+    vec4 ozone;               // x half width
+};
+
+uniform vec4 ground;        // xyz world centre of the body, w its radius
+uniform float sun_illuminance;
+uniform sampler2D transmittance_lut;
+uniform sampler2D multiple_scattering_lut;
+
+out vec4 output_color;
+
+const int STEPS = 16;
+const float PI = 3.14159265358979;
+
+// distance to the sphere around the origin, negative when the ray misses it
+float ray_sphere(vec3 origin, vec3 direction, float radius, bool near)
+{
+    float b = dot(origin, direction);
+    float c = dot(origin, origin) - radius * radius;
+    float discriminant = b * b - c;
+    if (discriminant < 0.0)
+    {
+        return -1.0;
+    }
+    return near ? -b - sqrt(discriminant) : -b + sqrt(discriminant);
+}
+
+// must match TransmittanceUv() in Atmosphere.cpp
+vec2 transmittance_uv(float radius, float mu)
+{
+    float horizon = sqrt(radii.y * radii.y - radii.x * radii.x);
+    float rho = sqrt(max(radius * radius - radii.x * radii.x, 0.0));
+    float discriminant = radius * radius * (mu * mu - 1.0) + radii.y * radii.y;
+    float distance = max(-radius * mu + sqrt(max(discriminant, 0.0)), 0.0);
+    float min_distance = radii.y - radius;
+    float max_distance = rho + horizon;
+    return vec2((distance - min_distance) / (max_distance - min_distance), rho / horizon);
+}
+
+float rayleigh_phase(float cos_theta)
+{
+    return 3.0 / (16.0 * PI) * (1.0 + cos_theta * cos_theta);
+}
+
+// Cornette-Shanks
+float mie_phase(float cos_theta, float g)
+{
+    float g2 = g * g;
+    return 3.0 / (8.0 * PI) * (1.0 - g2) * (1.0 + cos_theta * cos_theta) /
+        ((2.0 + g2) * pow(1.0 + g2 - 2.0 * g * cos_theta, 1.5));
+}
+
+void main()
+{
+    float kilometres = radii.x / ground.w;
+    vec3 origin = (camera_position.xyz - ground.xyz) * kilometres;
+    vec3 direction = normalize(world_position - camera_position.xyz);
+
+    float exit = ray_sphere(origin, direction, radii.y, false);
+    if (exit <= 0.0)
+    {
+        discard;
+    }
+    float entry = max(ray_sphere(origin, direction, radii.y, true), 0.0);
+    float ground_distance = ray_sphere(origin, direction, radii.x, true);
+    if (ground_distance > 0.0)
+    {
+        exit = min(exit, ground_distance);
+    }
+
+    // the sun is far enough away that its direction is the same over the whole body
+    vec3 sun_direction = normalize(sun.xyz - ground.xyz);
+    float cos_theta = dot(direction, sun_direction);
+    float phase_rayleigh = rayleigh_phase(cos_theta);
+    float phase_mie = mie_phase(cos_theta, radii.z);
+
+    float step_length = (exit - entry) / float(STEPS);
+    vec3 luminance = vec3(0.0);
+    vec3 throughput = vec3(1.0);
+    for (int i = 0; i < STEPS; ++i)
+    {
+        vec3 position = origin + direction * (entry + (float(i) + 0.5) * step_length);
+        float radius = length(position);
+        float height = radius - radii.x;
+        float sun_mu = dot(position / radius, sun_direction);
+
+        vec3 rayleigh = rayleigh_scattering.rgb * exp(-height / rayleigh_scattering.w);
+        float mie_density = exp(-height / mie.z);
+        float ozone_density = max(0.0, 1.0 - abs(height - ozone_absorption.w) / ozone.x);
+        vec3 scattering = rayleigh + mie.x * mie_density;
+        vec3 extinction = max(rayleigh + mie.y * mie_density + ozone_absorption.rgb * ozone_density, vec3(1e-7));
+
+        float sun_visible = ray_sphere(position, sun_direction, radii.x, true) > 0.0 ? 0.0 : 1.0;
+        vec3 sun_transmittance = texture(transmittance_lut, transmittance_uv(radius, sun_mu)).rgb * sun_visible;
+        vec3 multiple = texture(multiple_scattering_lut, vec2(sun_mu * 0.5 + 0.5, height / (radii.y - radii.x))).rgb;
+
+        vec3 source = sun_transmittance * (rayleigh * phase_rayleigh + mie.x * mie_density * phase_mie) + multiple * scattering;
+
+        // integrated analytically over the step, for constant coefficients
+        vec3 step_transmittance = exp(-extinction * step_length);
+        luminance += throughput * (source - source * step_transmittance) / extinction;
+        throughput *= step_transmittance;
+    }
+
+    output_color = vec4(luminance * sun_illuminance, 1.0 - dot(throughput, vec3(1.0 / 3.0)));
+}
@@ -0,0 +1,25 @@
+#version 330 core
+
+// A unit sphere mesh scaled around a body, covering every pixel its atmosphere can touch.
+// See Atmosphere.hpp.
+
+layout (location = 0) in vec3 vertex_position;
+
+// per frame data, see UniformBlocks.hpp
+layout (std140) uniform FrameData
+{
+    mat4 view_matrix;
+    mat4 projection_matrix;
+    vec4 camera_position; // w unused
+};
+
+uniform vec4 ground;        // xyz world centre of the body, w its radius
+uniform float proxy_radius; // world radius of the shell
+
+out vec3 world_position;
+
+void main()
+{
+    world_position = ground.xyz + vertex_position * proxy_radius;
+    gl_Position = projection_matrix * view_matrix * vec4(world_position, 1.0);
+}
@@ -0,0 +1,70 @@
+#version 330 core
+
+// One step down the bloom mip chain, the 13 tap filter from "Next Generation Post Processing
+// in Call of Duty: Advanced Warfare". The first step reads the HDR scene, so it also weights
+// each group by its brightness (a Karis average, keeps single bright texels from flickering)
+// and keeps only what is above the threshold.
+
+in vec2 uv;
+
+uniform sampler2D source;
+uniform vec2 source_texel_size;
+uniform int first_level;
+uniform vec4 threshold; // x = threshold, y = threshold - knee, z = 2 * knee, w = 0.25 / knee
+
+out vec4 output_color;
+
+float luminance(vec3 color)
+{
+    return dot(color, vec3(0.2126, 0.7152, 0.0722));
+}
+
+vec3 group(vec3 a, vec3 b, vec3 c, vec3 d)
+{
+    if (first_level == 0)
+    {
+        return (a + b + c + d) * 0.25;
+    }
+    vec4 weights = 1.0 / (1.0 + vec4(luminance(a), luminance(b), luminance(c), luminance(d)));
+    return (a * weights.x + b * weights.y + c * weights.z + d * weights.w) / dot(weights, vec4(1.0));
+}
+
+vec3 soft_threshold(vec3 color)
+{
+    float brightness = max(color.r, max(color.g, color.b));
+    float soft = clamp(brightness - threshold.y, 0.0, threshold.z);
+    soft = soft * soft * threshold.w;
+    float contribution = max(soft, brightness - threshold.x) / max(brightness, 1e-4);
+    return color * contribution;
+}
+
+vec3 tap(float x, float y)
+{
+    return texture(source, uv + source_texel_size * vec2(x, y)).rgb;
+}
+
+void main()
+{
+    vec3 a = tap(-2.0, 2.0);
+    vec3 b = tap(0.0, 2.0);
+    vec3 c = tap(2.0, 2.0);
+    vec3 d = tap(-2.0, 0.0);
+    vec3 e = tap(0.0, 0.0);
+    vec3 f = tap(2.0, 0.0);
+    vec3 g = tap(-2.0, -2.0);
+    vec3 h = tap(0.0, -2.0);
+    vec3 i = tap(2.0, -2.0);
+    vec3 j = tap(-1.0, 1.0);
+    vec3 k = tap(1.0, 1.0);
+    vec3 l = tap(-1.0, -1.0);
+    vec3 m = tap(1.0, -1.0);
+
+    vec3 color = group(j, k, l, m) * 0.5 +
+        (group(a, b, d, e) + group(b, c, e, f) + group(d, e, g, h) + group(e, f, h, i)) * 0.125;
+
+    if (first_level != 0)
+    {
+        color = soft_threshold(color);
+    }
+    output_color = vec4(color, 1.0);
+}
@@ -0,0 +1,26 @@
+#version 330 core
+
+// One step up the bloom mip chain. A 3x3 tent filter of the smaller level, added on top of
+// the level below it with additive blending.
+
+in vec2 uv;
+
+uniform sampler2D source;
+uniform vec2 source_texel_size;
+uniform float filter_radius; // in source texels
+
+out vec4 output_color;
+
+vec3 tap(float x, float y)
+{
+    return texture(source, uv + source_texel_size * filter_radius * vec2(x, y)).rgb;
+}
+
+void main()
+{
+    vec3 color = tap(0.0, 0.0) * 4.0 +
+        (tap(0.0, 1.0) + tap(-1.0, 0.0) + tap(1.0, 0.0) + tap(0.0, -1.0)) * 2.0 +
+        (tap(-1.0, 1.0) + tap(1.0, 1.0) + tap(-1.0, -1.0) + tap(1.0, -1.0));
+
+    output_color = vec4(color / 16.0, 1.0);
+}
@@ -0,0 +1,58 @@
+#version 430 core
+
+// GPU-driven version of test.vert. Every indirect draw command draws a single body and
+// stores its index as baseInstance, which reaches the shader through the instanced
+// body_index attribute. The body data itself lives in the same buffer the culling reads.
+
+layout (location = 0) in vec3 vertex_position;
+layout (location = 1) in vec2 vertex_texture_coordinates;
+layout (location = 2) in vec3 vertex_normal;
+
+// see GpuDrivenRenderer
+layout (location = 8) in uint body_index;
+
+struct Body
+{
+    mat4 model_matrix;
+    vec4 local_bounds;
+    uvec4 draw_info; // x = draw range, y = texture layer, z = eclipse occluder mask, w = emission bits
+    uvec4 mesh_info;
+};
+
+layout (std430, binding = 0) readonly buffer Bodies { Body bodies[]; };
+
+// per frame data, see UniformBlocks.hpp
+layout (std140) uniform FrameData
+{
+    mat4 view_matrix;
+    mat4 projection_matrix;
+    vec4 camera_position; // w unused
+};
+
+out vec3 fragment_position;
+out vec2 texture_coordinates;
+out vec3 normal_vector;
+flat out uint texture_layer;
+flat out uint eclipse_mask;
+flat out float emission;
+
+void main()
+{
+    mat4 model_matrix = bodies[body_index].model_matrix;
+    texture_layer = bodies[body_index].draw_info.y;
+    eclipse_mask = bodies[body_index].draw_info.z;
+    emission = uintBitsToFloat(bodies[body_index].draw_info.w);
+
+    // transform to world space
+    vec4 model_pos = model_matrix * vec4(vertex_position, 1.0);
+    fragment_position = vec3(model_pos);
+
+    // pass texture coords
+    texture_coordinates = vertex_texture_coordinates;
+
+    // transforms the normal to world space
+    normal_vector = vec3(model_matrix * vec4(vertex_normal, 0.0));
+
+    // final position
+    gl_Position = projection_matrix * view_matrix * model_pos;
+}
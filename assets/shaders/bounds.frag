@@ -0,0 +1,10 @@
+#version 330 core
+
+// Colour writes are masked off while the proxy is drawn.
+
+out vec4 output_color;
+
+void main()
+{
+    output_color = vec4(1.0);
+}
@@ -0,0 +1,19 @@
+#version 330 core
+
+// Bounding box proxy for occlusion queries, only the depth test result matters.
+
+layout (location = 0) in vec3 vertex_position;
+
+uniform mat4 model_matrix;
+
+layout (std140) uniform FrameData
+{
+    mat4 view_matrix;
+    mat4 projection_matrix;
+    vec4 camera_position; // w unused
+};
+
+void main()
+{
+    gl_Position = projection_matrix * view_matrix * model_matrix * vec4(vertex_position, 1.0);
+}
@@ -0,0 +1,18 @@
+#version 330 core
+
+// Moves the adapted log luminance (a 1x1 texture kept between frames) towards this frame's
+// average, so the exposure follows the scene smoothly and never leaves the GPU.
+
+uniform sampler2D log_luminance;
+uniform float luminance_level; // the 1x1 mip
+uniform sampler2D previous_luminance;
+uniform float adaptation;      // 1 - exp(-dt * speed)
+
+out float output_log_luminance;
+
+void main()
+{
+    float target = textureLod(log_luminance, vec2(0.5), luminance_level).r;
+    float previous = texelFetch(previous_luminance, ivec2(0), 0).r;
+    output_log_luminance = previous + (target - previous) * adaptation;
+}
@@ -0,0 +1,13 @@
+#version 330 core
+
+// One triangle covering the whole viewport, built from gl_VertexID.
+// Draw with glDrawArrays(GL_TRIANGLES, 0, 3) and any VAO bound.
+
+out vec2 uv;
+
+void main()
+{
+    vec2 position = vec2(float((gl_VertexID << 1) & 2), float(gl_VertexID & 2));
+    uv = position;
+    gl_Position = vec4(position * 2.0 - 1.0, 0.0, 1.0);
+}
@@ -0,0 +1,153 @@
+#version 330 core
+
+// FXAA after Timothy Lottes' FXAA 3.11 quality preset, on the HDR scene. Edges are searched in
+// the luma of colours compressed by 1 / (1 + luma), so a bright body against the black sky gets
+// the same treatment as a dim one. The blend itself samples the uncompressed scene.
+
+in vec2 uv;
+
+uniform sampler2D source;
+uniform vec2 source_texel_size;
+uniform vec2 settings; // x = edge threshold, y = subpixel amount
+
+out vec4 output_color;
+
+const int SEARCH_STEPS = 10;
+const float EDGE_THRESHOLD_MIN = 0.0312;
+
+float luma(vec3 color)
+{
+    return dot(color, vec3(0.299, 0.587, 0.114));
+}
+
+vec3 compress(vec3 color)
+{
+    return color / (1.0 + luma(color));
+}
+
+float luma_at(vec2 position)
+{
+    return luma(compress(textureLod(source, position, 0.0).rgb));
+}
+
+void main()
+{
+    vec3 center_color = textureLod(source, uv, 0.0).rgb;
+    float center = luma(compress(center_color));
+    float north = luma_at(uv + vec2(0.0, source_texel_size.y));
+    float south = luma_at(uv - vec2(0.0, source_texel_size.y));
+    float east = luma_at(uv + vec2(source_texel_size.x, 0.0));
+    float west = luma_at(uv - vec2(source_texel_size.x, 0.0));
+
+    float highest = max(center, max(max(north, south), max(east, west)));
+    float lowest = min(center, min(min(north, south), min(east, west)));
+    float range = highest - lowest;
+    if (range < max(EDGE_THRESHOLD_MIN, highest * settings.x))
+    {
+        output_color = vec4(center_color, 1.0);
+        return;
+    }
+
+    float north_east = luma_at(uv + source_texel_size);
+    float south_west = luma_at(uv - source_texel_size);
+    float south_east = luma_at(uv + vec2(source_texel_size.x, -source_texel_size.y));
+    float north_west = luma_at(uv + vec2(-source_texel_size.x, source_texel_size.y));
+
+    // single pixel detail: how far the center is from its low-passed neighbourhood
+    float average = (2.0 * (north + south + east + west) + north_east + north_west + south_east + south_west) / 12.0;
+    float subpixel = clamp(abs(average - center) / range, 0.0, 1.0);
+    subpixel = smoothstep(0.0, 1.0, subpixel);
+    subpixel = subpixel * subpixel * settings.y;
+
+    // the edge runs along the axis with the smaller second derivative
+    float horizontal =
+        abs(north_west - 2.0 * west + south_west) +
+        2.0 * abs(north - 2.0 * center + south) +
+        abs(north_east - 2.0 * east + south_east);
+    float vertical =
+        abs(north_west - 2.0 * north + north_east) +
+        2.0 * abs(west - 2.0 * center + east) +
+        abs(south_west - 2.0 * south + south_east);
+    bool is_horizontal = horizontal >= vertical;
+
+    // step across the edge towards the neighbour with the larger contrast
+    float negative = is_horizontal ? south : west;
+    float positive = is_horizontal ? north : east;
+    float gradient_negative = abs(negative - center);
+    float gradient_positive = abs(positive - center);
+    float step_length = is_horizontal ? source_texel_size.y : source_texel_size.x;
+    float edge_luma;
+    float gradient;
+    if (gradient_negative >= gradient_positive)
+    {
+        step_length = -step_length;
+        edge_luma = 0.5 * (negative + center);
+        gradient = gradient_negative;
+    }
+    else
+    {
+        edge_luma = 0.5 * (positive + center);
+        gradient = gradient_positive;
+    }
+
+    // walk both ways along the edge, half a texel off the center row, until the luma leaves the edge's
+    vec2 edge_uv = uv;
+    vec2 along;
+    if (is_horizontal)
+    {
+        edge_uv.y += 0.5 * step_length;
+        along = vec2(source_texel_size.x, 0.0);
+    }
+    else
+    {
+        edge_uv.x += 0.5 * step_length;
+        along = vec2(0.0, source_texel_size.y);
+    }
+    float scaled_gradient = 0.25 * gradient;
+
+    vec2 uv_negative = edge_uv - along;
+    vec2 uv_positive = edge_uv + along;
+    float end_negative = luma_at(uv_negative) - edge_luma;
+    float end_positive = luma_at(uv_positive) - edge_luma;
+    bool done_negative = abs(end_negative) >= scaled_gradient;
+    bool done_positive = abs(end_positive) >= scaled_gradient;
+    for (int i = 1; i < SEARCH_STEPS && !(done_negative && done_positive); ++i)
+    {
+        float stride = i < 4 ? 1.0 : 2.0;
+        if (!done_negative)
+        {
+            uv_negative -= along * stride;
+            end_negative = luma_at(uv_negative) - edge_luma;
+            done_negative = abs(end_negative) >= scaled_gradient;
+        }
+        if (!done_positive)
+        {
+            uv_positive += along * stride;
+            end_positive = luma_at(uv_positive) - edge_luma;
+            done_positive = abs(end_positive) >= scaled_gradient;
+        }
+    }
+
+    float distance_negative = is_horizontal ? uv.x - uv_negative.x : uv.y - uv_negative.y;
+    float distance_positive = is_horizontal ? uv_positive.x - uv.x : uv_positive.y - uv.y;
+    bool negative_closer = distance_negative < distance_positive;
+    float closest = min(distance_negative, distance_positive);
+    float edge_length = distance_negative + distance_positive;
+
+    // only blend when the nearer end moves away from the center's side of the edge
+    bool center_below = center - edge_luma < 0.0;
+    bool end_below = (negative_closer ? end_negative : end_positive) < 0.0;
+    float edge_offset = end_below != center_below ? 0.5 - closest / edge_length : 0.0;
+
+    float offset = max(edge_offset, subpixel);
+    vec2 blend_uv = uv;
+    if (is_horizontal)
+    {
+        blend_uv.y += offset * step_length;
+    }
+    else
+    {
+        blend_uv.x += offset * step_length;
+    }
+    output_color = vec4(textureLod(source, blend_uv, 0.0).rgb, 1.0);
+}
@@ -0,0 +1,17 @@
+#version 330 core
+
+// Log luminance of the HDR scene into a small texture. Its mip chain, built with
+// glGenerateMipmap, averages it down to one texel: the log of the geometric mean.
+
+in vec2 uv;
+
+uniform sampler2D hdr_color;
+
+out float output_log_luminance;
+
+void main()
+{
+    vec3 color = texture(hdr_color, uv).rgb;
+    float luminance = dot(color, vec3(0.2126, 0.7152, 0.0722));
+    output_log_luminance = log(luminance + 1e-4);
+}
@@ -0,0 +1,25 @@
+#version 330 core
+
+// Resolves weighted blended transparency, see Transparency.hpp. Blended over the scene with
+// GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA: the weighted average colour covers one minus the
+// revealage of the scene behind it.
+
+in vec2 uv;
+
+uniform sampler2D accumulation; // rgb sum of weighted premultiplied colour, a revealage
+uniform sampler2D weights;      // r sum of weighted coverage
+
+out vec4 output_color;
+
+void main()
+{
+    vec4 accumulated = texture(accumulation, uv);
+    float revealage = accumulated.a;
+    if (revealage >= 1.0)
+    {
+        discard; // nothing transparent in front of this pixel
+    }
+
+    vec3 average_color = accumulated.rgb / max(texture(weights, uv).r, 1e-5);
+    output_color = vec4(average_color, 1.0 - revealage);
+}
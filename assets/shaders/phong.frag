@@ -3,19 +3,84 @@
 in vec3 fragment_position;
 in vec2 texture_coordinates;
 in vec3 normal_vector;
+flat in uint texture_layer;
+flat in uint eclipse_mask; // bits of the occluders below that can shadow this body
 
-uniform vec3 camera_position;
-uniform sampler2D texture_sampler;
+layout (std140) uniform FrameData
+{
+    mat4 view_matrix;
+    mat4 projection_matrix;
+    vec4 camera_position; // w unused
+};
+
+// spheres that can shadow lit bodies this frame, see EclipseShadows
+layout (std140) uniform Eclipses
+{
+    vec4 sun;             // xyz centre, w radius
+    uvec4 eclipse_info;   // x = occluder count
+    vec4 occluders[16];   // xyz centre, w radius
+};
+
+uniform sampler2DArray texture_sampler; // one layer per body, see MaterialLibrary
+
+// Material variants, compiled in for the feature bits of MaterialLibrary::Material:
+// SPECULAR_MASK  the colour alpha scales the highlight (oceans shine, land does not)
+// NIGHT_LIGHTS   the layer after the colour holds city lights, shown where the sun does not reach
+const float NIGHT_LIGHTS_INTENSITY = 0.5;
 
 out vec4 output_color;
 
+const float PI = 3.14159265358979;
+
+// Fraction of the sun's disk hidden by the occluder, both seen from the fragment as disks of
+// their angular radius. Overlapping disks cover the area of the lens between them.
+float sun_coverage(vec4 occluder)
+{
+    vec3 to_sun = sun.xyz - fragment_position;
+    vec3 to_occluder = occluder.xyz - fragment_position;
+    float sun_distance = length(to_sun);
+    float occluder_distance = length(to_occluder);
+    if (occluder_distance >= sun_distance || occluder_distance <= occluder.w)
+    {
+        return 0.0;
+    }
+
+    float r1 = asin(min(sun.w / sun_distance, 1.0));
+    float r2 = asin(occluder.w / occluder_distance);
+    float d = atan(length(cross(to_sun, to_occluder)), dot(to_sun, to_occluder));
+
+    if (d >= r1 + r2)
+    {
+        return 0.0;
+    }
+    if (d <= abs(r1 - r2))
+    {
+        return min(r2 * r2 / (r1 * r1), 1.0); // total or annular
+    }
+
+    float a = r1 * r1 * acos(clamp((d * d + r1 * r1 - r2 * r2) / (2.0 * d * r1), -1.0, 1.0));
+    float b = r2 * r2 * acos(clamp((d * d + r2 * r2 - r1 * r1) / (2.0 * d * r2), -1.0, 1.0));
+    float c = 0.5 * sqrt(max((-d + r1 + r2) * (d + r1 - r2) * (d - r1 + r2) * (d + r1 + r2), 0.0));
+    return clamp((a + b - c) / (PI * r1 * r1), 0.0, 1.0);
+}
+
 void main()
 {
     // base color
-    vec4 texture_color = texture(texture_sampler, texture_coordinates);
+    vec4 texture_color = texture(texture_sampler, vec3(texture_coordinates, float(texture_layer)));
 
     vec3 unit_normal = normalize(normal_vector);
-    vec3 light_direction = normalize(-fragment_position);
+    vec3 light_direction = normalize(sun.xyz - fragment_position);
+
+    // sunlight left after every occluder of this body took its share of the sun's disk
+    float sunlight = 1.0;
+    for (uint i = 0u; i < eclipse_info.x; ++i)
+    {
+        if ((eclipse_mask & (1u << i)) != 0u)
+        {
+            sunlight *= 1.0 - sun_coverage(occluders[i]);
+        }
+    }
 
     // ambient lighting strength
     float ambient_strength = 0.01;
@@ -24,17 +89,33 @@ void main()
     float diffuse_intensity = max(dot(light_direction, unit_normal), 0.0);
 
     // specular lighting
+#ifdef SPECULAR_MASK
+    float specular_strength = texture_color.a;
+#else
     float specular_strength = 0.5;
-    vec3 view_direction = normalize(camera_position - fragment_position);
+#endif
+    vec3 view_direction = normalize(camera_position.xyz - fragment_position);
     vec3 reflection_direction = reflect(-light_direction, unit_normal);
     float specular_intensity = pow(max(dot(view_direction, reflection_direction), 0.0), 8);
 
     // combine
-    float lighting = ambient_strength + diffuse_intensity + specular_strength * specular_intensity;
+    float lighting = ambient_strength + sunlight * (diffuse_intensity + specular_strength * specular_intensity);
 
     // apply to the texture
     vec3 final_color = texture_color.rgb * lighting;
 
-    // final colour output
+#ifdef NIGHT_LIGHTS
+    // fade in across the terminator, and in the umbra of an eclipse
+    float daylight = sunlight * dot(light_direction, unit_normal);
+    float night = 1.0 - smoothstep(-0.05, 0.2, daylight);
+    vec3 night_color = texture(texture_sampler, vec3(texture_coordinates, float(texture_layer + 1u))).rgb;
+    final_color += night_color * night * NIGHT_LIGHTS_INTENSITY;
+#endif
+
+    // final colour output, the alpha of a masked texture is not coverage
+#ifdef SPECULAR_MASK
+    output_color = vec4(final_color, 1.0);
+#else
     output_color = vec4(final_color, texture_color.a);
+#endif
 }
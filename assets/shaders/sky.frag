@@ -0,0 +1,15 @@
+#version 330 core
+
+// The star background, looked up by direction in a cubemap, see Skybox.hpp.
+
+in vec3 view_direction;
+
+uniform samplerCube sky;
+uniform float intensity;
+
+out vec4 output_color;
+
+void main()
+{
+    output_color = vec4(texture(sky, normalize(view_direction)).rgb * intensity, 1.0);
+}
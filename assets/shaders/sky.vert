@@ -0,0 +1,26 @@
+#version 330 core
+
+// One triangle on the far plane covering the whole viewport, see fullscreen.vert. Each corner
+// carries the world space direction through it, which interpolates linearly across the screen.
+
+// per frame data, see UniformBlocks.hpp
+layout (std140) uniform FrameData
+{
+    mat4 view_matrix;
+    mat4 projection_matrix;
+    vec4 camera_position; // w unused
+};
+
+out vec3 view_direction;
+
+void main()
+{
+    vec2 position = vec2(float((gl_VertexID << 1) & 2), float(gl_VertexID & 2)) * 2.0 - 1.0;
+
+    // z = w puts it at depth 1, where the clear left every pixel no body covers
+    gl_Position = vec4(position, 1.0, 1.0);
+
+    vec4 view_position = inverse(projection_matrix) * vec4(position, 1.0, 1.0);
+    // the view matrix is a rotation and a translation, so the transpose undoes the rotation
+    view_direction = transpose(mat3(view_matrix)) * (view_position.xyz / view_position.w);
+}
@@ -0,0 +1,74 @@
+#version 330 core
+
+// Attribute-less version of test.vert for spheres.
+// Rebuilds the same triangle list as ShapeGenerator::Sphere from gl_VertexID,
+// so only the per-instance attributes need to be bound. Draw with
+// glDrawArraysInstanced(GL_TRIANGLES, 0, sphere_slices * sphere_stacks * 6, instances).
+
+// per instance, see InstanceBuffer.h. The sphere radius is folded into the model matrix.
+layout (location = 3) in mat4 instance_model_matrix;
+layout (location = 7) in uvec4 instance_material; // material index, texture layer, eclipse occluder mask, emission bits
+
+// tessellation level, shared by every instance of a draw
+uniform int sphere_slices;
+uniform int sphere_stacks;
+
+// per frame data, see UniformBlocks.hpp
+layout (std140) uniform FrameData
+{
+    mat4 view_matrix;
+    mat4 projection_matrix;
+    vec4 camera_position; // w unused
+};
+
+out vec3 fragment_position;
+out vec2 texture_coordinates;
+out vec3 normal_vector;
+flat out uint texture_layer;
+flat out uint eclipse_mask;
+flat out float emission;
+
+const float PI = 3.14159265358979;
+
+// (slice, stack) offset of each vertex in a quad - winding 1-2-3 then 1-3-4
+const ivec2 quad_corners[6] = ivec2[6](
+    ivec2(0, 0), ivec2(1, 0), ivec2(1, 1),
+    ivec2(0, 0), ivec2(1, 1), ivec2(0, 1)
+);
+
+void main()
+{
+    mat4 model_matrix = instance_model_matrix;
+    texture_layer = instance_material.y;
+    eclipse_mask = instance_material.z;
+    emission = uintBitsToFloat(instance_material.w);
+
+    int quad_index = gl_VertexID / 6;
+    ivec2 corner = quad_corners[gl_VertexID % 6];
+
+    int slice_index = quad_index % sphere_slices + corner.x;
+    int stack_index = quad_index / sphere_slices + corner.y;
+
+    // spherical projection (u = theta/2pi, v = phi/pi)
+    vec2 uv = vec2(float(slice_index) / float(sphere_slices), float(stack_index) / float(sphere_stacks));
+    float theta = uv.x * 2.0 * PI;
+    float phi = uv.y * PI;
+
+    vec3 unit_position = vec3(
+        -cos(theta) * sin(phi),
+        -cos(phi),
+        sin(theta) * sin(phi)
+    );
+
+    // transform to world space
+    vec4 model_pos = model_matrix * vec4(unit_position, 1.0);
+    fragment_position = vec3(model_pos);
+
+    texture_coordinates = uv;
+
+    // on a sphere the normal is just the direction from the centre
+    normal_vector = vec3(model_matrix * vec4(unit_position, 0.0));
+
+    // final position
+    gl_Position = projection_matrix * view_matrix * model_pos;
+}
@@ -0,0 +1,87 @@
+#version 330 core
+
+// Temporal anti-aliasing resolve. Every frame is drawn with a different sub-pixel jitter and
+// blended into the history of the previous frames. Where the pixel was last frame is found from
+// the scene depth. The depth and uv belong to the jittered render, so the jitter is taken out of the
+// position first; the reprojection matrix then takes this frame's unjittered clip space to the
+// previous frame's. The history sample is clipped to the colour box of the current 3x3
+// neighbourhood in YCoCg, so what moved or was uncovered falls back to the current frame instead
+// of smearing. Blending weights by 1 / (1 + luma) keep single bright samples from flickering.
+
+in vec2 uv;
+
+uniform sampler2D current;
+uniform sampler2D depth;
+uniform sampler2D history;
+uniform vec2 texel_size;
+uniform mat4 reprojection;
+uniform vec2 jitter;    // this frame's offset in normalized device coordinates
+uniform float feedback; // share of the history, 0 without one
+
+out vec4 output_color;
+
+vec3 to_ycocg(vec3 color)
+{
+    return vec3(
+        dot(color, vec3(0.25, 0.5, 0.25)),
+        dot(color, vec3(0.5, 0.0, -0.5)),
+        dot(color, vec3(-0.25, 0.5, -0.25))
+    );
+}
+
+vec3 from_ycocg(vec3 color)
+{
+    return vec3(color.x + color.y - color.z, color.x + color.z, color.x - color.y - color.z);
+}
+
+// moves history towards the center of the box until it is inside, which keeps its hue better than a clamp
+vec3 clip_to_box(vec3 history_color, vec3 box_min, vec3 box_max)
+{
+    vec3 center = 0.5 * (box_max + box_min);
+    vec3 extent = max(0.5 * (box_max - box_min), vec3(1e-5));
+    vec3 offset = history_color - center;
+    vec3 units = abs(offset / extent);
+    float largest = max(units.x, max(units.y, units.z));
+    return largest > 1.0 ? center + offset / largest : history_color;
+}
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    vec3 current_color = texelFetch(current, pixel, 0).rgb;
+    if (feedback <= 0.0)
+    {
+        output_color = vec4(current_color, 1.0);
+        return;
+    }
+
+    // neighbourhood statistics of the current frame
+    vec3 box_min = to_ycocg(current_color);
+    vec3 box_max = box_min;
+    for (int y = -1; y <= 1; ++y)
+    {
+        for (int x = -1; x <= 1; ++x)
+        {
+            vec3 neighbour = to_ycocg(texture(current, uv + vec2(x, y) * texel_size).rgb);
+            box_min = min(box_min, neighbour);
+            box_max = max(box_max, neighbour);
+        }
+    }
+
+    vec2 position = uv * 2.0 - 1.0 - jitter;
+    vec4 previous_clip = reprojection * vec4(position, texelFetch(depth, pixel, 0).r * 2.0 - 1.0, 1.0);
+    vec2 previous_uv = previous_clip.xy / previous_clip.w * 0.5 + 0.5;
+    if (previous_clip.w <= 0.0 || any(lessThan(previous_uv, vec2(0.0))) || any(greaterThan(previous_uv, vec2(1.0))))
+    {
+        output_color = vec4(current_color, 1.0);
+        return;
+    }
+
+    vec3 history_color = texture(history, previous_uv).rgb;
+    history_color = from_ycocg(clip_to_box(to_ycocg(history_color), box_min, box_max));
+
+    float current_weight = (1.0 - feedback) / (1.0 + dot(current_color, vec3(0.299, 0.587, 0.114)));
+    float history_weight = feedback / (1.0 + dot(history_color, vec3(0.299, 0.587, 0.114)));
+    vec3 color = (current_color * current_weight + history_color * history_weight) / (current_weight + history_weight);
+    output_color = vec4(max(color, vec3(0.0)), 1.0);
+}
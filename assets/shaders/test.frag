@@ -3,12 +3,15 @@
 in vec3 fragment_position;
 in vec2 texture_coordinates;
 in vec3 normal_vector;
+flat in uint texture_layer;
+flat in float emission; // HDR scale of the texture, above one the body glows
 
-uniform sampler2D texture_sampler;
+uniform sampler2DArray texture_sampler; // one layer per body, see MaterialLibrary
 
 out vec4 output_color;
 
 void main()
 {
-    output_color = texture(texture_sampler, texture_coordinates);
+    vec4 texture_color = texture(texture_sampler, vec3(texture_coordinates, float(texture_layer)));
+    output_color = vec4(texture_color.rgb * emission, texture_color.a);
 }
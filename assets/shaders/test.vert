@@ -4,16 +4,32 @@ layout (location = 0) in vec3 vertex_position;
 layout (location = 1) in vec2 vertex_texture_coordinates;
 layout (location = 2) in vec3 vertex_normal;
 
-uniform mat4 model_matrix;
-uniform mat4 view_matrix;
-uniform mat4 projection_matrix;
+// per instance, see InstanceBuffer.h
+layout (location = 3) in mat4 instance_model_matrix;
+layout (location = 7) in uvec4 instance_material; // material index, texture layer, eclipse occluder mask, emission bits
+
+// per frame data, see UniformBlocks.hpp
+layout (std140) uniform FrameData
+{
+    mat4 view_matrix;
+    mat4 projection_matrix;
+    vec4 camera_position; // w unused
+};
 
 out vec3 fragment_position;
 out vec2 texture_coordinates;
 out vec3 normal_vector;
+flat out uint texture_layer;
+flat out uint eclipse_mask;
+flat out float emission;
 
 void main()
 {
+    mat4 model_matrix = instance_model_matrix;
+    texture_layer = instance_material.y;
+    eclipse_mask = instance_material.z;
+    emission = uintBitsToFloat(instance_material.w);
+
     // transform to world space
     vec4 model_pos = model_matrix * vec4(vertex_position, 1.0);
     fragment_position = vec3(model_pos); 
@@ -0,0 +1,37 @@
+#version 330 core
+
+// Resolves the HDR scene into the sRGB backbuffer: bloom is mixed in, the exposure comes from
+// the adapted luminance and the ACES fit maps the result to [0, 1]. The sRGB encoding itself
+// is done by GL_FRAMEBUFFER_SRGB.
+
+in vec2 uv;
+
+uniform sampler2D hdr_color;
+uniform sampler2D bloom;
+uniform sampler2D adapted_luminance;
+
+uniform float bloom_strength;
+uniform vec4 bloom_rect;        // xy = offset, zw = size of this image in the bloom texture's uv
+uniform vec4 exposure_settings; // x = key, y = min exposure, z = max exposure, w = manual exposure (0 = auto)
+
+out vec4 output_color;
+
+// Krzysztof Narkowicz's fit of the ACES filmic curve
+vec3 aces(vec3 x)
+{
+    return clamp((x * (2.51 * x + 0.03)) / (x * (2.43 * x + 0.59) + 0.14), 0.0, 1.0);
+}
+
+void main()
+{
+    vec3 color = mix(texture(hdr_color, uv).rgb, texture(bloom, bloom_rect.xy + uv * bloom_rect.zw).rgb, bloom_strength);
+
+    float exposure = exposure_settings.w;
+    if (exposure <= 0.0)
+    {
+        float average_luminance = exp(texelFetch(adapted_luminance, ivec2(0), 0).r);
+        exposure = clamp(exposure_settings.x / average_luminance, exposure_settings.y, exposure_settings.z);
+    }
+
+    output_color = vec4(aces(color * exposure), 1.0);
+}
@@ -0,0 +1,53 @@
+#version 330 core
+
+// Transparent bodies (cloud layers) for weighted blended order independent transparency, see
+// Transparency.hpp. Lit by the sun without specular or eclipses.
+
+in vec3 fragment_position;
+in vec2 texture_coordinates;
+in vec3 normal_vector;
+flat in uint texture_layer;
+
+layout (std140) uniform FrameData
+{
+    mat4 view_matrix;
+    mat4 projection_matrix;
+    vec4 camera_position; // w unused
+};
+
+// only the sun is used here, see EclipseShadows
+layout (std140) uniform Eclipses
+{
+    vec4 sun;             // xyz centre, w radius
+    uvec4 eclipse_info;   // x = occluder count
+    vec4 occluders[16];   // xyz centre, w radius
+};
+
+uniform sampler2DArray texture_sampler; // one layer per body, see MaterialLibrary
+
+layout (location = 0) out vec4 accumulation; // rgb weighted premultiplied colour, a coverage (multiplied into the revealage)
+layout (location = 1) out vec4 weight_sum;   // r weighted coverage, divides the colour sum back to unpremultiplied
+
+void main()
+{
+    // the textures have no alpha channel, they are white layers premultiplied over black, so the
+    // brightest channel is the coverage
+    vec3 texture_color = texture(texture_sampler, vec3(texture_coordinates, float(texture_layer))).rgb;
+    float alpha = clamp(max(texture_color.r, max(texture_color.g, texture_color.b)), 0.0, 1.0);
+    if (alpha < 1.0 / 255.0)
+    {
+        discard;
+    }
+
+    vec3 unit_normal = normalize(normal_vector);
+    vec3 light_direction = normalize(sun.xyz - fragment_position);
+    float lighting = 0.01 + max(dot(light_direction, unit_normal), 0.0);
+    vec3 premultiplied = texture_color * lighting;
+
+    // equation 9 of the paper: nearer surfaces dominate, tuned for view distances of roughly 1 to 200
+    float view_depth = -(view_matrix * vec4(fragment_position, 1.0)).z;
+    float weight = alpha * clamp(10.0 / (1e-5 + pow(view_depth / 5.0, 2.0) + pow(view_depth / 200.0, 6.0)), 1e-2, 3e3);
+
+    accumulation = vec4(premultiplied * weight, alpha);
+    weight_sum = vec4(alpha * weight);
+}
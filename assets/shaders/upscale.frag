@@ -0,0 +1,35 @@
+#version 330 core
+
+// Stretches the tonemapped image, rendered at a fraction of the window resolution, over the
+// whole backbuffer. Bilinear filtering softens it, so the result is sharpened with a
+// contrast adaptive filter: a negative lobe on the four neighbours whose weight shrinks where
+// the local contrast is already high, which keeps edges from ringing.
+
+in vec2 uv;
+
+uniform sampler2D source;
+uniform vec2 source_texel_size;
+uniform float sharpness; // 0 to 1
+
+out vec4 output_color;
+
+void main()
+{
+    vec3 center = texture(source, uv).rgb;
+    vec3 north = texture(source, uv + vec2(0.0, source_texel_size.y)).rgb;
+    vec3 south = texture(source, uv - vec2(0.0, source_texel_size.y)).rgb;
+    vec3 east = texture(source, uv + vec2(source_texel_size.x, 0.0)).rgb;
+    vec3 west = texture(source, uv - vec2(source_texel_size.x, 0.0)).rgb;
+
+    vec3 lowest = min(center, min(min(north, south), min(east, west)));
+    vec3 highest = max(center, max(max(north, south), max(east, west)));
+
+    // how far the neighbourhood is from clipping at either end, per channel
+    vec3 headroom = clamp(min(lowest, 1.0 - highest) / max(highest, 1e-4), 0.0, 1.0);
+    vec3 amount = sqrt(headroom);
+
+    vec3 weight = amount * (-1.0 / mix(8.0, 5.0, clamp(sharpness, 0.0, 1.0)));
+    vec3 color = ((north + south + east + west) * weight + center) / (1.0 + 4.0 * weight);
+
+    output_color = vec4(clamp(color, 0.0, 1.0), 1.0);
+}
@@ -0,0 +1,242 @@
+#include "AntiAliasing.hpp"
+
+#include "AssetPath.h"
+#include "Log.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+
+namespace
+{
+    // radical inverse of index in base, the Halton sequence
+    float Halton(uint32_t index, uint32_t const base)
+    {
+        float result = 0.0f;
+        float fraction = 1.0f;
+        while (index > 0)
+        {
+            fraction /= static_cast<float>(base);
+            result += fraction * static_cast<float>(index % base);
+            index /= base;
+        }
+        return result;
+    }
+}
+
+//======================================================================================================================
+
+AntiAliasing::AntiAliasing()
+{
+    auto const path = AssetPath::Instance();
+    auto const fullscreen = path->Get("shaders/fullscreen.vert");
+
+    mFxaaShader = std::make_unique<ShaderProgram>(fullscreen, path->Get("shaders/fxaa.frag"));
+    mFxaaSource = mFxaaShader->uniform("source");
+    mFxaaTexelSize = mFxaaShader->uniform("source_texel_size");
+    mFxaaSettings = mFxaaShader->uniform("settings");
+
+    mTaaShader = std::make_unique<ShaderProgram>(fullscreen, path->Get("shaders/taa_resolve.frag"));
+    mTaaCurrent = mTaaShader->uniform("current");
+    mTaaDepth = mTaaShader->uniform("depth");
+    mTaaHistory = mTaaShader->uniform("history");
+    mTaaTexelSize = mTaaShader->uniform("texel_size");
+    mTaaReprojection = mTaaShader->uniform("reprojection");
+    mTaaJitter = mTaaShader->uniform("jitter");
+    mTaaFeedback = mTaaShader->uniform("feedback");
+
+    // the passes bind their inputs to these units every frame
+    mFxaaShader->use();
+    mFxaaShader->set(mFxaaSource, 0);
+    mTaaShader->use();
+    mTaaShader->set(mTaaCurrent, 0);
+    mTaaShader->set(mTaaDepth, 1);
+    mTaaShader->set(mTaaHistory, 2);
+    glUseProgram(0);
+
+    int max_color_samples = 0;
+    int max_depth_samples = 0;
+    glGetIntegerv(GL_MAX_COLOR_TEXTURE_SAMPLES, &max_color_samples);
+    glGetIntegerv(GL_MAX_DEPTH_TEXTURE_SAMPLES, &max_depth_samples);
+    mStats.maxSamples = std::max(std::min(max_color_samples, max_depth_samples), 1);
+    Log::info("MSAA Samples: up to {0}", mStats.maxSamples);
+}
+
+//======================================================================================================================
+
+int AntiAliasing::GetSceneSamples() const
+{
+    if (mSettings.mode != Mode::Msaa)
+    {
+        return 1;
+    }
+    return std::clamp(mSettings.msaaSamples, 1, mStats.maxSamples);
+}
+
+//======================================================================================================================
+
+glm::mat4 AntiAliasing::Jitter(glm::mat4 const & projection, glm::mat4 const & view, glm::ivec2 const sceneSize)
+{
+    mViewProjection = projection * view;
+    mJitter = glm::vec2(0.0f);
+    if (mSettings.mode != Mode::Taa)
+    {
+        return projection;
+    }
+
+    // pixel offsets in [-0.5, 0.5), moved in normalized device coordinates after the projection
+    uint32_t const phase = mFrameIndex % JitterPhases + 1;
+    glm::vec2 const offset = glm::vec2(Halton(phase, 2), Halton(phase, 3)) - 0.5f;
+    mJitter = 2.0f * offset / glm::vec2(glm::max(sceneSize, glm::ivec2(1)));
+    return glm::translate(glm::mat4(1.0f), glm::vec3(mJitter, 0.0f)) * projection;
+}
+
+//======================================================================================================================
+
+void AntiAliasing::AddPasses(
+    FrameGraph & graph,
+    FrameGraph::ResourceId const hdrColor,
+    FrameGraph::ResourceId const sceneDepth,
+    float const renderScale,
+    FrameGraph::ResourceId & output
+)
+{
+    mPassNames.clear();
+    output = hdrColor;
+    if (mSettings.mode != Mode::Fxaa && mSettings.mode != Mode::Taa)
+    {
+        mHistoryValid = false;
+        return;
+    }
+
+    FrameGraph::TextureDesc desc {};
+    desc.format = GL_RGBA16F;
+    desc.scale = renderScale;
+    output = graph.Create("antialiased_color", desc);
+    if (mSettings.mode == Mode::Fxaa)
+    {
+        mHistoryValid = false;
+        AddFxaaPass(graph, hdrColor, output);
+    }
+    else
+    {
+        AddTaaPasses(graph, hdrColor, sceneDepth, output);
+    }
+}
+
+//======================================================================================================================
+
+void AntiAliasing::AddFxaaPass(FrameGraph & graph, FrameGraph::ResourceId const hdrColor, FrameGraph::ResourceId const output)
+{
+    mPassNames.emplace_back("fxaa");
+    graph.AddPass(
+        mPassNames.back(),
+        [hdrColor, output](FrameGraph::Builder & builder)->void {
+            builder.Read(hdrColor);
+            builder.Write(output);
+        },
+        [this, hdrColor](FrameGraph const & frameGraph)->void {
+            mFxaaShader->use();
+            mFxaaShader->set(mFxaaTexelSize, 1.0f / glm::vec2(frameGraph.GetSize(hdrColor)));
+            mFxaaShader->set(mFxaaSettings, glm::vec2(mSettings.fxaaEdgeThreshold, mSettings.fxaaSubpixel));
+            frameGraph.BindTexture(hdrColor, 0);
+            glDisable(GL_DEPTH_TEST);
+            frameGraph.DrawFullscreen();
+        }
+    );
+}
+
+//======================================================================================================================
+
+// The resolve reads last frame's history and writes into a transient target, which is then copied over the history
+// for the next frame. The history is sized on that copy, so a change of resolution drops it for one frame.
+void AntiAliasing::AddTaaPasses(
+    FrameGraph & graph,
+    FrameGraph::ResourceId const hdrColor,
+    FrameGraph::ResourceId const sceneDepth,
+    FrameGraph::ResourceId const output
+)
+{
+    mFrameIndex += 1;
+
+    FrameGraph::ResourceId history {};
+    if (mHistoryValid)
+    {
+        FrameGraph::TextureDesc history_desc {};
+        history_desc.format = GL_RGBA16F;
+        history_desc.size = mHistorySize;
+        history = graph.Import("taa_history", mHistory, history_desc);
+    }
+
+    mPassNames.emplace_back("taa_resolve");
+    graph.AddPass(
+        mPassNames.back(),
+        [this, hdrColor, sceneDepth, history, output](FrameGraph::Builder & builder)->void {
+            builder.Read(hdrColor);
+            builder.Read(sceneDepth);
+            if (mHistoryValid)
+            {
+                builder.Read(history);
+            }
+            builder.Write(output);
+        },
+        [this, hdrColor, sceneDepth, history](FrameGraph const & frameGraph)->void {
+            glm::ivec2 const size = frameGraph.GetSize(hdrColor);
+            bool const use_history = mHistoryValid && size == mHistorySize;
+            mTaaShader->use();
+            mTaaShader->set(mTaaTexelSize, 1.0f / glm::vec2(size));
+            mTaaShader->set(mTaaReprojection, mPreviousViewProjection * glm::inverse(mViewProjection));
+            mTaaShader->set(mTaaJitter, mJitter);
+            mTaaShader->set(mTaaFeedback, use_history ? mSettings.taaFeedback : 0.0f);
+            frameGraph.BindTexture(hdrColor, 0);
+            frameGraph.BindTexture(sceneDepth, 1);
+            if (use_history)
+            {
+                frameGraph.BindTexture(history, 2);
+            }
+            glDisable(GL_DEPTH_TEST);
+            frameGraph.DrawFullscreen();
+        }
+    );
+
+    // only the next frame reads the history, so nothing this frame keeps the pass from being culled
+    FrameGraph::PassOptions options {};
+    options.sideEffects = true;
+    mPassNames.emplace_back("taa_history");
+    graph.AddPass(
+        mPassNames.back(),
+        [output](FrameGraph::Builder & builder)->void {
+            builder.Read(output);
+        },
+        [this, output](FrameGraph const & frameGraph)->void {
+            frameGraph.CopyToTexture(output, mHistory, mHistorySize);
+            mPreviousViewProjection = mViewProjection;
+            mHistoryValid = true;
+        },
+        options
+    );
+}
+
+//======================================================================================================================
+
+void AntiAliasing::ResetHistory()
+{
+    mHistoryValid = false;
+}
+
+//======================================================================================================================
+
+void AntiAliasing::UpdateStats(FrameGraph const & graph)
+{
+    mStats.passMs = 0.0f;
+    for (auto const & name : mPassNames)
+    {
+        mStats.passMs += graph.GetPassTime(name);
+    }
+
+    float & frame_ms = mStats.frameMs[static_cast<int>(mSettings.mode)];
+    float const total_ms = graph.GetTotalTime();
+    frame_ms = frame_ms > 0.0f ? frame_ms + (total_ms - frame_ms) * StatsSmoothing : total_ms;
+}
+
+//======================================================================================================================
@@ -0,0 +1,132 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// The anti-aliasing of the scene, selectable at runtime:
+//  - MSAA renders the scene targets with several samples, resolved before
+//    transparency. Cost grows with the sample count in memory and bandwidth.
+//  - FXAA (Lottes 2009) is one full-screen pass over the resolved scene that
+//    finds luma edges, walks along them and blends across. It runs on the HDR
+//    scene with colours compressed by 1 / (1 + luma) so bright bodies do not
+//    dominate the edge search.
+//  - TAA jitters the projection by a Halton (2, 3) sub-pixel offset every
+//    frame and blends each frame into a history. The history is reprojected
+//    from the scene depth with the previous frame's view projection and
+//    clipped to the neighbourhood of the current pixel, which keeps moving
+//    bodies from ghosting.
+// Either post-process mode renders the scene with a single sample. The GPU
+// time of every mode is averaged while it is active, so modes can be
+// compared on the machine at hand.
+//------------------------------------------------------------------------------
+
+#include "FrameGraph.hpp"
+#include "GLHandles.h"
+#include "ShaderProgram.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+class AntiAliasing
+{
+public:
+
+    enum class Mode
+    {
+        Off,
+        Msaa,
+        Fxaa,
+        Taa
+    };
+    static constexpr int ModeCount = 4;
+
+    // for ImGui::Combo, in the order of Mode
+    static constexpr char const * ModeNames = "Off\0MSAA\0FXAA\0TAA\0";
+
+    struct Settings
+    {
+        Mode mode = Mode::Msaa;
+        int msaaSamples = 8;            // clamped to what the driver offers
+        float fxaaEdgeThreshold = 0.125f;   // minimum local contrast, relative to the brightest neighbour
+        float fxaaSubpixel = 0.75f;     // how much single pixel detail is softened, 0 to 1
+        float taaFeedback = 0.9f;       // share of the history in every resolved pixel
+    };
+
+    struct Stats
+    {
+        float passMs = 0.0f;            // this frame's own passes, the cost of MSAA is in the scene passes instead
+        float frameMs[ModeCount] {};    // average GPU frame time while each mode was active, 0 if it never was
+        int maxSamples = 1;
+    };
+
+    explicit AntiAliasing();
+
+    // Samples of the scene targets this frame, one unless the mode is MSAA
+    [[nodiscard]]
+    int GetSceneSamples() const;
+
+    // The projection to draw the scene with. Under TAA it is moved by this frame's sub-pixel offset, which the
+    // resolve takes back out before reprojecting with the unjittered view projection.
+    [[nodiscard]]
+    glm::mat4 Jitter(glm::mat4 const & projection, glm::mat4 const & view, glm::ivec2 sceneSize);
+
+    // Adds the passes of the current mode. hdrColor is the single sample scene, output is where the next stage
+    // should read from (hdrColor itself when there is nothing to do).
+    void AddPasses(
+        FrameGraph & graph,
+        FrameGraph::ResourceId hdrColor,
+        FrameGraph::ResourceId sceneDepth,
+        float renderScale,
+        FrameGraph::ResourceId & output
+    );
+
+    // The next TAA frame starts without history, e.g. when the view jumps
+    void ResetHistory();
+
+    // Takes this frame's pass times into the stats of the current mode
+    void UpdateStats(FrameGraph const & graph);
+
+    [[nodiscard]]
+    Settings & GetSettings() { return mSettings; }
+
+    [[nodiscard]]
+    Stats const & GetStats() const { return mStats; }
+
+private:
+
+    static constexpr int JitterPhases = 8;
+    static constexpr float StatsSmoothing = 0.05f;
+
+    void AddFxaaPass(FrameGraph & graph, FrameGraph::ResourceId hdrColor, FrameGraph::ResourceId output);
+
+    void AddTaaPasses(FrameGraph & graph, FrameGraph::ResourceId hdrColor, FrameGraph::ResourceId sceneDepth, FrameGraph::ResourceId output);
+
+    Settings mSettings {};
+    Stats mStats {};
+    std::vector<std::string> mPassNames {};
+
+    // TAA state, the view projections are unjittered
+    uint32_t mFrameIndex = 0;
+    glm::vec2 mJitter {0.0f};       // this frame's offset in normalized device coordinates
+    glm::mat4 mViewProjection {1.0f};
+    glm::mat4 mPreviousViewProjection {1.0f};
+    bool mHistoryValid = false;
+    TextureHandle mHistory {};
+    glm::ivec2 mHistorySize {0, 0};
+
+    std::unique_ptr<ShaderProgram> mFxaaShader {};
+    ShaderProgram::Uniform mFxaaSource {};
+    ShaderProgram::Uniform mFxaaTexelSize {};
+    ShaderProgram::Uniform mFxaaSettings {};
+
+    std::unique_ptr<ShaderProgram> mTaaShader {};
+    ShaderProgram::Uniform mTaaCurrent {};
+    ShaderProgram::Uniform mTaaDepth {};
+    ShaderProgram::Uniform mTaaHistory {};
+    ShaderProgram::Uniform mTaaTexelSize {};
+    ShaderProgram::Uniform mTaaReprojection {};
+    ShaderProgram::Uniform mTaaJitter {};
+    ShaderProgram::Uniform mTaaFeedback {};
+};
@@ -69,4 +69,14 @@ std::string AssetPath::Get(char const *address) const {
   return std::filesystem::path(mAssetPath).append(address).string();
 }
 
+//-------------------------------------------------------------------------------------------------
+
+std::filesystem::path AssetPath::CacheDirectory() {
+#if defined(CACHE_DIR)
+  return std::filesystem::absolute(std::string(TO_LITERAL(CACHE_DIR)));
+#else
+  return std::filesystem::absolute("cache");
+#endif
+}
+
 //-------------------------------------------------------------------------------------------------
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <filesystem>
 #include <memory>
 #include <string>
 
@@ -19,6 +20,11 @@ public:
   [[nodiscard]]
   std::string Get(char const *address) const;
 
+  // Where data built from the assets is cached between runs: cache/ in the build
+  // directory, or in the working directory when built without CMake
+  [[nodiscard]]
+  static std::filesystem::path CacheDirectory();
+
 private:
   inline static std::weak_ptr<AssetPath> _instance{};
   std::string mAssetPath{};
@@ -0,0 +1,377 @@
+#include "Atmosphere.hpp"
+
+#include "AssetPath.h"
+#include "CacheFile.hpp"
+#include "Log.h"
+
+#include <glm/gtc/constants.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <thread>
+
+namespace
+{
+    constexpr int TransmittanceSteps = 40;
+    constexpr int MultipleScatteringSteps = 20;
+    constexpr int MultipleScatteringDirections = 8; // squared, spread evenly over the sphere
+
+    // FNV-1a over the parameter block, which has no padding
+    uint64_t ParameterKey(UniformBlocks::AtmosphereData const & atmosphere)
+    {
+        uint64_t hash = 14695981039346656037ull;
+        auto const * bytes = reinterpret_cast<uint8_t const *>(&atmosphere);
+        for (size_t index = 0; index < sizeof(atmosphere); ++index)
+        {
+            hash = (hash ^ bytes[index]) * 1099511628211ull;
+        }
+        return hash;
+    }
+
+    // Runs rowFunction(row) for every row, rows interleaved over one worker per core
+    int ForEachRowParallel(int const rows, std::function<void(int)> const & rowFunction)
+    {
+        int const workers = std::clamp(static_cast<int>(std::thread::hardware_concurrency()), 1, rows);
+        std::atomic<int> next_row {0};
+        std::vector<std::thread> threads {};
+        for (int worker = 0; worker < workers; ++worker)
+        {
+            threads.emplace_back([&]()->void {
+                for (int row = next_row++; row < rows; row = next_row++)
+                {
+                    rowFunction(row);
+                }
+            });
+        }
+        for (auto & thread : threads)
+        {
+            thread.join();
+        }
+        return workers;
+    }
+
+    struct Medium
+    {
+        glm::vec3 scattering {};    // Rayleigh and Mie together
+        glm::vec3 extinction {};
+    };
+
+    Medium SampleMedium(UniformBlocks::AtmosphereData const & atmosphere, float const height)
+    {
+        glm::vec3 const rayleigh = glm::vec3(atmosphere.rayleighScattering) * std::exp(-height / atmosphere.rayleighScattering.w);
+        float const mie_density = std::exp(-height / atmosphere.mie.z);
+        float const ozone_density = std::max(0.0f, 1.0f - std::abs(height - atmosphere.ozoneAbsorption.w) / atmosphere.ozone.x);
+
+        Medium medium {};
+        medium.scattering = rayleigh + atmosphere.mie.x * mie_density;
+        medium.extinction = rayleigh + atmosphere.mie.y * mie_density + glm::vec3(atmosphere.ozoneAbsorption) * ozone_density;
+        return medium;
+    }
+
+    // Distance along the ray to the sphere of the given radius around the origin, negative when it misses.
+    // The far intersection unless near is set.
+    float RaySphere(glm::vec3 const & origin, glm::vec3 const & direction, float const radius, bool const near)
+    {
+        float const b = glm::dot(origin, direction);
+        float const c = glm::dot(origin, origin) - radius * radius;
+        float const discriminant = b * b - c;
+        if (discriminant < 0.0f)
+        {
+            return -1.0f;
+        }
+        return near ? -b - std::sqrt(discriminant) : -b + std::sqrt(discriminant);
+    }
+
+    // Bruneton's mapping between (radius, cosine of the view zenith angle) and texture coordinates, the distance to
+    // the top of the atmosphere is spread linearly over u. Must match transmittance_uv() in atmosphere.frag.
+    glm::vec2 TransmittanceUv(UniformBlocks::AtmosphereData const & atmosphere, float const radius, float const mu)
+    {
+        float const ground = atmosphere.radii.x;
+        float const top = atmosphere.radii.y;
+        float const horizon = std::sqrt(top * top - ground * ground);
+        float const rho = std::sqrt(std::max(radius * radius - ground * ground, 0.0f));
+        float const discriminant = radius * radius * (mu * mu - 1.0f) + top * top;
+        float const distance = std::max(-radius * mu + std::sqrt(std::max(discriminant, 0.0f)), 0.0f);
+        float const min_distance = top - radius;
+        float const max_distance = rho + horizon;
+        return glm::vec2((distance - min_distance) / (max_distance - min_distance), rho / horizon);
+    }
+
+    void TransmittanceRadiusMu(UniformBlocks::AtmosphereData const & atmosphere, glm::vec2 const uv, float & radius, float & mu)
+    {
+        float const ground = atmosphere.radii.x;
+        float const top = atmosphere.radii.y;
+        float const horizon = std::sqrt(top * top - ground * ground);
+        float const rho = horizon * uv.y;
+        radius = std::sqrt(rho * rho + ground * ground);
+        float const min_distance = top - radius;
+        float const max_distance = rho + horizon;
+        float const distance = min_distance + uv.x * (max_distance - min_distance);
+        mu = distance == 0.0f ? 1.0f : (horizon * horizon - rho * rho - distance * distance) / (2.0f * radius * distance);
+        mu = std::clamp(mu, -1.0f, 1.0f);
+    }
+
+    // Bilinear, clamped to the edges like the GL sampler
+    glm::vec3 SampleTable(std::vector<glm::vec4> const & table, glm::ivec2 const size, glm::vec2 const uv)
+    {
+        glm::vec2 const position = glm::clamp(uv * glm::vec2(size) - 0.5f, glm::vec2(0.0f), glm::vec2(size - 1));
+        glm::ivec2 const base = glm::min(glm::ivec2(position), size - 2);
+        glm::vec2 const weight = position - glm::vec2(base);
+        auto const texel = [&](int const x, int const y)->glm::vec3 {
+            return glm::vec3(table[static_cast<size_t>(y) * size.x + x]);
+        };
+        return glm::mix(
+            glm::mix(texel(base.x, base.y), texel(base.x + 1, base.y), weight.x),
+            glm::mix(texel(base.x, base.y + 1), texel(base.x + 1, base.y + 1), weight.x),
+            weight.y
+        );
+    }
+}
+
+//======================================================================================================================
+
+Atmosphere::Atmosphere(Parameters const & parameters, std::filesystem::path const & cacheDirectory)
+{
+    auto const start = std::chrono::steady_clock::now();
+
+    UniformBlocks::AtmosphereData const atmosphere {
+        glm::vec4(parameters.groundRadius, parameters.topRadius, parameters.mieAsymmetry, parameters.groundAlbedo),
+        glm::vec4(parameters.rayleighScattering, parameters.rayleighScaleHeight),
+        glm::vec4(parameters.mieScattering, parameters.mieExtinction, parameters.mieScaleHeight, 0.0f),
+        glm::vec4(parameters.ozoneAbsorption, parameters.ozonePeakHeight),
+        glm::vec4(parameters.ozoneHalfWidth, 0.0f, 0.0f, 0.0f),
+    };
+    mTopRatio = parameters.topRadius / parameters.groundRadius;
+    mParameterBuffer.uploadData(sizeof(atmosphere), &atmosphere);
+    mParameterBuffer.bindBase();
+
+    auto const path = AssetPath::Instance();
+    mShader = std::make_unique<ShaderProgram>(path->Get("shaders/atmosphere.vert"), path->Get("shaders/atmosphere.frag"));
+    mGroundUniform = mShader->uniform("ground");
+    mProxyRadiusUniform = mShader->uniform("proxy_radius");
+    mSunIlluminanceUniform = mShader->uniform("sun_illuminance");
+    mShader->use();
+    mShader->set(mShader->uniform("transmittance_lut"), 0);
+    mShader->set(mShader->uniform("multiple_scattering_lut"), 1);
+    glUseProgram(0);
+
+    uint64_t const key = ParameterKey(atmosphere);
+    char name[32] {};
+    std::snprintf(name, sizeof(name), "atmosphere_%016llx.lut", static_cast<unsigned long long>(key));
+    std::filesystem::path const cache_path = cacheDirectory / name;
+    CacheFile::Header const header {
+        {'A', 'T', 'M', 'O'}, 2, key,
+        {
+            static_cast<uint32_t>(TransmittanceSize.x), static_cast<uint32_t>(TransmittanceSize.y),
+            static_cast<uint32_t>(MultipleScatteringSize.x), static_cast<uint32_t>(MultipleScatteringSize.y)
+        }
+    };
+    size_t const transmittance_bytes = sizeof(glm::vec4) * TransmittanceSize.x * TransmittanceSize.y;
+    size_t const scattering_bytes = sizeof(glm::vec4) * MultipleScatteringSize.x * MultipleScatteringSize.y;
+
+    // the tables are uploaded straight from the mapping, which is closed again before a stale file is overwritten
+    {
+        CacheFile const cache(cache_path, header, transmittance_bytes + scattering_bytes, "atmosphere");
+        mStats.fromCache = cache.IsValid();
+        if (mStats.fromCache)
+        {
+            UploadTable(mTransmittance, TransmittanceSize, cache.Payload());
+            UploadTable(mMultipleScattering, MultipleScatteringSize, cache.Payload() + transmittance_bytes);
+        }
+    }
+    if (mStats.fromCache == false)
+    {
+        int transmittance_workers = 0;
+        int scattering_workers = 0;
+        Table const transmittance = BuildTransmittance(atmosphere, transmittance_workers);
+        Table const multiple_scattering = BuildMultipleScattering(atmosphere, transmittance, scattering_workers);
+        mStats.workers = std::max(transmittance_workers, scattering_workers);
+
+        UploadTable(mTransmittance, TransmittanceSize, transmittance.data());
+        UploadTable(mMultipleScattering, MultipleScatteringSize, multiple_scattering.data());
+        CacheFile::Write(
+            cache_path, header,
+            {{transmittance.data(), transmittance_bytes}, {multiple_scattering.data(), scattering_bytes}},
+            "atmosphere"
+        );
+    }
+
+    std::chrono::duration<float, std::milli> const elapsed = std::chrono::steady_clock::now() - start;
+    mStats.loadMs = elapsed.count();
+    Log::info("Atmosphere lookup tables {} in {:.1f} ms", mStats.fromCache ? "mapped from cache" : "built", mStats.loadMs);
+}
+
+//======================================================================================================================
+
+void Atmosphere::Draw(BoundingSphere const & ground, MeshBuffer const & meshes, MeshBuffer::MeshId const mesh) const
+{
+    // the proxy's flat faces lie inside the sphere through its vertices, so it is made a little larger
+    float const proxy_radius = ground.radius * mTopRatio * 1.01f;
+
+    mShader->use();
+    mShader->set(mGroundUniform, glm::vec4(ground.center, ground.radius));
+    mShader->set(mProxyRadiusUniform, proxy_radius);
+    mShader->set(mSunIlluminanceUniform, mSettings.sunIlluminance);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, mTransmittance);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, mMultipleScattering);
+    glActiveTexture(GL_TEXTURE0);
+
+    // front faces only, tested against the scene so bodies in front hide it. The result is premultiplied:
+    // in-scattered light over the scene dimmed by the transmittance.
+    glEnable(GL_DEPTH_TEST);
+    glDepthFunc(GL_LESS);
+    glDepthMask(GL_FALSE);
+    glEnable(GL_CULL_FACE);
+    glCullFace(GL_BACK);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+    MeshBuffer::Mesh const & proxy = meshes.Get(mesh);
+    meshes.Bind();
+    glDrawElementsBaseVertex(GL_TRIANGLES, proxy.indexCount, GL_UNSIGNED_INT, proxy.IndexOffset(), proxy.baseVertex);
+
+    glDisable(GL_BLEND);
+    glDepthMask(GL_TRUE);
+}
+
+//======================================================================================================================
+
+// Optical depth from every texel's height and direction to the top of the atmosphere, midpoint rule
+Atmosphere::Table Atmosphere::BuildTransmittance(UniformBlocks::AtmosphereData const & atmosphere, int & workers)
+{
+    Table table(static_cast<size_t>(TransmittanceSize.x) * TransmittanceSize.y);
+    workers = ForEachRowParallel(TransmittanceSize.y, [&](int const row)->void {
+        for (int column = 0; column < TransmittanceSize.x; ++column)
+        {
+            glm::vec2 const uv = (glm::vec2(column, row) + 0.5f) / glm::vec2(TransmittanceSize);
+            float radius = 0.0f;
+            float mu = 0.0f;
+            TransmittanceRadiusMu(atmosphere, uv, radius, mu);
+
+            glm::vec3 const origin(0.0f, radius, 0.0f);
+            glm::vec3 const direction(std::sqrt(std::max(1.0f - mu * mu, 0.0f)), mu, 0.0f);
+            float const length = std::max(RaySphere(origin, direction, atmosphere.radii.y, false), 0.0f);
+            float const step = length / static_cast<float>(TransmittanceSteps);
+
+            glm::vec3 optical_depth {};
+            for (int sample = 0; sample < TransmittanceSteps; ++sample)
+            {
+                glm::vec3 const position = origin + direction * ((static_cast<float>(sample) + 0.5f) * step);
+                optical_depth += SampleMedium(atmosphere, glm::length(position) - atmosphere.radii.x).extinction * step;
+            }
+            table[static_cast<size_t>(row) * TransmittanceSize.x + column] = glm::vec4(glm::exp(-optical_depth), 1.0f);
+        }
+    });
+    return table;
+}
+
+//======================================================================================================================
+
+// Hillaire's multiple scattering approximation. From each texel's height, with the sun at the texel's zenith angle,
+// second order scattering L2 and the transfer factor fms are averaged over the sphere of directions, treating every
+// scattering event as isotropic. The infinite series of higher orders then sums to L2 / (1 - fms).
+// u is the cosine of the sun zenith angle mapped to [0, 1], v the height between the ground and the top.
+Atmosphere::Table Atmosphere::BuildMultipleScattering(
+    UniformBlocks::AtmosphereData const & atmosphere,
+    Table const & transmittance,
+    int & workers
+)
+{
+    float const ground = atmosphere.radii.x;
+    float const top = atmosphere.radii.y;
+    float const isotropic_phase = 1.0f / (4.0f * glm::pi<float>());
+    auto const sun_transmittance = [&](glm::vec3 const & position, glm::vec3 const & sun)->glm::vec3 {
+        float const radius = glm::length(position);
+        return SampleTable(transmittance, TransmittanceSize, TransmittanceUv(atmosphere, radius, glm::dot(position / radius, sun)));
+    };
+
+    Table table(static_cast<size_t>(MultipleScatteringSize.x) * MultipleScatteringSize.y);
+    workers = ForEachRowParallel(MultipleScatteringSize.y, [&](int const row)->void {
+        float const radius = ground + (static_cast<float>(row) + 0.5f) / static_cast<float>(MultipleScatteringSize.y) * (top - ground);
+        glm::vec3 const origin(0.0f, radius, 0.0f);
+
+        for (int column = 0; column < MultipleScatteringSize.x; ++column)
+        {
+            float const sun_mu = 2.0f * (static_cast<float>(column) + 0.5f) / static_cast<float>(MultipleScatteringSize.x) - 1.0f;
+            glm::vec3 const sun(std::sqrt(std::max(1.0f - sun_mu * sun_mu, 0.0f)), sun_mu, 0.0f);
+
+            glm::vec3 second_order {};
+            glm::vec3 transfer {};
+            for (int direction_index = 0; direction_index < MultipleScatteringDirections * MultipleScatteringDirections; ++direction_index)
+            {
+                // equal area: uniform in azimuth and in the cosine of the zenith angle
+                float const azimuth = glm::two_pi<float>() *
+                    (static_cast<float>(direction_index % MultipleScatteringDirections) + 0.5f) / MultipleScatteringDirections;
+                float const cos_zenith = 1.0f - 2.0f *
+                    (static_cast<float>(direction_index / MultipleScatteringDirections) + 0.5f) / MultipleScatteringDirections;
+                float const sin_zenith = std::sqrt(std::max(1.0f - cos_zenith * cos_zenith, 0.0f));
+                glm::vec3 const direction(sin_zenith * std::cos(azimuth), cos_zenith, sin_zenith * std::sin(azimuth));
+
+                float const ground_distance = RaySphere(origin, direction, ground, true);
+                bool const hits_ground = ground_distance > 0.0f;
+                float const length = hits_ground ? ground_distance : std::max(RaySphere(origin, direction, top, false), 0.0f);
+                float const step = length / static_cast<float>(MultipleScatteringSteps);
+
+                glm::vec3 throughput(1.0f);
+                glm::vec3 luminance {};
+                glm::vec3 scattered {};
+                for (int sample = 0; sample < MultipleScatteringSteps; ++sample)
+                {
+                    glm::vec3 const position = origin + direction * ((static_cast<float>(sample) + 0.5f) * step);
+                    Medium const medium = SampleMedium(atmosphere, glm::length(position) - ground);
+                    glm::vec3 const extinction = glm::max(medium.extinction, glm::vec3(1e-7f));
+                    glm::vec3 const step_transmittance = glm::exp(-extinction * step);
+
+                    // the planet shadows points on its night side
+                    bool const lit = RaySphere(position, sun, ground, true) <= 0.0f;
+                    glm::vec3 const source = lit ? medium.scattering * isotropic_phase * sun_transmittance(position, sun) : glm::vec3(0.0f);
+
+                    // integrated analytically over the step, for constant coefficients
+                    luminance += throughput * (source - source * step_transmittance) / extinction;
+                    scattered += throughput * (medium.scattering - medium.scattering * step_transmittance) / extinction;
+                    throughput *= step_transmittance;
+                }
+
+                if (hits_ground)
+                {
+                    glm::vec3 const position = origin + direction * length;
+                    float const lambert = std::max(glm::dot(glm::normalize(position), sun), 0.0f);
+                    luminance += throughput * sun_transmittance(position, sun) * lambert * atmosphere.radii.w / glm::pi<float>();
+                }
+
+                second_order += luminance;
+                transfer += scattered;
+            }
+
+            float const directions = static_cast<float>(MultipleScatteringDirections * MultipleScatteringDirections);
+            second_order /= directions;
+            transfer /= directions;
+            glm::vec3 const multiple = second_order / (1.0f - glm::min(transfer, glm::vec3(0.999f)));
+            table[static_cast<size_t>(row) * MultipleScatteringSize.x + column] = glm::vec4(multiple, 1.0f);
+        }
+    });
+    return table;
+}
+
+//======================================================================================================================
+
+void Atmosphere::UploadTable(GLuint const texture, glm::ivec2 const size, void const * texels)
+{
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, size.x, size.y, 0, GL_RGBA, GL_FLOAT, texels);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+//======================================================================================================================
@@ -0,0 +1,104 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Physically based atmospheres for earth-like bodies, after Bruneton and
+// Neyret (2008) and Hillaire (2020). Two lookup tables depend only on the
+// scattering parameters:
+//  - transmittance from any height and zenith angle to the top of the
+//    atmosphere, in Bruneton's parameterization
+//  - the isotropic multiple scattering contribution for a height and sun
+//    zenith angle, from Hillaire's infinite series approximation
+// They are built on the CPU with one worker per core, written to a binary
+// cache keyed by a hash of the parameters and mapped straight from disk on
+// later runs. atmosphere.frag then ray-marches a few steps through a shell
+// around the body, each step a couple of fetches from the tables.
+//------------------------------------------------------------------------------
+
+#include "Frustum.hpp"
+#include "GLHandles.h"
+#include "MeshBuffer.hpp"
+#include "ShaderProgram.h"
+#include "UniformBlocks.hpp"
+#include "UniformBuffer.h"
+
+#include <glm/glm.hpp>
+
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+class Atmosphere
+{
+public:
+
+    // Earth's atmosphere as in Hillaire's paper, lengths in kilometres
+    struct Parameters
+    {
+        float groundRadius = 6360.0f;
+        float topRadius = 6460.0f;
+        glm::vec3 rayleighScattering {5.802e-3f, 13.558e-3f, 33.1e-3f};
+        float rayleighScaleHeight = 8.0f;
+        float mieScattering = 3.996e-3f;
+        float mieExtinction = 4.40e-3f;
+        float mieScaleHeight = 1.2f;
+        float mieAsymmetry = 0.8f;
+        glm::vec3 ozoneAbsorption {0.650e-3f, 1.881e-3f, 0.085e-3f};
+        float ozonePeakHeight = 25.0f;
+        float ozoneHalfWidth = 15.0f;
+        float groundAlbedo = 0.3f;
+    };
+
+    struct Settings
+    {
+        bool enabled = true;
+        float sunIlluminance = 2.0f;
+    };
+
+    struct Stats
+    {
+        bool fromCache = false;
+        float loadMs = 0.0f;    // table build or cache mapping, and the upload
+        int workers = 0;        // threads that built the tables, 0 when they came from the cache
+    };
+
+    explicit Atmosphere(Parameters const & parameters, std::filesystem::path const & cacheDirectory);
+
+    // Draws the atmosphere around a body whose ground is the given sphere, using mesh (a unit sphere) as the proxy.
+    // Needs the FrameData and Eclipses blocks bound and the scene depth attached, blends over the scene colour.
+    void Draw(BoundingSphere const & ground, MeshBuffer const & meshes, MeshBuffer::MeshId mesh) const;
+
+    [[nodiscard]]
+    Settings & GetSettings() { return mSettings; }
+
+    [[nodiscard]]
+    Stats const & GetStats() const { return mStats; }
+
+    static constexpr glm::ivec2 TransmittanceSize {256, 64};
+    static constexpr glm::ivec2 MultipleScatteringSize {32, 32};
+
+private:
+
+    // RGBA32F texels, rows bottom to top
+    using Table = std::vector<glm::vec4>;
+
+    [[nodiscard]]
+    static Table BuildTransmittance(UniformBlocks::AtmosphereData const & atmosphere, int & workers);
+
+    [[nodiscard]]
+    static Table BuildMultipleScattering(UniformBlocks::AtmosphereData const & atmosphere, Table const & transmittance, int & workers);
+
+    static void UploadTable(GLuint texture, glm::ivec2 size, void const * texels);
+
+    Settings mSettings {};
+    Stats mStats {};
+    float mTopRatio = 1.0f;     // top of the atmosphere over the ground radius
+
+    UniformBuffer mParameterBuffer {UniformBlocks::AtmosphereBinding};
+    TextureHandle mTransmittance {};
+    TextureHandle mMultipleScattering {};
+
+    std::unique_ptr<ShaderProgram> mShader {};
+    ShaderProgram::Uniform mGroundUniform {};
+    ShaderProgram::Uniform mProxyRadiusUniform {};
+    ShaderProgram::Uniform mSunIlluminanceUniform {};
+};
@@ -0,0 +1,57 @@
+#include "CacheFile.hpp"
+
+#include "Log.h"
+
+#include <cstring>
+#include <fstream>
+
+static_assert(sizeof(CacheFile::Header) == 32, "the header is compared and written byte for byte");
+
+//======================================================================================================================
+
+CacheFile::CacheFile(
+    std::filesystem::path const & path,
+    Header const & expected,
+    size_t const payloadSize,
+    std::string const & name
+)
+    : mFile(path)
+{
+    if (mFile.IsOpen() == false)
+    {
+        return;
+    }
+
+    if (mFile.Size() != sizeof(Header) + payloadSize || std::memcmp(mFile.Data(), &expected, sizeof(Header)) != 0)
+    {
+        Log::info("The {} cache {} is out of date, rebuilding it", name, path.string());
+        return;
+    }
+    mValid = true;
+}
+
+//======================================================================================================================
+
+void CacheFile::Write(
+    std::filesystem::path const & path,
+    Header const & header,
+    std::initializer_list<Part> const parts,
+    std::string const & name
+)
+{
+    std::error_code error {};
+    std::filesystem::create_directories(path.parent_path(), error);
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<char const *>(&header), sizeof(header));
+    for (Part const & part : parts)
+    {
+        file.write(static_cast<char const *>(part.data), static_cast<std::streamsize>(part.size));
+    }
+    if (file.good() == false)
+    {
+        Log::warn("Could not write the {} cache to {}", name, path.string());
+    }
+}
+
+//======================================================================================================================
@@ -0,0 +1,54 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// A cache of data that is slow to build, stored as a fixed header followed by
+// the payload. The header names the format and holds a key of whatever the
+// payload was built from, so a stale or foreign file is rebuilt rather than
+// read. Valid files are mapped and read without a copy.
+//------------------------------------------------------------------------------
+
+#include "MappedFile.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <initializer_list>
+#include <string>
+
+class CacheFile
+{
+public:
+
+    struct Header
+    {
+        char magic[4] = {};
+        uint32_t version = 0;
+        uint64_t key = 0;
+        uint32_t dimensions[4] = {};    // sizes the payload was built at, unused ones are zero
+    };
+
+    struct Part
+    {
+        void const * data = nullptr;
+        size_t size = 0;
+    };
+
+    // IsValid() is false unless path holds exactly expected followed by payloadSize bytes. name is
+    // used in log messages, e.g. "sky".
+    explicit CacheFile(std::filesystem::path const & path, Header const & expected, size_t payloadSize, std::string const & name);
+
+    [[nodiscard]]
+    bool IsValid() const { return mValid; }
+
+    [[nodiscard]]
+    uint8_t const * Payload() const { return mFile.Data() + sizeof(Header); }
+
+    // Writes header and then the parts in order, creating the directory when it does not exist. A failed write
+    // only costs rebuilding the payload next run, so it is logged as a warning.
+    static void Write(std::filesystem::path const & path, Header const & header, std::initializer_list<Part> parts, std::string const & name);
+
+private:
+
+    MappedFile mFile;
+    bool mValid = false;
+};
@@ -1,26 +1,32 @@
 #include "CelestialBody.hpp"
 #include "ShapeGenerator.hpp"
-#include "AssetPath.h"
 
 #include <glm/gtc/matrix_transform.hpp>
 #include <cmath>
 
 // default constructor has placeholder moon texture
-CelestialBody::CelestialBody()
-    : texture(AssetPath::Instance()->Get("textures/2k_moon.jpg"), GL_NEAREST) // moon placeholder
-{}
+CelestialBody::CelestialBody() = default;
 
 // sphere geometry handled separately in ShapeGenerator because the method stub was provided there
 // in the boilerplate
 void CelestialBody::initialize_geometry(float radius, int slices, int stacks)
 {
+    this->radius = radius;
+    this->slices = slices;
+    this->stacks = stacks;
     cpu_geometry = ShapeGenerator::Sphere(radius, slices, stacks);
+    local_bounds = BoundingSphere::FromPositions(cpu_geometry.positions);
 }
 
-// use the AssetPath helper to load the texture from the given path
+// only remembers the path, SolarSystem packs every body's texture into a texture array
 void CelestialBody::set_texture(std::string const& texture_path)
 {
-    texture = Texture(AssetPath::Instance()->Get(texture_path), GL_NEAREST);
+    surface = MaterialLibrary::Surface{texture_path};
+}
+
+void CelestialBody::set_surface(MaterialLibrary::Surface const& surface)
+{
+    this->surface = surface;
 }
 
 // set this body's parent to another body 
@@ -29,10 +35,10 @@ void CelestialBody::set_parent(CelestialBody* parent_body)
     parent = parent_body;
 }
 
-// push to GPU buffers using Update method
-void CelestialBody::upload_to_gpu()
+// push to the shared mesh buffer, unless a body with the same sphere is already there
+void CelestialBody::upload_to_gpu(MeshBuffer& meshes)
 {
-    gpu_geometry.Update(cpu_geometry);
+    mesh = meshes.AddSphere(radius, slices, stacks);
 }
 
 // advance spin and orbit angles using delta time, then recompute transform
@@ -79,12 +85,40 @@ glm::mat4 const& CelestialBody::get_model_matrix() const
     return model_matrix;
 }
 
-// getter for texture
-Texture& CelestialBody::get_texture() {
-    return texture;
+// getter for texture path
+std::string const& CelestialBody::get_texture_path() const {
+    return surface.color;
+}
+
+// getter for every map of the surface
+MaterialLibrary::Surface const& CelestialBody::get_surface() const {
+    return surface;
+}
+
+// getter for the mesh in the shared mesh buffer
+MeshBuffer::MeshId CelestialBody::get_mesh() const {
+    return *mesh;
+}
+
+// getter for the culling bounds in world space
+BoundingSphere CelestialBody::get_world_bounds() const {
+    return local_bounds.Transformed(model_matrix);
+}
+
+// getter for the culling bounds in model space
+BoundingSphere const& CelestialBody::get_local_bounds() const {
+    return local_bounds;
+}
+
+// getters for the sphere parameters
+float CelestialBody::get_radius() const {
+    return radius;
+}
+
+int CelestialBody::get_slices() const {
+    return slices;
 }
 
-// getter for gpu geometry
-GPU_Geometry& CelestialBody::get_geometry() {
-    return gpu_geometry;
+int CelestialBody::get_stacks() const {
+    return stacks;
 }
@@ -7,8 +7,10 @@
 // (for orbits). Everything gets bundled and uploaded to the GPU from here.
 //------------------------------------------------------------------------------
 
+#include "Frustum.hpp"
 #include "Geometry.h"
-#include "Texture.h"
+#include "MaterialLibrary.hpp"
+#include "MeshBuffer.hpp"
 
 #include <glm/glm.hpp>
 #include <memory>
@@ -22,9 +24,12 @@ public:
     // just calls the sphere method in ShapeGenerator.cpp
     void initialize_geometry(float radius, int slices, int stacks);
 
-    // give filepath for texture
+    // give filepath for texture, loaded later into the shared MaterialLibrary
     void set_texture(std::string const& texture_path);
 
+    // same, for a surface with extra maps (specular mask, night lights)
+    void set_surface(MaterialLibrary::Surface const& surface);
+
     // link to a parent body
     void set_parent(CelestialBody* parent_body);
 
@@ -40,12 +45,25 @@ public:
     // gets the current model matrix
     [[nodiscard]] glm::mat4 const& get_model_matrix() const;
 
-    // push cpu geometry to GPU
-    void upload_to_gpu();
+    // push cpu geometry into the shared mesh buffer. Bodies with the same sphere parameters
+    // share one mesh, so they can be drawn together with instancing
+    void upload_to_gpu(MeshBuffer& meshes);
 
     // getter methods from texture and geometry
-    Texture& get_texture();
-    GPU_Geometry& get_geometry();
+    [[nodiscard]] std::string const& get_texture_path() const;
+    [[nodiscard]] MaterialLibrary::Surface const& get_surface() const;
+    [[nodiscard]] MeshBuffer::MeshId get_mesh() const;
+
+    // bounding sphere of the mesh, moved into world space by the model matrix (used for culling)
+    [[nodiscard]] BoundingSphere get_world_bounds() const;
+
+    // bounding sphere of the mesh in model space (the GPU-driven path transforms it itself)
+    [[nodiscard]] BoundingSphere const& get_local_bounds() const;
+
+    // sphere parameters, used by the attribute-less (procedural) render path
+    [[nodiscard]] float get_radius() const;
+    [[nodiscard]] int get_slices() const;
+    [[nodiscard]] int get_stacks() const;
 
 public:
     // transform parameters
@@ -57,10 +75,28 @@ public:
     float axis_rotation_speed = 1.0f;
     float orbit_rotation_speed = 1.0f;
 
+    // large bodies (sun, planets) are drawn first and hide the ones behind them
+    bool is_occluder = false;
+
+    // how the body is drawn, so the render loop doesn't have to check for specific bodies
+    bool is_emissive = false;   // not phong shaded (sun)
+    bool is_transparent = false; // composited with order independent transparency, coverage from the texture (clouds)
+    bool has_atmosphere = false; // scattering shell drawn around it by Atmosphere
+    float emission = 1.0f;      // HDR brightness of emissive bodies, above one they bloom
+
+    // texture array, layer and feature bits of this body's surface, set by SolarSystem once all textures are added
+    MaterialLibrary::Material material{};
+
 private:
-    GPU_Geometry gpu_geometry;
+    std::shared_ptr<MeshBuffer::MeshId const> mesh;
     CPU_Geometry cpu_geometry;
-    Texture texture;
+    MaterialLibrary::Surface surface{"textures/2k_moon.jpg"}; // moon placeholder
+
+    BoundingSphere local_bounds;
+
+    float radius = 1.0f;
+    int slices = 0;
+    int stacks = 0;
 
     float axis_rotation_angle = 0.0f;
     float orbit_rotation_angle = 0.0f;
@@ -0,0 +1,33 @@
+#include "ComputeProgram.h"
+
+#include <stdexcept>
+
+#include "AssetPath.h"
+
+ComputeProgram::ComputeProgram(const std::string &computePath)
+    : LinkedProgram("COMPUTE_PROGRAM"),
+      programID(),
+      compute(AssetPath::Instance()->Get(computePath), GL_COMPUTE_SHADER) {
+  attach(*this, compute);
+  name = compute.getPath();
+
+  if (!link(programID)) {
+    glDeleteProgram(programID);
+    throw std::runtime_error("Compute shader did not link.");
+  }
+
+  GLint workGroupSize[3] = {1, 1, 1};
+  glGetProgramiv(programID, GL_COMPUTE_WORK_GROUP_SIZE, workGroupSize);
+  localSize = glm::uvec3(workGroupSize[0], workGroupSize[1], workGroupSize[2]);
+}
+
+void ComputeProgram::dispatch(GLuint invocations) const {
+  GLuint const groups = (invocations + localSize.x - 1) / localSize.x;
+  if (groups > 0) {
+    glDispatchCompute(groups, 1, 1);
+  }
+}
+
+void attach(ComputeProgram &cp, Shader &s) {
+  glAttachShader(cp.programID, s.shaderID);
+}
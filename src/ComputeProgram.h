@@ -0,0 +1,47 @@
+#pragma once
+
+#include "LinkedProgram.h"
+#include "Shader.h"
+
+#include "GLHandles.h"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <string>
+
+
+// A program made of a single compute shader (GL 4.3+). Only create one after checking
+// the context version, the constructor throws if the shader does not compile.
+class ComputeProgram : public LinkedProgram {
+
+public:
+	explicit ComputeProgram(const std::string& computePath);
+	// Because we're using the ShaderProgramHandle to do RAII for the shader for us
+	// and our other types are trivial or provide their own RAII
+	// we don't have to provide any specialized functions here. Rule of zero
+	//
+	// https://en.cppreference.com/w/cpp/language/rule_of_three
+	// https://github.com/isocpp/CppCoreGuidelines/blob/master/CppCoreGuidelines.md#Rc-zero
+
+	// Public interface
+	void use() const { glUseProgram(programID); }
+
+	// Number of invocations per work group along x, as declared by local_size_x
+	GLuint localSizeX() const { return localSize.x; }
+
+	// Runs enough work groups to cover invocations along x, the program must be in use
+	void dispatch(GLuint invocations) const;
+
+	void friend attach(ComputeProgram& cp, Shader& s);
+
+	operator GLuint() const {
+		return programID;
+	}
+
+private:
+	ShaderProgramHandle programID;
+
+	Shader compute;
+	glm::uvec3 localSize{1};
+};
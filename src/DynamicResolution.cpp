@@ -0,0 +1,32 @@
+#include "DynamicResolution.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+//======================================================================================================================
+
+float DynamicResolution::Update(float const gpuFrameMs)
+{
+    if (mSettings.enabled == false)
+    {
+        return GetScale();
+    }
+
+    mFramesSinceUpdate += 1;
+    if (mFramesSinceUpdate < UpdateInterval || gpuFrameMs <= 0.0f)
+    {
+        return GetScale();
+    }
+    mFramesSinceUpdate = 0;
+
+    float const ratio = std::sqrt(mSettings.targetFrameMs * Headroom / gpuFrameMs);
+    float const wanted = mScale * std::clamp(ratio, 1.0f - MaxChange, 1.0f + MaxChange);
+
+    // only move once the wanted scale is a whole step away, so small noise does not reallocate targets
+    float const snapped = std::round(wanted / ScaleStep) * ScaleStep;
+    float const min_scale = std::min(mSettings.minScale, mSettings.maxScale);
+    mScale = std::clamp(snapped, min_scale, mSettings.maxScale);
+    return GetScale();
+}
+
+//======================================================================================================================
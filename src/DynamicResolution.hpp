@@ -0,0 +1,43 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Picks the fraction of the window resolution the scene is rendered at, so the
+// measured GPU frame time stays at a target. Cost is roughly proportional to
+// the pixel count, so the scale moves by the square root of target/measured.
+// Timer results lag a few frames and are smoothed, so the scale only changes
+// every UpdateInterval frames, by a limited step and on a coarse grid (every
+// change reallocates the offscreen targets).
+//------------------------------------------------------------------------------
+
+class DynamicResolution
+{
+public:
+
+    struct Settings
+    {
+        bool enabled = true;
+        float targetFrameMs = 16.0f;
+        float minScale = 0.5f;
+        float maxScale = 1.0f;
+    };
+
+    // Call once per frame with the GPU time of the frame, returns the scale for the next one
+    float Update(float gpuFrameMs);
+
+    [[nodiscard]]
+    float GetScale() const { return mSettings.enabled ? mScale : 1.0f; }
+
+    [[nodiscard]]
+    Settings & GetSettings() { return mSettings; }
+
+    static constexpr int UpdateInterval = 15;
+    static constexpr float ScaleStep = 0.05f;   // grid the scale snaps to
+    static constexpr float MaxChange = 0.15f;   // per update
+    static constexpr float Headroom = 0.9f;     // aims a little under the target to absorb spikes
+
+private:
+
+    Settings mSettings {};
+    float mScale = 1.0f;
+    int mFramesSinceUpdate = 0;
+};
@@ -0,0 +1,95 @@
+#include "EclipseShadows.hpp"
+
+#include <algorithm>
+
+//======================================================================================================================
+
+void EclipseShadows::Clear(BoundingSphere const & sun, size_t const bodyCount)
+{
+    mBlock = {};
+    mBlock.sun = glm::vec4(sun.center, sun.radius);
+    mMasks.assign(bodyCount, 0u);
+    mStats = {};
+}
+
+//======================================================================================================================
+
+void EclipseShadows::Update(BoundingSphere const & sun, std::vector<Body> const & bodies)
+{
+    Clear(sun, bodies.size());
+
+    for (size_t caster_index = 0; caster_index < bodies.size(); ++caster_index)
+    {
+        Body const & caster = bodies[caster_index];
+        if (caster.castsShadow == false)
+        {
+            continue;
+        }
+
+        uint32_t const slot = mBlock.info.x;
+        bool shadows_anything = false;
+        for (size_t receiver_index = 0; receiver_index < bodies.size(); ++receiver_index)
+        {
+            Body const & receiver = bodies[receiver_index];
+            if (receiver_index == caster_index ||
+                receiver.receivesShadow == false ||
+                CanShadow(sun, caster.bounds, receiver.bounds) == false)
+            {
+                continue;
+            }
+
+            shadows_anything = true;
+            if (slot < UniformBlocks::MaxEclipseOccluders)
+            {
+                mMasks[receiver_index] |= 1u << slot;
+            }
+        }
+
+        if (shadows_anything == false)
+        {
+            continue;
+        }
+        if (slot >= UniformBlocks::MaxEclipseOccluders)
+        {
+            mStats.dropped += 1;
+            continue;
+        }
+        mBlock.occluders[slot] = glm::vec4(caster.bounds.center, caster.bounds.radius);
+        mBlock.info.x += 1;
+    }
+
+    mStats.occluders = static_cast<int>(mBlock.info.x);
+    mStats.shadowedBodies = static_cast<int>(std::count_if(mMasks.begin(), mMasks.end(), [](uint32_t const mask)->bool {
+        return mask != 0u;
+    }));
+}
+
+//======================================================================================================================
+
+// The penumbra is the cone touching the sun and the caster on opposite sides. Behind the caster it widens from
+// the caster's radius by (sun radius + caster radius) per sun-caster distance, so the receiver can only be shadowed
+// when its centre is closer to the sun-caster axis than that width plus its own radius.
+bool EclipseShadows::CanShadow(BoundingSphere const & sun, BoundingSphere const & caster, BoundingSphere const & receiver)
+{
+    glm::vec3 const sun_to_caster = caster.center - sun.center;
+    float const sun_distance = glm::length(sun_to_caster);
+    if (sun_distance <= sun.radius + caster.radius)
+    {
+        return false;
+    }
+    glm::vec3 const axis = sun_to_caster / sun_distance;
+
+    glm::vec3 const caster_to_receiver = receiver.center - caster.center;
+    float const behind = glm::dot(caster_to_receiver, axis);
+    if (behind + receiver.radius <= 0.0f)
+    {
+        return false; // entirely on the sun's side of the caster
+    }
+
+    float const penumbra_radius = caster.radius + (sun.radius + caster.radius) * std::max(behind, 0.0f) / sun_distance;
+    float const reach = penumbra_radius + receiver.radius;
+    glm::vec3 const lateral = caster_to_receiver - axis * behind;
+    return glm::dot(lateral, lateral) < reach * reach;
+}
+
+//======================================================================================================================
@@ -0,0 +1,60 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Shadows between bodies without shadow maps. Every frame the CPU finds, for
+// each lit body, the few spheres whose penumbra cone can reach it and writes
+// them to the Eclipses uniform block. phong.frag then treats the sun and each
+// occluder as disks seen from the fragment and dims the light by the fraction
+// of the sun's disk that is covered, which gives umbra, penumbra and annular
+// eclipses from the same formula.
+//------------------------------------------------------------------------------
+
+#include "Frustum.hpp"
+#include "UniformBlocks.hpp"
+
+#include <cstdint>
+#include <vector>
+
+class EclipseShadows
+{
+public:
+
+    struct Body
+    {
+        BoundingSphere bounds {};
+        bool castsShadow = false;
+        bool receivesShadow = false;
+    };
+
+    struct Stats
+    {
+        int occluders = 0;      // in the block this frame
+        int shadowedBodies = 0; // bodies with at least one occluder
+        int dropped = 0;        // occluders that did not fit into the block
+    };
+
+    // Rebuilds the occluder list and the per body masks, bodies are indexed like the input
+    void Update(BoundingSphere const & sun, std::vector<Body> const & bodies);
+
+    // Empty block and zero masks, for when eclipses are switched off
+    void Clear(BoundingSphere const & sun, size_t bodyCount);
+
+    [[nodiscard]]
+    uint32_t GetMask(size_t bodyIndex) const { return mMasks[bodyIndex]; }
+
+    [[nodiscard]]
+    UniformBlocks::EclipseData const & GetBlock() const { return mBlock; }
+
+    [[nodiscard]]
+    Stats const & GetStats() const { return mStats; }
+
+private:
+
+    // Whether any point of the receiver can be in the caster's penumbra
+    [[nodiscard]]
+    static bool CanShadow(BoundingSphere const & sun, BoundingSphere const & caster, BoundingSphere const & receiver);
+
+    UniformBlocks::EclipseData mBlock {};
+    std::vector<uint32_t> mMasks {};
+    Stats mStats {};
+};
@@ -0,0 +1,324 @@
+#include "FrameCapture.hpp"
+
+#include "Log.h"
+
+#include <fmt/format.h>
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef _WIN32
+#define popen _popen
+#define pclose _pclose
+#endif
+
+namespace
+{
+    using Clock = std::chrono::high_resolution_clock;
+
+    float MillisecondsSince(Clock::time_point const start)
+    {
+        return std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+    }
+}
+
+//======================================================================================================================
+
+FrameCapture::FrameCapture(Sink const sink, std::string const & target, glm::ivec2 const size)
+    : FrameCapture(sink, target, size, Settings{})
+{
+}
+
+//======================================================================================================================
+
+FrameCapture::FrameCapture(Sink const sink, std::string const & target, glm::ivec2 const size, Settings const & settings)
+    : mSink(sink)
+    , mSize(size)
+    , mFrameBytes(static_cast<size_t>(size.x) * size.y * 3)
+    , mSettings(settings)
+{
+    if (mSink == Sink::PngSequence)
+    {
+        // glReadPixels returns the bottom row first, set once before any worker writes
+        stbi_flip_vertically_on_write(1);
+        mDirectory = target;
+        std::error_code error {};
+        std::filesystem::create_directories(mDirectory, error);
+        if (error)
+        {
+            Log::error("Could not create the capture directory {}: {}", target, error.message());
+            throw std::runtime_error("Could not create the capture directory");
+        }
+    }
+    else
+    {
+#ifndef _WIN32
+        // an encoder that exits early should fail the writes, not end the process
+        std::signal(SIGPIPE, SIG_IGN);
+#endif
+#ifdef _WIN32
+        // binary, a text mode pipe would turn every 0x0A in the rows into 0x0D 0x0A
+        mPipe = popen(target.c_str(), "wb");
+#else
+        mPipe = popen(target.c_str(), "w");
+#endif
+        if (mPipe == nullptr)
+        {
+            Log::error("Could not start the capture encoder \"{}\"", target);
+            throw std::runtime_error("Could not start the capture encoder");
+        }
+    }
+
+    mReadbacks.resize(static_cast<size_t>(std::max(mSettings.readbackLatency, 1)));
+    for (auto & readback : mReadbacks)
+    {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+        glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(mFrameBytes), nullptr, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    // a pipe needs the frames in order, so only one worker writes to it
+    int workers = mSettings.workers;
+    if (workers <= 0)
+    {
+        workers = std::clamp(static_cast<int>(std::thread::hardware_concurrency()) / 2, 1, 8);
+    }
+    if (mSink == Sink::Pipe)
+    {
+        workers = 1;
+    }
+    for (int i = 0; i < workers; ++i)
+    {
+        mWorkers.emplace_back(&FrameCapture::WorkerLoop, this);
+    }
+
+    Log::info("Capturing {}x{} frames to {} with {} workers", size.x, size.y, target, workers);
+}
+
+//======================================================================================================================
+
+FrameCapture::~FrameCapture()
+{
+    Finish();
+    {
+        std::lock_guard<std::mutex> const lock(mMutex);
+        mStopping = true;
+    }
+    mJobAdded.notify_all();
+    for (auto & worker : mWorkers)
+    {
+        worker.join();
+    }
+    if (mPipe != nullptr)
+    {
+        pclose(mPipe);
+    }
+}
+
+//======================================================================================================================
+
+void FrameCapture::Capture(GLuint const framebuffer, glm::ivec2 const size)
+{
+    if (size != mSize)
+    {
+        if (mWarnedSize == false)
+        {
+            Log::warn("Not capturing {}x{} frames, the capture was started at {}x{}", size.x, size.y, mSize.x, mSize.y);
+            mWarnedSize = true;
+        }
+        return;
+    }
+
+    // the buffer's previous readback was started a full ring ago, it is normally done by now
+    Readback & readback = mReadbacks[mNextFrame % mReadbacks.size()];
+    if (readback.fence != nullptr)
+    {
+        Collect(readback);
+    }
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, mSize.x, mSize.y, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+    readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    readback.frame = mNextFrame++;
+
+    std::lock_guard<std::mutex> const lock(mMutex);
+    mStats.captured += 1;
+}
+
+//======================================================================================================================
+
+void FrameCapture::Finish()
+{
+    // oldest first, so a pipe still gets the frames in order
+    for (size_t i = 0; i < mReadbacks.size(); ++i)
+    {
+        Readback & readback = mReadbacks[(mNextFrame + i) % mReadbacks.size()];
+        if (readback.fence != nullptr)
+        {
+            Collect(readback);
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(mMutex);
+    mJobDone.wait(lock, [this]()->bool {
+        return mJobs.empty() && mBusyWorkers == 0;
+    });
+    if (mPipe != nullptr)
+    {
+        std::fflush(mPipe);
+    }
+
+    if (mStats.captured > mReportedFrames)
+    {
+        mReportedFrames = mStats.captured;
+        Log::info(
+            "Captured {} frames, the encode queue held up to {} and was full for {} of them ({:.1f} ms waiting)",
+            mStats.written, mStats.maxQueued, mStats.blockedFrames, mStats.blockedMs
+        );
+    }
+}
+
+//======================================================================================================================
+
+FrameCapture::Stats FrameCapture::GetStats() const
+{
+    std::lock_guard<std::mutex> const lock(mMutex);
+    return mStats;
+}
+
+//======================================================================================================================
+
+void FrameCapture::Collect(Readback & readback)
+{
+    auto const mapStart = Clock::now();
+    GLenum result = glClientWaitSync(readback.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    while (result == GL_TIMEOUT_EXPIRED)
+    {
+        result = glClientWaitSync(readback.fence, 0, 1000000); // 1 ms
+    }
+    glDeleteSync(readback.fence);
+    readback.fence = nullptr;
+
+    std::vector<uint8_t> pixels {};
+    {
+        std::lock_guard<std::mutex> const lock(mMutex);
+        mStats.mapWaitMs += MillisecondsSince(mapStart);
+        if (mFreePixels.empty() == false)
+        {
+            pixels = std::move(mFreePixels.back());
+            mFreePixels.pop_back();
+        }
+    }
+    pixels.resize(mFrameBytes);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+    void const * data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, static_cast<GLsizeiptr>(mFrameBytes), GL_MAP_READ_BIT);
+    if (data != nullptr)
+    {
+        std::memcpy(pixels.data(), data, mFrameBytes);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        if (static_cast<int>(mJobs.size()) >= mSettings.maxQueuedFrames)
+        {
+            // backpressure: the workers are slower than the renderer, wait instead of dropping the frame
+            auto const blockStart = Clock::now();
+            if (mStats.blockedFrames == 0)
+            {
+                Log::warn("Capture encoding is falling behind, rendering waits for it");
+            }
+            mJobTaken.wait(lock, [this]()->bool {
+                return static_cast<int>(mJobs.size()) < mSettings.maxQueuedFrames;
+            });
+            mStats.blockedFrames += 1;
+            mStats.blockedMs += MillisecondsSince(blockStart);
+        }
+        mJobs.push_back(Job{readback.frame, std::move(pixels)});
+        mStats.queued = static_cast<int>(mJobs.size());
+        mStats.maxQueued = std::max(mStats.maxQueued, mStats.queued);
+    }
+    mJobAdded.notify_one();
+}
+
+//======================================================================================================================
+
+void FrameCapture::WorkerLoop()
+{
+    while (true)
+    {
+        Job job {};
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mJobAdded.wait(lock, [this]()->bool {
+                return mStopping || mJobs.empty() == false;
+            });
+            if (mJobs.empty())
+            {
+                return;
+            }
+            job = std::move(mJobs.front());
+            mJobs.pop_front();
+            mStats.queued = static_cast<int>(mJobs.size());
+            mBusyWorkers += 1;
+        }
+        mJobTaken.notify_one();
+
+        Encode(job);
+
+        {
+            std::lock_guard<std::mutex> const lock(mMutex);
+            mBusyWorkers -= 1;
+            mStats.written += 1;
+            mFreePixels.emplace_back(std::move(job.pixels));
+        }
+        mJobDone.notify_all();
+    }
+}
+
+//======================================================================================================================
+
+void FrameCapture::Encode(Job const & job)
+{
+    if (mSink == Sink::PngSequence)
+    {
+        auto const path = mDirectory / fmt::format("frame_{:06d}.png", job.frame);
+        if (stbi_write_png(path.string().c_str(), mSize.x, mSize.y, 3, job.pixels.data(), mSize.x * 3) == 0)
+        {
+            Log::error("Could not write {}", path.string());
+        }
+        return;
+    }
+
+    if (mPipeBroken)
+    {
+        return;
+    }
+
+    // rgb24, top row first
+    size_t const rowBytes = static_cast<size_t>(mSize.x) * 3;
+    for (int y = mSize.y - 1; y >= 0; --y)
+    {
+        if (std::fwrite(job.pixels.data() + rowBytes * y, 1, rowBytes, mPipe) != rowBytes)
+        {
+            Log::error("The capture encoder stopped reading at frame {}", job.frame);
+            mPipeBroken = true;
+            return;
+        }
+    }
+}
+
+//======================================================================================================================
@@ -0,0 +1,123 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Records every rendered frame without stalling the GPU. Capture() starts an
+// asynchronous glReadPixels into one pixel buffer object of a small ring and
+// fences it. The buffer is mapped only when the ring comes back around, by
+// which time the copy has normally finished. The pixels then go to a pool of
+// worker threads that either write one PNG per frame or stream raw RGB frames
+// in order into the stdin of an external encoder (e.g. ffmpeg).
+//
+// The encode queue is bounded: when the workers fall behind, Capture() waits
+// for a free slot instead of dropping frames, and counts that as backpressure.
+//------------------------------------------------------------------------------
+
+#include "GLHandles.h"
+
+#include <glm/glm.hpp>
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class FrameCapture
+{
+public:
+
+    enum class Sink
+    {
+        PngSequence,    // target is a directory, frames are written as frame_000000.png, ...
+        Pipe            // target is a shell command reading rgb24 frames from stdin
+    };
+
+    struct Settings
+    {
+        int readbackLatency = 3;    // frames between the readback and mapping its buffer
+        int workers = 0;            // 0 picks from the core count, a pipe always uses one
+        int maxQueuedFrames = 8;    // decoded frames waiting for a worker before Capture() blocks
+    };
+
+    struct Stats
+    {
+        uint64_t captured = 0;          // read back
+        uint64_t written = 0;           // encoded or piped
+        int queued = 0;                 // waiting for a worker right now
+        int maxQueued = 0;
+        uint64_t blockedFrames = 0;     // frames that had to wait for queue space
+        float blockedMs = 0.0f;         // total time the render thread spent waiting
+        float mapWaitMs = 0.0f;         // total time spent waiting for readbacks, non-zero means the ring is too short
+    };
+
+    // Every captured frame has to have this size
+    explicit FrameCapture(Sink sink, std::string const & target, glm::ivec2 size, Settings const & settings);
+
+    explicit FrameCapture(Sink sink, std::string const & target, glm::ivec2 size);
+
+    // Finishes the outstanding frames
+    ~FrameCapture();
+
+    FrameCapture(FrameCapture const &) = delete;
+    FrameCapture & operator=(FrameCapture const &) = delete;
+
+    // Reads back the colour of the framebuffer (0 for the window), call after the frame is drawn
+    void Capture(GLuint framebuffer, glm::ivec2 size);
+
+    // Maps every readback still in flight and waits until the workers wrote everything
+    void Finish();
+
+    [[nodiscard]]
+    Stats GetStats() const;
+
+private:
+
+    struct Readback
+    {
+        VertexBufferHandle buffer {};
+        GLsync fence = nullptr;
+        uint64_t frame = 0;
+    };
+
+    struct Job
+    {
+        uint64_t frame = 0;
+        std::vector<uint8_t> pixels {};
+    };
+
+    // Copies a finished readback into a job for the workers, waiting for the copy and queue space
+    void Collect(Readback & readback);
+
+    void WorkerLoop();
+
+    void Encode(Job const & job);
+
+    Sink mSink;
+    std::filesystem::path mDirectory {};
+    FILE * mPipe = nullptr;
+    bool mPipeBroken = false;   // only touched by the single pipe worker
+    glm::ivec2 mSize;
+    size_t mFrameBytes;
+    Settings mSettings;
+
+    std::vector<Readback> mReadbacks {};
+    uint64_t mNextFrame = 0;
+    bool mWarnedSize = false;
+    uint64_t mReportedFrames = 0;
+
+    mutable std::mutex mMutex {};
+    std::condition_variable mJobAdded {};
+    std::condition_variable mJobTaken {};
+    std::condition_variable mJobDone {};
+    std::deque<Job> mJobs {};
+    std::vector<std::vector<uint8_t>> mFreePixels {};   // recycled job buffers
+    int mBusyWorkers = 0;
+    bool mStopping = false;
+    std::vector<std::thread> mWorkers {};
+
+    Stats mStats {};
+};
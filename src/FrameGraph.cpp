@@ -0,0 +1,781 @@
+#include "FrameGraph.hpp"
+
+#include "Log.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    void AddUnique(std::vector<size_t> & list, size_t const value)
+    {
+        if (std::find(list.begin(), list.end(), value) == list.end())
+        {
+            list.emplace_back(value);
+        }
+    }
+}
+
+//======================================================================================================================
+
+FrameGraph::Builder::Builder(FrameGraph & graph, size_t const pass)
+    : mGraph(graph)
+    , mPass(pass)
+{}
+
+//======================================================================================================================
+
+FrameGraph::ResourceId FrameGraph::Builder::Create(std::string const & name, TextureDesc const & desc)
+{
+    return mGraph.Create(name, desc);
+}
+
+//======================================================================================================================
+
+void FrameGraph::Builder::Read(ResourceId const resource)
+{
+    auto & pass = mGraph.mPasses[mPass];
+    if (std::find(pass.writes.begin(), pass.writes.end(), resource) != pass.writes.end())
+    {
+        Log::error("FrameGraph: pass '{}' reads '{}' while rendering to it", pass.name, mGraph.mResources[resource].name);
+        return;
+    }
+    pass.reads.emplace_back(resource);
+}
+
+//======================================================================================================================
+
+void FrameGraph::Builder::Write(ResourceId const resource)
+{
+    auto & pass = mGraph.mPasses[mPass];
+    if (std::find(pass.reads.begin(), pass.reads.end(), resource) != pass.reads.end())
+    {
+        Log::error("FrameGraph: pass '{}' reads '{}' while rendering to it", pass.name, mGraph.mResources[resource].name);
+        return;
+    }
+    pass.writes.emplace_back(resource);
+}
+
+//======================================================================================================================
+
+FrameGraph::FrameGraph()
+{
+    Reset();
+}
+
+//======================================================================================================================
+
+void FrameGraph::Reset()
+{
+    mPasses.clear();
+    mResources.clear();
+    mExecutionOrder.clear();
+    mExecutionOrderNames.clear();
+
+    Resource backbuffer {};
+    backbuffer.name = "backbuffer";
+    mResources.emplace_back(std::move(backbuffer));
+}
+
+//======================================================================================================================
+
+void FrameGraph::AddPass(
+    std::string name,
+    SetupFunction const & setup,
+    ExecuteFunction execute,
+    PassOptions const & options
+)
+{
+    Pass pass {};
+    pass.name = std::move(name);
+    pass.execute = std::move(execute);
+    pass.options = options;
+    mPasses.emplace_back(std::move(pass));
+
+    Builder builder {*this, mPasses.size() - 1};
+    setup(builder);
+}
+
+//======================================================================================================================
+
+void FrameGraph::AddPass(std::string name, SetupFunction const & setup, ExecuteFunction execute)
+{
+    AddPass(std::move(name), setup, std::move(execute), PassOptions{});
+}
+
+//======================================================================================================================
+
+FrameGraph::ResourceId FrameGraph::Create(std::string const & name, TextureDesc const & desc)
+{
+    Resource resource {};
+    resource.name = name;
+    resource.desc = desc;
+    mResources.emplace_back(std::move(resource));
+    return static_cast<ResourceId>(mResources.size() - 1);
+}
+
+//======================================================================================================================
+
+FrameGraph::ResourceId FrameGraph::Import(std::string const & name, GLuint const texture, TextureDesc const & desc)
+{
+    Resource resource {};
+    resource.name = name;
+    resource.desc = desc;
+    resource.size = desc.size;
+    resource.imported = texture;
+    mResources.emplace_back(std::move(resource));
+    return static_cast<ResourceId>(mResources.size() - 1);
+}
+
+//======================================================================================================================
+
+void FrameGraph::SetBackbuffer(GLuint const framebuffer)
+{
+    mBackbufferFramebuffer = framebuffer;
+}
+
+//======================================================================================================================
+
+void FrameGraph::Compile(glm::ivec2 const backbufferSize)
+{
+    mBackbufferSize = backbufferSize;
+    mResources[Backbuffer].size = backbufferSize;
+
+    BuildDependencies();
+    CullPasses();
+    SortPasses();
+    AssignTextures();
+
+    mExecutionOrderNames.clear();
+    for (size_t const pass_index : mExecutionOrder)
+    {
+        mExecutionOrderNames.emplace_back(mPasses[pass_index].name);
+    }
+}
+
+//======================================================================================================================
+
+// Writes of one resource keep their declaration order. A read depends on the last write declared before it,
+// or on all of the resource's writers when they are declared after it, so a pass may be added before the
+// passes producing its inputs.
+void FrameGraph::BuildDependencies()
+{
+    size_t const resource_count = mResources.size();
+
+    std::vector<std::vector<size_t>> writers(resource_count);
+    for (size_t pass_index = 0; pass_index < mPasses.size(); ++pass_index)
+    {
+        for (ResourceId const resource : mPasses[pass_index].writes)
+        {
+            writers[resource].emplace_back(pass_index);
+        }
+    }
+
+    std::vector<int> last_writer(resource_count, -1);
+    std::vector<std::vector<size_t>> readers_since_write(resource_count);
+
+    for (size_t pass_index = 0; pass_index < mPasses.size(); ++pass_index)
+    {
+        auto & pass = mPasses[pass_index];
+        pass.producers.clear();
+        pass.predecessors.clear();
+        pass.culled = false;
+
+        for (ResourceId const resource : pass.reads)
+        {
+            if (last_writer[resource] >= 0)
+            {
+                AddUnique(pass.producers, static_cast<size_t>(last_writer[resource]));
+                readers_since_write[resource].emplace_back(pass_index);
+            }
+            else
+            {
+                for (size_t const writer : writers[resource])
+                {
+                    AddUnique(pass.producers, writer);
+                }
+            }
+        }
+
+        for (ResourceId const resource : pass.writes)
+        {
+            if (last_writer[resource] >= 0)
+            {
+                AddUnique(pass.producers, static_cast<size_t>(last_writer[resource]));
+            }
+            for (size_t const reader : readers_since_write[resource])
+            {
+                AddUnique(pass.predecessors, reader);
+            }
+            readers_since_write[resource].clear();
+            last_writer[resource] = static_cast<int>(pass_index);
+        }
+
+        for (size_t const producer : pass.producers)
+        {
+            AddUnique(pass.predecessors, producer);
+        }
+    }
+}
+
+//======================================================================================================================
+
+// A pass survives when it draws to the backbuffer or an imported texture, has side effects, or produces something
+// a surviving pass needs
+void FrameGraph::CullPasses()
+{
+    std::vector<bool> needed(mPasses.size(), false);
+    std::vector<size_t> stack {};
+    for (size_t pass_index = 0; pass_index < mPasses.size(); ++pass_index)
+    {
+        auto const & pass = mPasses[pass_index];
+        bool const writes_outside = std::any_of(pass.writes.begin(), pass.writes.end(), [this](ResourceId const resource)->bool {
+            return resource == Backbuffer || mResources[resource].imported != 0;
+        });
+        if (writes_outside || pass.options.sideEffects)
+        {
+            needed[pass_index] = true;
+            stack.emplace_back(pass_index);
+        }
+    }
+
+    while (stack.empty() == false)
+    {
+        size_t const pass_index = stack.back();
+        stack.pop_back();
+        for (size_t const producer : mPasses[pass_index].producers)
+        {
+            if (needed[producer] == false)
+            {
+                needed[producer] = true;
+                stack.emplace_back(producer);
+            }
+        }
+    }
+
+    mStats.passes = static_cast<int>(mPasses.size());
+    mStats.culledPasses = 0;
+    for (size_t pass_index = 0; pass_index < mPasses.size(); ++pass_index)
+    {
+        mPasses[pass_index].culled = needed[pass_index] == false;
+        mStats.culledPasses += mPasses[pass_index].culled ? 1 : 0;
+    }
+}
+
+//======================================================================================================================
+
+// Topological order of the surviving passes, ties go to the pass declared first
+void FrameGraph::SortPasses()
+{
+    mExecutionOrder.clear();
+
+    std::vector<int> waiting_on(mPasses.size(), 0);
+    std::vector<std::vector<size_t>> successors(mPasses.size());
+    for (size_t pass_index = 0; pass_index < mPasses.size(); ++pass_index)
+    {
+        if (mPasses[pass_index].culled)
+        {
+            continue;
+        }
+        for (size_t const predecessor : mPasses[pass_index].predecessors)
+        {
+            if (mPasses[predecessor].culled == false)
+            {
+                waiting_on[pass_index] += 1;
+                successors[predecessor].emplace_back(pass_index);
+            }
+        }
+    }
+
+    std::vector<bool> scheduled(mPasses.size(), false);
+    bool progress = true;
+    while (progress)
+    {
+        progress = false;
+        for (size_t pass_index = 0; pass_index < mPasses.size(); ++pass_index)
+        {
+            if (mPasses[pass_index].culled || scheduled[pass_index] || waiting_on[pass_index] > 0)
+            {
+                continue;
+            }
+            scheduled[pass_index] = true;
+            mExecutionOrder.emplace_back(pass_index);
+            for (size_t const successor : successors[pass_index])
+            {
+                waiting_on[successor] -= 1;
+            }
+            progress = true;
+            break;
+        }
+    }
+
+    // a cycle means the declarations contradict each other, run what is left as declared
+    for (size_t pass_index = 0; pass_index < mPasses.size(); ++pass_index)
+    {
+        if (mPasses[pass_index].culled == false && scheduled[pass_index] == false)
+        {
+            Log::error("FrameGraph: pass '{}' is part of a dependency cycle", mPasses[pass_index].name);
+            mExecutionOrder.emplace_back(pass_index);
+        }
+    }
+}
+
+//======================================================================================================================
+
+// Transient resources are placed in the order they are first used. One whose lifetime starts after another's
+// ended takes over its texture when format, size and mip count match. Textures no resource used this frame
+// are released, so a resize or a disabled effect gives the memory back.
+void FrameGraph::AssignTextures()
+{
+    for (ResourceId resource_id = Backbuffer + 1; resource_id < mResources.size(); ++resource_id)
+    {
+        auto & resource = mResources[resource_id];
+        resource.firstUse = -1;
+        resource.lastUse = -1;
+        if (resource.imported != 0)
+        {
+            continue;
+        }
+        if (resource.desc.size.x > 0 && resource.desc.size.y > 0)
+        {
+            resource.size = resource.desc.size;
+        }
+        else
+        {
+            resource.size = glm::max(
+                glm::ivec2(glm::round(glm::vec2(mBackbufferSize) * resource.desc.scale)),
+                glm::ivec2(1)
+            );
+        }
+    }
+
+    for (int position = 0; position < static_cast<int>(mExecutionOrder.size()); ++position)
+    {
+        auto const & pass = mPasses[mExecutionOrder[position]];
+        for (auto const * accesses : {&pass.reads, &pass.writes})
+        {
+            for (ResourceId const resource_id : *accesses)
+            {
+                auto & resource = mResources[resource_id];
+                if (resource.firstUse < 0)
+                {
+                    resource.firstUse = position;
+                }
+                resource.lastUse = position;
+            }
+        }
+    }
+
+    std::vector<ResourceId> transients {};
+    for (ResourceId resource_id = Backbuffer + 1; resource_id < mResources.size(); ++resource_id)
+    {
+        if (mResources[resource_id].firstUse >= 0 && mResources[resource_id].imported == 0)
+        {
+            transients.emplace_back(resource_id);
+        }
+    }
+    std::stable_sort(transients.begin(), transients.end(), [this](ResourceId const a, ResourceId const b)->bool {
+        return mResources[a].firstUse < mResources[b].firstUse;
+    });
+
+    for (auto & texture : mTextures)
+    {
+        texture.used = false;
+        texture.busyUntil = -1;
+    }
+
+    bool textures_changed = false;
+    mStats.transientTextures = static_cast<int>(transients.size());
+    mStats.transientBytes = 0;
+
+    for (ResourceId const resource_id : transients)
+    {
+        auto & resource = mResources[resource_id];
+        int const samples = std::max(resource.desc.samples, 1);
+        int const max_levels = 1 + static_cast<int>(std::floor(std::log2(static_cast<float>(std::max(resource.size.x, resource.size.y)))));
+        int const levels = samples > 1 ? 1 : std::clamp(resource.desc.levels, 1, max_levels);
+
+        mStats.transientBytes += TextureBytes(resource.desc.format, resource.size, levels, samples);
+
+        auto const match = std::find_if(mTextures.begin(), mTextures.end(), [&](PhysicalTexture const & texture)->bool {
+            return texture.format == resource.desc.format &&
+                   texture.size == resource.size &&
+                   texture.levels == levels &&
+                   texture.samples == samples &&
+                   texture.busyUntil < resource.firstUse;
+        });
+
+        if (match != mTextures.end())
+        {
+            resource.physical = static_cast<size_t>(std::distance(mTextures.begin(), match));
+        }
+        else
+        {
+            PhysicalTexture texture {};
+            texture.format = resource.desc.format;
+            texture.size = resource.size;
+            texture.levels = levels;
+            texture.samples = samples;
+
+            if (samples > 1)
+            {
+                glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, texture.texture);
+                glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, samples, texture.format, texture.size.x, texture.size.y, GL_TRUE);
+                glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, 0);
+            }
+            else
+            {
+                FormatInfo const info = GetFormatInfo(texture.format);
+                glBindTexture(GL_TEXTURE_2D, texture.texture);
+                for (int level = 0; level < levels; ++level)
+                {
+                    glm::ivec2 const level_size = glm::max(texture.size >> level, glm::ivec2(1));
+                    glTexImage2D(GL_TEXTURE_2D, level, static_cast<GLint>(texture.format), level_size.x, level_size.y, 0, info.format, info.type, nullptr);
+                }
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+                glBindTexture(GL_TEXTURE_2D, 0);
+            }
+
+            mTextures.emplace_back(std::move(texture));
+            resource.physical = mTextures.size() - 1;
+            textures_changed = true;
+        }
+
+        mTextures[resource.physical].used = true;
+        mTextures[resource.physical].busyUntil = resource.lastUse;
+    }
+
+    // drop the unused textures and renumber the rest
+    std::vector<size_t> remap(mTextures.size(), 0);
+    size_t kept = 0;
+    for (size_t texture_index = 0; texture_index < mTextures.size(); ++texture_index)
+    {
+        if (mTextures[texture_index].used)
+        {
+            remap[texture_index] = kept;
+            if (kept != texture_index)
+            {
+                mTextures[kept] = std::move(mTextures[texture_index]);
+            }
+            kept += 1;
+        }
+    }
+    textures_changed = textures_changed || kept != mTextures.size();
+    mTextures.resize(kept);
+    for (ResourceId const resource_id : transients)
+    {
+        mResources[resource_id].physical = remap[mResources[resource_id].physical];
+    }
+
+    // a released texture name can come back for a new texture, so cached attachments are not trusted after that
+    if (textures_changed)
+    {
+        mFramebuffers.clear();
+    }
+
+    mStats.physicalTextures = static_cast<int>(mTextures.size());
+    mStats.physicalBytes = 0;
+    for (auto const & texture : mTextures)
+    {
+        mStats.physicalBytes += TextureBytes(texture.format, texture.size, texture.levels, texture.samples);
+    }
+}
+
+//======================================================================================================================
+
+void FrameGraph::Execute()
+{
+    mProfiler.BeginFrame();
+
+    // resources last written with image stores, later reads need a barrier first
+    std::vector<bool> pending_image_writes(mResources.size(), false);
+
+    for (size_t const pass_index : mExecutionOrder)
+    {
+        auto const & pass = mPasses[pass_index];
+        mCurrentPass = pass_index;
+
+        mProfiler.Begin(pass.name);
+
+        bool needs_barrier = false;
+        for (auto const * accesses : {&pass.reads, &pass.writes})
+        {
+            for (ResourceId const resource_id : *accesses)
+            {
+                needs_barrier = needs_barrier || pending_image_writes[resource_id];
+                pending_image_writes[resource_id] = false;
+            }
+        }
+        if (needs_barrier)
+        {
+            glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT);
+        }
+
+        if (pass.options.compute == false)
+        {
+            BindFramebuffer(pass);
+        }
+
+        if (pass.options.srgb)
+        {
+            glEnable(GL_FRAMEBUFFER_SRGB);
+        }
+        else
+        {
+            glDisable(GL_FRAMEBUFFER_SRGB);
+        }
+
+        if (pass.options.clear != 0 && pass.options.compute == false)
+        {
+            // clears respect the write masks, the previous pass may have left them off
+            glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+            glDepthMask(GL_TRUE);
+            glClearColor(pass.options.clearColor.r, pass.options.clearColor.g, pass.options.clearColor.b, pass.options.clearColor.a);
+            glClear(pass.options.clear);
+        }
+
+        pass.execute(*this);
+
+        if (pass.options.compute)
+        {
+            for (ResourceId const resource_id : pass.writes)
+            {
+                pending_image_writes[resource_id] = true;
+            }
+        }
+
+        mProfiler.End();
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, mBackbufferFramebuffer);
+    glDisable(GL_FRAMEBUFFER_SRGB);
+
+    mProfiler.EndFrame();
+}
+
+//======================================================================================================================
+
+float FrameGraph::GetPassTime(std::string const & name) const
+{
+    return mProfiler.GetTime(name);
+}
+
+//======================================================================================================================
+
+float FrameGraph::GetTotalTime() const
+{
+    float total = 0.0f;
+    for (auto const & name : mExecutionOrderNames)
+    {
+        total += GetPassTime(name);
+    }
+    return total;
+}
+
+//======================================================================================================================
+
+void FrameGraph::BindFramebuffer(Pass const & pass)
+{
+    bool const writes_backbuffer = std::find(pass.writes.begin(), pass.writes.end(), Backbuffer) != pass.writes.end();
+    if (pass.writes.empty() || writes_backbuffer)
+    {
+        if (writes_backbuffer && pass.writes.size() > 1)
+        {
+            Log::error("FrameGraph: pass '{}' mixes the backbuffer with other targets", pass.name);
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, mBackbufferFramebuffer);
+        glViewport(0, 0, mBackbufferSize.x, mBackbufferSize.y);
+        return;
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, GetFramebuffer(pass.writes, pass.name));
+    glm::ivec2 const size = GetSize(pass.writes.front());
+    glViewport(0, 0, size.x, size.y);
+}
+
+//======================================================================================================================
+
+GLuint FrameGraph::GetFramebuffer(std::vector<ResourceId> const & attachments, std::string const & user) const
+{
+    std::vector<GLuint> textures {};
+    for (ResourceId const resource_id : attachments)
+    {
+        textures.emplace_back(GetTexture(resource_id));
+    }
+
+    auto framebuffer = mFramebuffers.find(textures);
+    if (framebuffer != mFramebuffers.end())
+    {
+        return framebuffer->second;
+    }
+
+    framebuffer = mFramebuffers.emplace(textures, FramebufferHandle{}).first;
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer->second);
+
+    std::vector<GLenum> draw_buffers {};
+    for (ResourceId const resource_id : attachments)
+    {
+        auto const & resource = mResources[resource_id];
+        GLenum attachment = GetFormatInfo(resource.desc.format).attachment;
+        if (attachment == GL_COLOR_ATTACHMENT0)
+        {
+            attachment = GL_COLOR_ATTACHMENT0 + static_cast<GLenum>(draw_buffers.size());
+            draw_buffers.emplace_back(attachment);
+        }
+        GLenum const target = resource.desc.samples > 1 ? GL_TEXTURE_2D_MULTISAMPLE : GL_TEXTURE_2D;
+        glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, target, GetTexture(resource_id), 0);
+    }
+    if (draw_buffers.empty())
+    {
+        glDrawBuffer(GL_NONE);
+    }
+    else
+    {
+        glDrawBuffers(static_cast<GLsizei>(draw_buffers.size()), draw_buffers.data());
+    }
+
+    GLenum const status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        Log::error("FrameGraph: framebuffer of pass '{}' is incomplete ({:#x})", user, status);
+    }
+    return framebuffer->second;
+}
+
+//======================================================================================================================
+
+GLuint FrameGraph::GetTexture(ResourceId const resource) const
+{
+    if (resource == Backbuffer)
+    {
+        return 0;
+    }
+    if (mResources[resource].imported != 0)
+    {
+        return mResources[resource].imported;
+    }
+    return mTextures[mResources[resource].physical].texture;
+}
+
+//======================================================================================================================
+
+glm::ivec2 FrameGraph::GetSize(ResourceId const resource) const
+{
+    return mResources[resource].size;
+}
+
+//======================================================================================================================
+
+void FrameGraph::BindTexture(ResourceId const resource, GLuint const unit) const
+{
+    GLenum const target = mResources[resource].desc.samples > 1 ? GL_TEXTURE_2D_MULTISAMPLE : GL_TEXTURE_2D;
+    glActiveTexture(GL_TEXTURE0 + unit);
+    glBindTexture(target, GetTexture(resource));
+    glActiveTexture(GL_TEXTURE0);
+}
+
+//======================================================================================================================
+
+void FrameGraph::Blit(ResourceId const source, GLbitfield const mask, GLenum const filter) const
+{
+    auto const & pass = mPasses[mCurrentPass];
+    bool const to_backbuffer = pass.writes.empty() || pass.writes.front() == Backbuffer;
+    GLuint const target = to_backbuffer ? mBackbufferFramebuffer : GetFramebuffer(pass.writes, pass.name);
+    glm::ivec2 const target_size = to_backbuffer ? mBackbufferSize : GetSize(pass.writes.front());
+    glm::ivec2 const source_size = GetSize(source);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, GetFramebuffer({source}, pass.name));
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, target);
+    glBlitFramebuffer(0, 0, source_size.x, source_size.y, 0, 0, target_size.x, target_size.y, mask, filter);
+    glBindFramebuffer(GL_FRAMEBUFFER, target);
+}
+
+//======================================================================================================================
+
+void FrameGraph::CopyToTexture(ResourceId const source, GLuint const texture, glm::ivec2 & size) const
+{
+    glm::ivec2 const source_size = GetSize(source);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    if (size != source_size)
+    {
+        size = source_size;
+        GLenum const format = mResources[source].desc.format;
+        FormatInfo const info = GetFormatInfo(format);
+        glTexImage2D(GL_TEXTURE_2D, 0, format, size.x, size.y, 0, info.format, info.type, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+    }
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, GetFramebuffer({source}, mPasses[mCurrentPass].name));
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, size.x, size.y);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+//======================================================================================================================
+
+void FrameGraph::DrawFullscreen() const
+{
+    mEmptyVertexArray.bind();
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+}
+
+//======================================================================================================================
+
+FrameGraph::FormatInfo FrameGraph::GetFormatInfo(GLenum const format)
+{
+    switch (format)
+    {
+        case GL_RGBA8:
+        case GL_SRGB8_ALPHA8:
+            return {GL_RGBA, GL_UNSIGNED_BYTE, 4, GL_COLOR_ATTACHMENT0};
+        case GL_RGBA16F:
+            return {GL_RGBA, GL_HALF_FLOAT, 8, GL_COLOR_ATTACHMENT0};
+        case GL_RGBA32F:
+            return {GL_RGBA, GL_FLOAT, 16, GL_COLOR_ATTACHMENT0};
+        case GL_R11F_G11F_B10F:
+            return {GL_RGB, GL_FLOAT, 4, GL_COLOR_ATTACHMENT0};
+        case GL_RG16F:
+            return {GL_RG, GL_HALF_FLOAT, 4, GL_COLOR_ATTACHMENT0};
+        case GL_R8:
+            return {GL_RED, GL_UNSIGNED_BYTE, 1, GL_COLOR_ATTACHMENT0};
+        case GL_R16F:
+            return {GL_RED, GL_HALF_FLOAT, 2, GL_COLOR_ATTACHMENT0};
+        case GL_R32F:
+            return {GL_RED, GL_FLOAT, 4, GL_COLOR_ATTACHMENT0};
+        case GL_DEPTH_COMPONENT24:
+            return {GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, 4, GL_DEPTH_ATTACHMENT};
+        case GL_DEPTH_COMPONENT32F:
+            return {GL_DEPTH_COMPONENT, GL_FLOAT, 4, GL_DEPTH_ATTACHMENT};
+        case GL_DEPTH24_STENCIL8:
+            return {GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, 4, GL_DEPTH_STENCIL_ATTACHMENT};
+        default:
+            Log::error("FrameGraph: unsupported texture format {:#x}", format);
+            return {};
+    }
+}
+
+//======================================================================================================================
+
+size_t FrameGraph::TextureBytes(GLenum const format, glm::ivec2 const size, int const levels, int const samples)
+{
+    size_t bytes = 0;
+    size_t const bytes_per_pixel = GetFormatInfo(format).bytesPerPixel;
+    for (int level = 0; level < levels; ++level)
+    {
+        glm::ivec2 const level_size = glm::max(size >> level, glm::ivec2(1));
+        bytes += static_cast<size_t>(level_size.x) * static_cast<size_t>(level_size.y) * bytes_per_pixel;
+    }
+    return bytes * static_cast<size_t>(samples);
+}
+
+//======================================================================================================================
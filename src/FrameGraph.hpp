@@ -0,0 +1,241 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Rebuilt every frame: passes declare the textures they read and write, then
+// Compile() orders them by those dependencies, culls passes whose results
+// never reach the backbuffer, and places the transient textures so that ones
+// with disjoint lifetimes share the same GL texture. Execute() binds each
+// pass's framebuffer, viewport and sRGB state before calling it, and puts a
+// memory barrier between compute writes and later reads. Every pass is a
+// top-level scope of the graph's GpuProfiler, so passes can time parts of
+// themselves in nested scopes.
+//------------------------------------------------------------------------------
+
+#include "GLHandles.h"
+#include "GpuProfiler.hpp"
+#include "VertexArray.h"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+class FrameGraph
+{
+public:
+
+    using ResourceId = uint32_t;
+
+    // The default framebuffer (colour and depth), always present and never culled. Headless
+    // rendering replaces it with a framebuffer object, see SetBackbuffer.
+    static constexpr ResourceId Backbuffer = 0;
+
+    struct TextureDesc
+    {
+        GLenum format = GL_RGBA8;
+        float scale = 1.0f;         // of the backbuffer size, used while size is zero
+        glm::ivec2 size {0, 0};
+        int levels = 1;
+        int samples = 1;            // more than one makes a multisample texture, levels are ignored then
+    };
+
+    struct PassOptions
+    {
+        GLbitfield clear = 0;       // cleared after binding the pass's framebuffer
+        glm::vec4 clearColor {0.0f};
+        bool srgb = false;          // GL_FRAMEBUFFER_SRGB while the pass runs
+        bool compute = false;       // writes through image stores, no framebuffer is bound
+        bool sideEffects = false;   // never culled, e.g. readbacks (passes writing imported textures never are either)
+    };
+
+    class Builder
+    {
+    public:
+
+        // A texture that only lives for this frame
+        ResourceId Create(std::string const & name, TextureDesc const & desc);
+
+        void Read(ResourceId resource);
+
+        // Colour attachments are bound in the order of the calls, depth formats go to the depth attachment
+        void Write(ResourceId resource);
+
+    private:
+
+        friend class FrameGraph;
+
+        explicit Builder(FrameGraph & graph, size_t pass);
+
+        FrameGraph & mGraph;
+        size_t mPass;
+    };
+
+    using SetupFunction = std::function<void(Builder &)>;
+    using ExecuteFunction = std::function<void(FrameGraph const &)>;
+
+    struct Stats
+    {
+        int passes = 0;
+        int culledPasses = 0;
+        int transientTextures = 0;
+        int physicalTextures = 0;
+        size_t transientBytes = 0;  // without aliasing
+        size_t physicalBytes = 0;
+    };
+
+    explicit FrameGraph();
+
+    // Drops the passes and resources of the previous frame, the GL textures are kept for reuse
+    void Reset();
+
+    void AddPass(std::string name, SetupFunction const & setup, ExecuteFunction execute, PassOptions const & options);
+
+    void AddPass(std::string name, SetupFunction const & setup, ExecuteFunction execute);
+
+    // Same as Builder::Create, for a texture that has to exist before the pass writing it is added
+    ResourceId Create(std::string const & name, TextureDesc const & desc);
+
+    // A texture owned by someone else that outlives the frame. Only desc.format, desc.size and desc.samples are
+    // used. Passes writing it are kept, since the next frame may read what they wrote.
+    ResourceId Import(std::string const & name, GLuint texture, TextureDesc const & desc);
+
+    // The framebuffer object passes writing Backbuffer draw into, 0 for the default framebuffer.
+    // It needs colour and depth attachments of the size given to Compile.
+    void SetBackbuffer(GLuint framebuffer);
+
+    void Compile(glm::ivec2 backbufferSize);
+
+    void Execute();
+
+    // For use inside a pass --------------------------------------------------------------------------------------------
+
+    [[nodiscard]]
+    GLuint GetTexture(ResourceId resource) const;
+
+    [[nodiscard]]
+    glm::ivec2 GetSize(ResourceId resource) const;
+
+    void BindTexture(ResourceId resource, GLuint unit) const;
+
+    // Copies (and resolves, for multisample sources) a texture into the targets of the running pass
+    void Blit(ResourceId source, GLbitfield mask, GLenum filter) const;
+
+    // Copies a single-sample texture into one that outlives the frame. texture is reallocated in the source's
+    // format whenever size differs from the source's, and size is updated to match.
+    void CopyToTexture(ResourceId source, GLuint texture, glm::ivec2 & size) const;
+
+    // The one triangle of fullscreen.vert (and sky.vert) over the running pass's targets. It winds
+    // counter-clockwise, so culling never removes it; the depth state is left to the pass.
+    void DrawFullscreen() const;
+
+    // -----------------------------------------------------------------------------------------------------------------
+
+    [[nodiscard]]
+    Stats const & GetStats() const { return mStats; }
+
+    // Names of the passes that ran, in execution order
+    [[nodiscard]]
+    std::vector<std::string> const & GetExecutionOrder() const { return mExecutionOrderNames; }
+
+    // Times every pass, nested scopes opened inside a pass end up below it
+    [[nodiscard]]
+    GpuProfiler & GetProfiler() { return mProfiler; }
+
+    [[nodiscard]]
+    GpuProfiler const & GetProfiler() const { return mProfiler; }
+
+    // Smoothed GPU time of a pass in milliseconds, 0 until its first result arrives
+    [[nodiscard]]
+    float GetPassTime(std::string const & name) const;
+
+    // Sum of the pass times of the last compiled frame, the GPU time of the whole frame
+    [[nodiscard]]
+    float GetTotalTime() const;
+
+private:
+
+    struct Resource
+    {
+        std::string name {};
+        TextureDesc desc {};
+        glm::ivec2 size {0, 0};
+        size_t physical = 0;        // index into mTextures, transient resources only
+        GLuint imported = 0;        // the texture of an imported resource
+        int firstUse = -1;          // positions in mExecutionOrder
+        int lastUse = -1;
+    };
+
+    struct Pass
+    {
+        std::string name {};
+        ExecuteFunction execute {};
+        PassOptions options {};
+        std::vector<ResourceId> reads {};
+        std::vector<ResourceId> writes {};
+        std::vector<size_t> producers {};   // passes whose output this one needs
+        std::vector<size_t> predecessors {}; // plus readers that must finish before this pass writes
+        bool culled = false;
+    };
+
+    struct PhysicalTexture
+    {
+        TextureHandle texture {};
+        GLenum format = GL_RGBA8;
+        glm::ivec2 size {0, 0};
+        int levels = 1;
+        int samples = 1;
+        int busyUntil = -1;         // last execution position of the resource placed in it this frame
+        bool used = false;
+    };
+
+    void BuildDependencies();
+
+    void SortPasses();
+
+    void CullPasses();
+
+    void AssignTextures();
+
+    void BindFramebuffer(Pass const & pass);
+
+    // Cached per attachment set, created on first use
+    [[nodiscard]]
+    GLuint GetFramebuffer(std::vector<ResourceId> const & attachments, std::string const & user) const;
+
+    // what glTexImage2D needs besides the internal format
+    struct FormatInfo
+    {
+        GLenum format = GL_RGBA;
+        GLenum type = GL_UNSIGNED_BYTE;
+        size_t bytesPerPixel = 4;
+        GLenum attachment = GL_COLOR_ATTACHMENT0;
+    };
+
+    [[nodiscard]]
+    static FormatInfo GetFormatInfo(GLenum format);
+
+    [[nodiscard]]
+    static size_t TextureBytes(GLenum format, glm::ivec2 size, int levels, int samples);
+
+    std::vector<Pass> mPasses {};
+    std::vector<Resource> mResources {};
+    std::vector<size_t> mExecutionOrder {};
+    std::vector<std::string> mExecutionOrderNames {};
+    size_t mCurrentPass = 0;
+    glm::ivec2 mBackbufferSize {0, 0};
+    GLuint mBackbufferFramebuffer = 0;
+
+    std::vector<PhysicalTexture> mTextures {};
+    mutable std::map<std::vector<GLuint>, FramebufferHandle> mFramebuffers {};
+
+    // for DrawFullscreen, the triangle has no attributes but core profile needs a VAO bound
+    VertexArray mEmptyVertexArray {};
+
+    GpuProfiler mProfiler {};
+
+    Stats mStats {};
+};
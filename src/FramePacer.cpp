@@ -0,0 +1,127 @@
+#include "FramePacer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+namespace
+{
+    float Milliseconds(std::chrono::steady_clock::duration const duration)
+    {
+        return std::chrono::duration<float, std::milli>(duration).count();
+    }
+}
+
+//======================================================================================================================
+
+void FramePacer::SetRefreshRate(int const hertz)
+{
+    mRefreshRate = std::max(hertz, 0);
+}
+
+//======================================================================================================================
+
+int FramePacer::GetSwapInterval() const
+{
+    switch (mSettings.mode)
+    {
+    case Mode::Vsync:
+        return 1;
+    case Mode::AdaptiveVsync:
+        return -1;
+    default:
+        return 0;
+    }
+}
+
+//======================================================================================================================
+
+void FramePacer::Wait()
+{
+    Clock::time_point const arrival = Clock::now();
+    bool const limited = mSettings.mode == Mode::Limited;
+    bool missed = false;
+
+    // the deadlines start over after a pause or a mode change, they would be long gone
+    if (limited && (mStarted == false || mLastMode != Mode::Limited))
+    {
+        mDeadline = arrival;
+    }
+    mLastMode = mSettings.mode;
+
+    mStats.sleepMs = 0.0f;
+    mStats.spinMs = 0.0f;
+    if (limited)
+    {
+        missed = WaitForDeadline(arrival) == false;
+    }
+
+    Clock::time_point const now = Clock::now();
+    if (mStarted == false)
+    {
+        mStarted = true;
+        mLastFrame = now;
+        return;
+    }
+
+    float const frame_ms = Milliseconds(now - mLastFrame);
+    mLastFrame = now;
+
+    mStats.targetMs = 0.0f;
+    if (limited)
+    {
+        mStats.targetMs = 1000.0f / std::max(mSettings.maxFps, 1.0f);
+    }
+    else if (mSettings.mode != Mode::Uncapped && mRefreshRate > 0)
+    {
+        mStats.targetMs = 1000.0f / static_cast<float>(mRefreshRate);
+        // the swap of the previous frame waited for the vertical blank, so lateness shows in the interval
+        missed = frame_ms > 1.5f * mStats.targetMs;
+    }
+
+    mStats.frames += 1;
+    mStats.missed += missed ? 1 : 0;
+    mStats.frameMs = mStats.frames == 1 ? frame_ms : mStats.frameMs + (frame_ms - mStats.frameMs) * Smoothing;
+    mStats.jitterMs += (std::abs(frame_ms - mStats.frameMs) - mStats.jitterMs) * Smoothing;
+
+    mHistory[mHistoryNext] = frame_ms;
+    mHistoryNext = (mHistoryNext + 1) % HistoryLength;
+}
+
+//======================================================================================================================
+
+bool FramePacer::WaitForDeadline(Clock::time_point const now)
+{
+    auto const period = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<float>(1.0f / std::max(mSettings.maxFps, 1.0f))
+    );
+    mDeadline += period;
+    if (now >= mDeadline)
+    {
+        mDeadline = now;
+        return false;
+    }
+
+    // sleep until the margin before the deadline, the OS is free to wake us late
+    float const margin_ms = std::max(mSettings.spinMs, 2.0f * mStats.oversleepMs);
+    auto const wake = mDeadline - std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float, std::milli>(margin_ms));
+    if (wake > now)
+    {
+        std::this_thread::sleep_until(wake);
+        Clock::time_point const woke = Clock::now();
+        float const oversleep_ms = std::max(Milliseconds(woke - wake), 0.0f);
+        mStats.oversleepMs += (oversleep_ms - mStats.oversleepMs) * Smoothing;
+        mStats.sleepMs = Milliseconds(woke - now);
+    }
+
+    // the rest precisely, giving the core away between checks
+    Clock::time_point const spin_start = Clock::now();
+    while (Clock::now() < mDeadline)
+    {
+        std::this_thread::yield();
+    }
+    mStats.spinMs = Milliseconds(Clock::now() - spin_start);
+    return true;
+}
+
+//======================================================================================================================
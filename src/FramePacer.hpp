@@ -0,0 +1,97 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Decides when a frame is presented. The vsync modes leave it to the swap
+// interval (adaptive vsync tears instead of waiting a whole refresh when a
+// frame is late). The limiter keeps a deadline every 1 / maxFps seconds and
+// waits for it in two steps: it sleeps until a margin before the deadline,
+// then spins the rest. The margin is the larger of spinMs and the oversleep
+// the OS has recently shown, so sleeping rarely overshoots and spinning stays
+// short. A frame that arrives after its deadline is missed, and the deadlines
+// restart from there instead of hurrying to catch up.
+//------------------------------------------------------------------------------
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+class FramePacer
+{
+public:
+
+    enum class Mode
+    {
+        Vsync,
+        AdaptiveVsync,
+        Uncapped,
+        Limited
+    };
+
+    // for ImGui::Combo, in the order of Mode
+    static constexpr char const * ModeNames = "Vsync\0Adaptive vsync\0Uncapped\0Limited\0";
+
+    struct Settings
+    {
+        Mode mode = Mode::Vsync;
+        float maxFps = 120.0f;      // of the limiter
+        float spinMs = 0.5f;        // shortest part of a wait that is spun instead of slept
+    };
+
+    struct Stats
+    {
+        float targetMs = 0.0f;      // 0 when unknown (uncapped, or vsync without a refresh rate)
+        float frameMs = 0.0f;       // smoothed time between presented frames
+        float jitterMs = 0.0f;      // smoothed distance of the frame time from its average
+        uint64_t frames = 0;
+        uint64_t missed = 0;        // later than the deadline (limiter) or by more than half a refresh (vsync)
+        float sleepMs = 0.0f;       // of the last frame
+        float spinMs = 0.0f;        // of the last frame, CPU time burnt waiting
+        float oversleepMs = 0.0f;   // recent estimate of how late a sleep wakes up
+    };
+
+    static constexpr int HistoryLength = 240;
+
+    // The refresh rate the vsync modes are measured against, 0 when unknown
+    void SetRefreshRate(int hertz);
+
+    // Swap interval for the mode: 1, -1 for adaptive vsync, 0 otherwise
+    [[nodiscard]]
+    int GetSwapInterval() const;
+
+    // Call right before the buffers are swapped, waits under the limiter and measures the frame
+    void Wait();
+
+    [[nodiscard]]
+    Settings & GetSettings() { return mSettings; }
+
+    [[nodiscard]]
+    Stats const & GetStats() const { return mStats; }
+
+    // Recent frame times, a ring with the oldest at GetHistoryOffset()
+    [[nodiscard]]
+    std::vector<float> const & GetHistory() const { return mHistory; }
+
+    [[nodiscard]]
+    int GetHistoryOffset() const { return mHistoryNext; }
+
+private:
+
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr float Smoothing = 0.05f;
+
+    // Sleeps and spins until the next deadline, returns false when it had already passed
+    bool WaitForDeadline(Clock::time_point now);
+
+    Settings mSettings {};
+    Stats mStats {};
+    int mRefreshRate = 0;
+
+    Clock::time_point mDeadline {};
+    Clock::time_point mLastFrame {};
+    bool mStarted = false;
+    Mode mLastMode = Mode::Vsync;
+
+    std::vector<float> mHistory = std::vector<float>(HistoryLength, 0.0f);
+    int mHistoryNext = 0;
+};
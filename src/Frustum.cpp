@@ -0,0 +1,190 @@
+#include "Frustum.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define FRUSTUM_USE_SSE 1
+#include <xmmintrin.h>
+#endif
+
+//======================================================================================================================
+
+BoundingSphere BoundingSphere::FromPositions(std::vector<Position> const & positions)
+{
+    BoundingSphere sphere{};
+    if (positions.empty())
+    {
+        return sphere;
+    }
+
+    glm::vec3 min{std::numeric_limits<float>::max()};
+    glm::vec3 max{std::numeric_limits<float>::lowest()};
+    for (auto const & position : positions)
+    {
+        min = glm::min(min, position);
+        max = glm::max(max, position);
+    }
+    sphere.center = (min + max) * 0.5f;
+
+    float maxDistanceSq = 0.0f;
+    for (auto const & position : positions)
+    {
+        glm::vec3 const delta = position - sphere.center;
+        maxDistanceSq = std::max(maxDistanceSq, glm::dot(delta, delta));
+    }
+    sphere.radius = std::sqrt(maxDistanceSq);
+
+    return sphere;
+}
+
+//======================================================================================================================
+
+BoundingSphere BoundingSphere::Transformed(glm::mat4 const & matrix) const
+{
+    float const scaleX = glm::length(glm::vec3(matrix[0]));
+    float const scaleY = glm::length(glm::vec3(matrix[1]));
+    float const scaleZ = glm::length(glm::vec3(matrix[2]));
+
+    BoundingSphere result{};
+    result.center = glm::vec3(matrix * glm::vec4(center, 1.0f));
+    result.radius = radius * std::max(scaleX, std::max(scaleY, scaleZ));
+    return result;
+}
+
+//======================================================================================================================
+
+void Frustum::SetViewProjection(glm::mat4 const & viewProjection)
+{
+    // glm is column major, so row i is (m[0][i], m[1][i], m[2][i], m[3][i])
+    auto const row = [&viewProjection](int const i)->glm::vec4 {
+        return glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+    };
+
+    mPlanes[0] = row(3) + row(0); // left
+    mPlanes[1] = row(3) - row(0); // right
+    mPlanes[2] = row(3) + row(1); // bottom
+    mPlanes[3] = row(3) - row(1); // top
+    mPlanes[4] = row(3) + row(2); // near
+    mPlanes[5] = row(3) - row(2); // far
+
+    for (auto & plane : mPlanes)
+    {
+        plane /= glm::length(glm::vec3(plane));
+    }
+}
+
+//======================================================================================================================
+
+void Frustum::Clear()
+{
+    mCenterX.clear();
+    mCenterY.clear();
+    mCenterZ.clear();
+    mRadius.clear();
+    mCount = 0;
+}
+
+//======================================================================================================================
+
+size_t Frustum::AddSphere(BoundingSphere const & sphere)
+{
+    mCenterX.emplace_back(sphere.center.x);
+    mCenterY.emplace_back(sphere.center.y);
+    mCenterZ.emplace_back(sphere.center.z);
+    mRadius.emplace_back(sphere.radius);
+    return mCount++;
+}
+
+//======================================================================================================================
+
+void Frustum::Cull()
+{
+    // pad to a whole number of SSE lanes, the padding results are ignored
+    size_t const paddedCount = (mCount + 3) & ~static_cast<size_t>(3);
+    mCenterX.resize(paddedCount, 0.0f);
+    mCenterY.resize(paddedCount, 0.0f);
+    mCenterZ.resize(paddedCount, 0.0f);
+    mRadius.resize(paddedCount, 0.0f);
+    mVisible.assign(paddedCount, 0);
+
+#if defined(FRUSTUM_USE_SSE)
+    for (size_t i = 0; i < paddedCount; i += 4)
+    {
+        __m128 const x = _mm_loadu_ps(&mCenterX[i]);
+        __m128 const y = _mm_loadu_ps(&mCenterY[i]);
+        __m128 const z = _mm_loadu_ps(&mCenterZ[i]);
+        __m128 const negativeRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(&mRadius[i]));
+
+        // a sphere is outside when it is completely behind any one plane
+        __m128 outside = _mm_setzero_ps();
+        for (auto const & plane : mPlanes)
+        {
+            __m128 distance = _mm_mul_ps(x, _mm_set1_ps(plane.x));
+            distance = _mm_add_ps(distance, _mm_mul_ps(y, _mm_set1_ps(plane.y)));
+            distance = _mm_add_ps(distance, _mm_mul_ps(z, _mm_set1_ps(plane.z)));
+            distance = _mm_add_ps(distance, _mm_set1_ps(plane.w));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, negativeRadius));
+        }
+
+        int const outsideMask = _mm_movemask_ps(outside);
+        for (int lane = 0; lane < 4; ++lane)
+        {
+            mVisible[i + lane] = (outsideMask & (1 << lane)) == 0 ? 1 : 0;
+        }
+    }
+#else
+    CullScalar(0, paddedCount);
+#endif
+
+    mStats.visible = 0;
+    for (size_t i = 0; i < mCount; ++i)
+    {
+        mStats.visible += mVisible[i];
+    }
+    mStats.culled = static_cast<int>(mCount) - mStats.visible;
+}
+
+//======================================================================================================================
+
+void Frustum::CullScalar(size_t const begin, size_t const end)
+{
+    for (size_t i = begin; i < end; ++i)
+    {
+        BoundingSphere const sphere{{mCenterX[i], mCenterY[i], mCenterZ[i]}, mRadius[i]};
+        mVisible[i] = Intersects(sphere) ? 1 : 0;
+    }
+}
+
+//======================================================================================================================
+
+bool Frustum::IsVisible(size_t const index) const
+{
+    assert(index < mCount);
+    return mVisible[index] != 0;
+}
+
+//======================================================================================================================
+
+bool Frustum::Intersects(BoundingSphere const & sphere) const
+{
+    for (auto const & plane : mPlanes)
+    {
+        if (glm::dot(glm::vec3(plane), sphere.center) + plane.w < -sphere.radius)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+//======================================================================================================================
+
+Frustum::Stats const & Frustum::GetStats() const
+{
+    return mStats;
+}
+
+//======================================================================================================================
@@ -0,0 +1,82 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// View frustum culling against bounding spheres. Spheres are stored as
+// structure-of-arrays so the test runs on four bodies at a time with SSE
+// (with a scalar fallback on other platforms).
+//------------------------------------------------------------------------------
+
+#include "Geometry.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+struct BoundingSphere
+{
+    glm::vec3 center {};
+    float radius = 0.0f;
+
+    // Smallest sphere around the AABB center that contains every position
+    [[nodiscard]]
+    static BoundingSphere FromPositions(std::vector<Position> const & positions);
+
+    // Moves the sphere into the space of the given matrix, growing the radius by the largest axis scale
+    [[nodiscard]]
+    BoundingSphere Transformed(glm::mat4 const & matrix) const;
+};
+
+class Frustum
+{
+public:
+
+    struct Stats
+    {
+        int visible = 0;
+        int culled = 0;
+    };
+
+    // Extracts the six planes from projection * view (Gribb/Hartmann)
+    void SetViewProjection(glm::mat4 const & viewProjection);
+
+    // Removes all spheres, call once per frame before adding them again
+    void Clear();
+
+    // Returns the index used by IsVisible
+    size_t AddSphere(BoundingSphere const & sphere);
+
+    // Tests every sphere added since Clear() against the frustum
+    void Cull();
+
+    [[nodiscard]]
+    bool IsVisible(size_t index) const;
+
+    // Conservative single sphere test, for callers outside of the batched path
+    [[nodiscard]]
+    bool Intersects(BoundingSphere const & sphere) const;
+
+    [[nodiscard]]
+    Stats const & GetStats() const;
+
+    [[nodiscard]]
+    glm::vec4 const & Plane(int index) const { return mPlanes[index]; }
+
+    static constexpr int PlaneCount = 6;
+
+private:
+
+    void CullScalar(size_t begin, size_t end);
+
+    glm::vec4 mPlanes[PlaneCount] {}; // xyz = inward normal, w = distance
+
+    // structure-of-arrays, padded to a multiple of 4 in Cull()
+    std::vector<float> mCenterX {};
+    std::vector<float> mCenterY {};
+    std::vector<float> mCenterZ {};
+    std::vector<float> mRadius {};
+    size_t mCount = 0;
+
+    std::vector<uint8_t> mVisible {};
+    Stats mStats {};
+};
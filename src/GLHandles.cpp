@@ -180,3 +180,73 @@ TextureHandle::operator GLuint() const {
 GLuint TextureHandle::value() const {
 	return textureID;
 }
+
+
+//------------------------------------------------------------------------------
+
+QueryHandle::QueryHandle()
+	: queryID(0) // Due to OpenGL syntax, we can't initial directly here, like we want.
+{
+	glGenQueries(1, &queryID);
+}
+
+
+QueryHandle::QueryHandle(QueryHandle&& other) noexcept
+	: queryID(std::move(other.queryID))
+{
+	other.queryID = 0;
+}
+
+QueryHandle& QueryHandle::operator=(QueryHandle&& other) noexcept {
+	std::swap(queryID, other.queryID);
+	return *this;
+}
+
+
+QueryHandle::~QueryHandle() {
+	glDeleteQueries(1, &queryID);
+}
+
+
+QueryHandle::operator GLuint() const {
+	return queryID;
+}
+
+
+GLuint QueryHandle::value() const {
+	return queryID;
+}
+
+
+FramebufferHandle::FramebufferHandle()
+	: framebufferID(0) // Due to OpenGL syntax, we can't initial directly here, like we want.
+{
+	glGenFramebuffers(1, &framebufferID);
+}
+
+
+FramebufferHandle::FramebufferHandle(FramebufferHandle&& other) noexcept
+	: framebufferID(std::move(other.framebufferID))
+{
+	other.framebufferID = 0;
+}
+
+FramebufferHandle& FramebufferHandle::operator=(FramebufferHandle&& other) noexcept {
+	std::swap(framebufferID, other.framebufferID);
+	return *this;
+}
+
+
+FramebufferHandle::~FramebufferHandle() {
+	glDeleteFramebuffers(1, &framebufferID);
+}
+
+
+FramebufferHandle::operator GLuint() const {
+	return framebufferID;
+}
+
+
+GLuint FramebufferHandle::value() const {
+	return framebufferID;
+}
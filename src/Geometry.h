@@ -25,7 +25,7 @@ struct CPU_Geometry {
     std::vector<Color> colors;
 	std::vector<Normal> normals;
     std::vector<UV> uvs;             // You need the uv for texture mapping
-    // std::vector<Index> indices;      // Index buffer (EBO) is needed for the bonuses
+    std::vector<Index> indices;      // required by MeshBuffer, GPU_Geometry draws without them
 };
 
 
@@ -0,0 +1,247 @@
+#include "GpuDrivenRenderer.hpp"
+
+#include "InstanceBuffer.h"
+#include "Log.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace
+{
+    // binding points of the storage blocks in cull_bodies.comp and body_gpu.vert
+    constexpr GLuint BodiesBinding = 0;
+    constexpr GLuint DrawCommandsBinding = 1;
+    constexpr GLuint DrawCountsBinding = 2;
+    constexpr GLuint RangeStartsBinding = 3;
+
+    template <typename T>
+    void UploadStorage(GLuint const buffer, std::vector<T> const & data)
+    {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+        glBufferData(
+            GL_SHADER_STORAGE_BUFFER,
+            static_cast<GLsizeiptr>(std::max<size_t>(sizeof(T) * data.size(), sizeof(T))),
+            data.empty() ? nullptr : data.data(),
+            GL_STATIC_DRAW
+        );
+    }
+
+    void ClearStorage(GLuint const buffer)
+    {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+        glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+    }
+}
+
+//======================================================================================================================
+
+bool GpuDrivenRenderer::IsSupported()
+{
+    return GLAD_GL_VERSION_4_3 != 0;
+}
+
+//======================================================================================================================
+
+bool GpuDrivenRenderer::HasDrawCount()
+{
+    return GLAD_GL_VERSION_4_6 != 0;
+}
+
+//======================================================================================================================
+
+GpuDrivenRenderer::GpuDrivenRenderer(MeshBuffer const & meshes)
+    : mMeshes(meshes)
+{
+    mCullProgram = std::make_unique<ComputeProgram>("shaders/cull_bodies.comp");
+    mBodyCountUniform = mCullProgram->uniform("body_count");
+    mFrustumCullingUniform = mCullProgram->uniform("frustum_culling");
+    mFrustumPlanesUniform = mCullProgram->uniform("frustum_planes");
+    mCameraPositionUniform = mCullProgram->uniform("camera_position");
+    mPixelScaleUniform = mCullProgram->uniform("pixel_scale");
+    mMinPixelRadiusUniform = mCullProgram->uniform("min_pixel_radius");
+
+    mHasDrawCount = HasDrawCount();
+    Log::info("GPU-driven rendering available, draw count from {}", mHasDrawCount ? "GPU buffer" : "cleared command slots");
+}
+
+//======================================================================================================================
+
+void GpuDrivenRenderer::SetBodies(std::vector<BodyDesc> const & bodies)
+{
+    // group bodies by state key, ranges in key order
+    std::vector<uint32_t> order(bodies.size());
+    std::iota(order.begin(), order.end(), 0u);
+    std::stable_sort(order.begin(), order.end(), [&bodies](uint32_t const a, uint32_t const b)->bool {
+        return bodies[a].stateKey < bodies[b].stateKey;
+    });
+
+    mRanges.clear();
+    std::vector<uint32_t> bodyRange(bodies.size(), 0);
+    for (uint32_t command = 0; command < static_cast<uint32_t>(order.size()); ++command)
+    {
+        BodyDesc const & body = bodies[order[command]];
+        if (mRanges.empty() || mRanges.back().stateKey != body.stateKey)
+        {
+            mRanges.emplace_back(DrawRange{body.stateKey, command, 0});
+        }
+        mRanges.back().maxDraws += 1;
+        bodyRange[order[command]] = static_cast<uint32_t>(mRanges.size() - 1);
+    }
+
+    mBodies.resize(bodies.size());
+    for (size_t i = 0; i < bodies.size(); ++i)
+    {
+        mBodies[i].modelMatrix = glm::mat4(1.0f);
+        mBodies[i].localBounds = glm::vec4(bodies[i].localBounds.center, bodies[i].localBounds.radius);
+        mBodies[i].drawInfo = glm::uvec4(bodyRange[i], bodies[i].textureLayer, 0u, glm::floatBitsToUint(bodies[i].emission));
+        mBodies[i].meshInfo = glm::uvec4(
+            static_cast<GLuint>(bodies[i].mesh.indexCount),
+            bodies[i].mesh.firstIndex,
+            static_cast<GLuint>(bodies[i].mesh.baseVertex),
+            0u
+        );
+    }
+
+    std::vector<GLuint> rangeStarts {};
+    for (auto const & range : mRanges)
+    {
+        rangeStarts.emplace_back(range.firstCommand);
+    }
+
+    std::vector<GLuint> bodyIndices(bodies.size());
+    std::iota(bodyIndices.begin(), bodyIndices.end(), 0u);
+
+    UploadStorage(mCommandBuffer, std::vector<DrawElementsIndirectCommand>(bodies.size(), DrawElementsIndirectCommand{}));
+    UploadStorage(mDrawCountBuffer, std::vector<GLuint>(mRanges.size(), 0u));
+    UploadStorage(mRangeStartBuffer, rangeStarts);
+    UploadStorage(mBodyIndexBuffer, bodyIndices);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    mStats.bodies = static_cast<int>(mBodies.size());
+    mStats.ranges = static_cast<int>(mRanges.size());
+}
+
+//======================================================================================================================
+
+void GpuDrivenRenderer::SetModelMatrix(size_t const bodyIndex, glm::mat4 const & modelMatrix)
+{
+    mBodies[bodyIndex].modelMatrix = modelMatrix;
+}
+
+//======================================================================================================================
+
+void GpuDrivenRenderer::SetEclipseMask(size_t const bodyIndex, uint32_t const mask)
+{
+    mBodies[bodyIndex].drawInfo.z = mask;
+}
+
+//======================================================================================================================
+
+void GpuDrivenRenderer::Cull(
+    RingBuffer & ring,
+    Frustum const & frustum,
+    bool const frustumCulling,
+    float const minPixelRadius,
+    glm::mat4 const & projectionMatrix,
+    glm::vec3 const & cameraPosition,
+    int const viewportHeight
+)
+{
+    mStats.multiDraws = 0;
+    if (mBodies.empty())
+    {
+        return;
+    }
+
+    // the previous frames' draws read other regions of the ring, nothing waits here
+    auto const bodyBytes = static_cast<GLsizeiptr>(sizeof(GpuBody) * mBodies.size());
+    RingBuffer::Allocation const bodies = ring.upload(mBodies.data(), bodyBytes, RingBuffer::bindAlignment());
+
+    ClearStorage(mDrawCountBuffer);
+    if (mHasDrawCount == false)
+    {
+        // without a GPU draw count every slot is drawn, the unused ones must have no instances
+        ClearStorage(mCommandBuffer);
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    glBindBufferRange(GL_SHADER_STORAGE_BUFFER, BodiesBinding, ring.getID(), bodies.offset, bodies.size);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DrawCommandsBinding, mCommandBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DrawCountsBinding, mDrawCountBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, RangeStartsBinding, mRangeStartBuffer);
+
+    glm::vec4 planes[Frustum::PlaneCount];
+    for (int i = 0; i < Frustum::PlaneCount; ++i)
+    {
+        planes[i] = frustum.Plane(i);
+    }
+
+    mCullProgram->use();
+    mCullProgram->set(mBodyCountUniform, static_cast<GLuint>(mBodies.size()));
+    mCullProgram->set(mFrustumCullingUniform, frustumCulling ? 1 : 0);
+    mCullProgram->set(mFrustumPlanesUniform, planes, Frustum::PlaneCount);
+    mCullProgram->set(mCameraPositionUniform, cameraPosition);
+    mCullProgram->set(mPixelScaleUniform, projectionMatrix[1][1] * static_cast<float>(viewportHeight) * 0.5f);
+    mCullProgram->set(mMinPixelRadiusUniform, minPixelRadius);
+    mCullProgram->dispatch(static_cast<GLuint>(mBodies.size()));
+
+    // the draws read the commands and counts the shader just wrote
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+//======================================================================================================================
+
+GLsizeiptr GpuDrivenRenderer::FrameUploadSize() const
+{
+    return static_cast<GLsizeiptr>(sizeof(GpuBody) * mBodies.size()) + RingBuffer::bindAlignment();
+}
+
+//======================================================================================================================
+
+void GpuDrivenRenderer::Draw(size_t const rangeIndex)
+{
+    DrawRange const & range = mRanges[rangeIndex];
+
+    mMeshes.Bind();
+
+    // The VAO is shared with the instanced path. Its per-instance attributes are not read here,
+    // but turn them off so large baseInstance values never point past the end of that buffer.
+    for (GLuint location = InstanceBuffer::ModelMatrixLocation; location <= InstanceBuffer::MaterialLocation; ++location)
+    {
+        glDisableVertexAttribArray(location);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, mBodyIndexBuffer);
+    glVertexAttribIPointer(BodyIndexLocation, 1, GL_UNSIGNED_INT, sizeof(GLuint), nullptr);
+    glVertexAttribDivisor(BodyIndexLocation, 1);
+    glEnableVertexAttribArray(BodyIndexLocation);
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, mCommandBuffer);
+    auto const * const firstCommand = reinterpret_cast<void const *>(
+        static_cast<uintptr_t>(range.firstCommand) * sizeof(DrawElementsIndirectCommand)
+    );
+
+    if (mHasDrawCount)
+    {
+        glBindBuffer(GL_PARAMETER_BUFFER, mDrawCountBuffer);
+        glMultiDrawElementsIndirectCount(
+            GL_TRIANGLES,
+            GL_UNSIGNED_INT,
+            firstCommand,
+            static_cast<GLintptr>(rangeIndex * sizeof(GLuint)),
+            static_cast<GLsizei>(range.maxDraws),
+            0
+        );
+    }
+    else
+    {
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, firstCommand, static_cast<GLsizei>(range.maxDraws), 0);
+    }
+    mStats.multiDraws += 1;
+
+    // the instanced path draws with the same VAO and does not know about this attribute
+    glDisableVertexAttribArray(BodyIndexLocation);
+    glVertexAttribDivisor(BodyIndexLocation, 0);
+}
+
+//======================================================================================================================
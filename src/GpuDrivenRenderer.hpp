@@ -0,0 +1,148 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Optional GL 4.3+ render path where the GPU decides what gets drawn. Body
+// transforms live in a shader storage buffer, a compute shader frustum- and
+// size-culls them and writes one DrawElementsIndirectCommand per visible
+// body, and every draw range (bodies sharing program and texture array) is
+// submitted with a single multi-draw. All meshes live in one MeshBuffer, so a
+// range can span meshes. On GL 4.6 the draw count is read
+// from a GPU buffer (glMultiDrawElementsIndirectCount); before that the
+// command buffer is cleared every frame and culled slots draw nothing.
+//
+// The CPU work per frame is one buffer upload, one dispatch and one call per
+// draw range, whatever the number of bodies.
+//------------------------------------------------------------------------------
+
+#include "ComputeProgram.h"
+#include "Frustum.hpp"
+#include "GLHandles.h"
+#include "MeshBuffer.hpp"
+#include "RingBuffer.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class GpuDrivenRenderer
+{
+public:
+
+    // What the renderer needs to know about a body, once
+    struct BodyDesc
+    {
+        uint64_t stateKey;          // render queue key without depth, bodies with equal keys share a draw range
+        MeshBuffer::Mesh mesh;
+        BoundingSphere localBounds;
+        uint32_t textureLayer;
+        float emission;
+    };
+
+    // A run of commands drawn with one multi-draw call
+    struct DrawRange
+    {
+        uint64_t stateKey;
+        uint32_t firstCommand;
+        uint32_t maxDraws;          // bodies in the range, the most the culling can emit
+    };
+
+    struct Stats
+    {
+        int bodies = 0;
+        int ranges = 0;
+        int multiDraws = 0;
+    };
+
+    // Compute shaders, storage buffers and indirect draws
+    [[nodiscard]]
+    static bool IsSupported();
+
+    // glMultiDrawElementsIndirectCount, core since 4.6
+    [[nodiscard]]
+    static bool HasDrawCount();
+
+    explicit GpuDrivenRenderer(MeshBuffer const & meshes);
+
+    // Rebuilds the draw ranges and the static buffers, call whenever bodies are added or change state
+    // and after the mesh buffer is defragmented
+    void SetBodies(std::vector<BodyDesc> const & bodies);
+
+    void SetModelMatrix(size_t bodyIndex, glm::mat4 const & modelMatrix);
+
+    // Bits of the occluders in the Eclipses block that can shadow the body, see EclipseShadows
+    void SetEclipseMask(size_t bodyIndex, uint32_t mask);
+
+    // Uploads the transforms into this frame's region of the ring and runs the culling shader.
+    // Bodies whose projected radius is below minPixelRadius are dropped as well.
+    void Cull(
+        RingBuffer & ring,
+        Frustum const & frustum,
+        bool frustumCulling,
+        float minPixelRadius,
+        glm::mat4 const & projectionMatrix,
+        glm::vec3 const & cameraPosition,
+        int viewportHeight
+    );
+
+    // Ranges are sorted by state key, so drawing them in order needs the fewest state changes
+    [[nodiscard]]
+    std::vector<DrawRange> const & GetRanges() const { return mRanges; }
+
+    // Binds the mesh buffer and issues the range's multi-draw. The program and texture must be bound already.
+    void Draw(size_t rangeIndex);
+
+    [[nodiscard]]
+    Stats const & GetStats() const { return mStats; }
+
+    // Bytes Cull() takes from the ring every frame
+    [[nodiscard]]
+    GLsizeiptr FrameUploadSize() const;
+
+    static constexpr GLuint BodyIndexLocation = 8;
+
+private:
+
+    // std430 layout of Body in cull_bodies.comp and body_gpu.vert
+    struct GpuBody
+    {
+        glm::mat4 modelMatrix;
+        glm::vec4 localBounds;
+        glm::uvec4 drawInfo;    // x = draw range, y = texture layer, z = eclipse occluder mask, w = emission bits
+        glm::uvec4 meshInfo;    // x = index count, y = first index, z = base vertex
+    };
+    static_assert(sizeof(GpuBody) == 112, "GpuBody must match the std430 layout");
+
+    struct DrawElementsIndirectCommand
+    {
+        GLuint count;
+        GLuint instanceCount;
+        GLuint firstIndex;
+        GLint baseVertex;
+        GLuint baseInstance;
+    };
+    static_assert(sizeof(DrawElementsIndirectCommand) == 20, "indirect commands are five tightly packed integers");
+
+    MeshBuffer const & mMeshes;
+
+    std::unique_ptr<ComputeProgram> mCullProgram {};
+    ComputeProgram::Uniform mBodyCountUniform {};
+    ComputeProgram::Uniform mFrustumCullingUniform {};
+    ComputeProgram::Uniform mFrustumPlanesUniform {};
+    ComputeProgram::Uniform mCameraPositionUniform {};
+    ComputeProgram::Uniform mPixelScaleUniform {};
+    ComputeProgram::Uniform mMinPixelRadiusUniform {};
+
+    bool mHasDrawCount = false;
+
+    std::vector<GpuBody> mBodies {};
+    std::vector<DrawRange> mRanges {};
+
+    VertexBufferHandle mCommandBuffer {};     // DrawElementsIndirectCommand per body, grouped by range
+    VertexBufferHandle mDrawCountBuffer {};   // one counter per range
+    VertexBufferHandle mRangeStartBuffer {};  // first command of each range
+    VertexBufferHandle mBodyIndexBuffer {};   // 0, 1, 2, ... read with divisor 1, so baseInstance picks the body
+
+    Stats mStats {};
+};
@@ -0,0 +1,311 @@
+#include "GpuProfiler.hpp"
+
+#include "Log.h"
+
+#include <algorithm>
+#include <fstream>
+#include <limits>
+
+namespace
+{
+    constexpr float Smoothing = 0.1f;
+
+    // scope names are identifiers, but keep the file valid whatever they are
+    std::string JsonString(std::string const & text)
+    {
+        std::string result = "\"";
+        for (char const character : text)
+        {
+            if (character == '"' || character == '\\')
+            {
+                result += '\\';
+            }
+            result += character;
+        }
+        return result + "\"";
+    }
+}
+
+//======================================================================================================================
+
+GpuProfiler::Scope::Scope(GpuProfiler & profiler, std::string const & name)
+    : mProfiler(profiler)
+{
+    mProfiler.Begin(name);
+}
+
+//======================================================================================================================
+
+GpuProfiler::Scope::~Scope()
+{
+    mProfiler.End();
+}
+
+//======================================================================================================================
+
+GpuProfiler::GpuProfiler() = default;
+
+//======================================================================================================================
+
+void GpuProfiler::BeginFrame()
+{
+    if (mInFrame)
+    {
+        EndFrame();
+    }
+
+    Frame & frame = mFrames[mFrameIndex];
+    Resolve(frame, false);
+    frame.usedQueries = 0;
+    frame.markers.clear();
+    frame.number = mFrameNumber;
+    mInFrame = true;
+}
+
+//======================================================================================================================
+
+void GpuProfiler::EndFrame()
+{
+    if (mInFrame == false)
+    {
+        return;
+    }
+
+    if (mOpen.empty() == false)
+    {
+        Log::warn("GPU profiler: {} scope(s) still open at the end of the frame, innermost {}", mOpen.size(), mOpenPath);
+        while (mOpen.empty() == false)
+        {
+            End();
+        }
+    }
+
+    mStats.queries = static_cast<int>(mFrames[mFrameIndex].usedQueries);
+    mInFrame = false;
+    mFrameIndex = (mFrameIndex + 1) % Latency;
+    mFrameNumber += 1;
+}
+
+//======================================================================================================================
+
+void GpuProfiler::Begin(std::string const & name)
+{
+    if (mInFrame == false)
+    {
+        return;
+    }
+
+    mOpenPath = mOpen.empty() ? name : mOpenPath + "/" + name;
+
+    Frame & frame = mFrames[mFrameIndex];
+    Marker marker {};
+    marker.scope = FindScope(name);
+    marker.begin = WriteTimestamp();
+    mOpen.push_back(frame.markers.size());
+    frame.markers.push_back(marker);
+}
+
+//======================================================================================================================
+
+void GpuProfiler::End()
+{
+    if (mInFrame == false || mOpen.empty())
+    {
+        return;
+    }
+
+    Frame & frame = mFrames[mFrameIndex];
+    Marker & marker = frame.markers[mOpen.back()];
+    marker.end = WriteTimestamp();
+    mOpen.pop_back();
+
+    // back to the parent's path
+    size_t const name_length = mScopes[marker.scope].name.size();
+    mOpenPath.resize(mOpen.empty() ? 0 : mOpenPath.size() - name_length - 1);
+}
+
+//======================================================================================================================
+
+void GpuProfiler::Flush()
+{
+    EndFrame();
+
+    // oldest first, mFrameIndex is the pool written longest ago
+    for (int offset = 0; offset < Latency; ++offset)
+    {
+        Frame & frame = mFrames[(mFrameIndex + offset) % Latency];
+        Resolve(frame, true);
+        frame.usedQueries = 0;
+        frame.markers.clear();
+    }
+}
+
+//======================================================================================================================
+
+uint32_t GpuProfiler::WriteTimestamp()
+{
+    Frame & frame = mFrames[mFrameIndex];
+    if (frame.usedQueries == frame.queries.size())
+    {
+        frame.queries.emplace_back();
+    }
+    glQueryCounter(frame.queries[frame.usedQueries], GL_TIMESTAMP);
+    return frame.usedQueries++;
+}
+
+//======================================================================================================================
+
+uint32_t GpuProfiler::FindScope(std::string const & name)
+{
+    auto const [found, inserted] = mScopeIndices.try_emplace(mOpenPath, static_cast<uint32_t>(mScopes.size()));
+    if (inserted)
+    {
+        ScopeStats scope {};
+        scope.path = mOpenPath;
+        scope.name = name;
+        scope.depth = static_cast<int>(mOpen.size());
+        scope.history.assign(HistoryLength, 0.0f);
+        mScopes.push_back(std::move(scope));
+    }
+    return found->second;
+}
+
+//======================================================================================================================
+
+// Timestamps complete in order, so once the last one of the frame is available all of them are
+void GpuProfiler::Resolve(Frame & frame, bool const wait)
+{
+    if (frame.markers.empty())
+    {
+        return;
+    }
+
+    // otherwise reading GL_QUERY_RESULT below blocks until the GPU gets there
+    if (wait == false)
+    {
+        GLuint available = GL_FALSE;
+        glGetQueryObjectuiv(frame.queries[frame.usedQueries - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available == GL_FALSE)
+        {
+            mStats.droppedFrames += 1;
+            return;
+        }
+    }
+
+    std::vector<GLuint64> timestamps(frame.usedQueries);
+    for (uint32_t query = 0; query < frame.usedQueries; ++query)
+    {
+        glGetQueryObjectui64v(frame.queries[query], GL_QUERY_RESULT, &timestamps[query]);
+    }
+
+    RecordedFrame recorded {};
+    recorded.number = frame.number;
+    mLastOrder.clear();
+    GLuint64 first = std::numeric_limits<GLuint64>::max();
+    GLuint64 last = 0;
+    for (Marker const & marker : frame.markers)
+    {
+        GLuint64 const begin = timestamps[marker.begin];
+        GLuint64 const end = std::max(timestamps[marker.end], begin);
+        first = std::min(first, begin);
+        last = std::max(last, end);
+        float const milliseconds = static_cast<float>(end - begin) * 1.0e-6f;
+
+        ScopeStats & scope = mScopes[marker.scope];
+        scope.ms = scope.samples == 0 ? milliseconds : scope.ms + (milliseconds - scope.ms) * Smoothing;
+        scope.lastMs = milliseconds;
+        scope.samples += 1;
+        scope.history[scope.historyNext] = milliseconds;
+        scope.historyNext = (scope.historyNext + 1) % HistoryLength;
+
+        mLastOrder.push_back(marker.scope);
+        recorded.times.emplace_back(marker.scope, milliseconds);
+    }
+
+    float const frame_ms = static_cast<float>(last - first) * 1.0e-6f;
+    mStats.frameMs = mStats.resolvedFrames == 0 ? frame_ms : mStats.frameMs + (frame_ms - mStats.frameMs) * Smoothing;
+    mStats.resolvedFrames += 1;
+
+    mRecorded.push_back(std::move(recorded));
+    if (mRecorded.size() > RecordLength)
+    {
+        mRecorded.pop_front();
+    }
+}
+
+//======================================================================================================================
+
+float GpuProfiler::GetTime(std::string const & path) const
+{
+    auto const found = mScopeIndices.find(path);
+    return found != mScopeIndices.end() ? mScopes[found->second].ms : 0.0f;
+}
+
+//======================================================================================================================
+
+std::vector<GpuProfiler::ScopeStats const *> GpuProfiler::GetScopes() const
+{
+    std::vector<ScopeStats const *> scopes {};
+    scopes.reserve(mLastOrder.size());
+    for (uint32_t const scope : mLastOrder)
+    {
+        scopes.push_back(&mScopes[scope]);
+    }
+    return scopes;
+}
+
+//======================================================================================================================
+
+bool GpuProfiler::ExportCsv(std::string const & path) const
+{
+    std::ofstream file(path, std::ios::trunc);
+    file << "frame,path,depth,ms\n";
+    for (auto const & frame : mRecorded)
+    {
+        for (auto const & [scope, milliseconds] : frame.times)
+        {
+            file << frame.number << ',' << mScopes[scope].path << ',' << mScopes[scope].depth << ',' << milliseconds << '\n';
+        }
+    }
+
+    if (file.good() == false)
+    {
+        Log::error("Could not write the GPU profile to {}", path);
+        return false;
+    }
+    Log::info("GPU profile of {} frames written to {}", mRecorded.size(), path);
+    return true;
+}
+
+//======================================================================================================================
+
+bool GpuProfiler::ExportJson(std::string const & path) const
+{
+    std::ofstream file(path, std::ios::trunc);
+    file << "{\n  \"frames\": [";
+    bool first_frame = true;
+    for (auto const & frame : mRecorded)
+    {
+        file << (first_frame ? "\n" : ",\n") << "    {\"frame\": " << frame.number << ", \"scopes\": [";
+        first_frame = false;
+        bool first_scope = true;
+        for (auto const & [scope, milliseconds] : frame.times)
+        {
+            file << (first_scope ? "" : ", ") << "{\"path\": " << JsonString(mScopes[scope].path)
+                << ", \"depth\": " << mScopes[scope].depth << ", \"ms\": " << milliseconds << "}";
+            first_scope = false;
+        }
+        file << "]}";
+    }
+    file << "\n  ]\n}\n";
+
+    if (file.good() == false)
+    {
+        Log::error("Could not write the GPU profile to {}", path);
+        return false;
+    }
+    Log::info("GPU profile of {} frames written to {}", mRecorded.size(), path);
+    return true;
+}
+
+//======================================================================================================================
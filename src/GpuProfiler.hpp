@@ -0,0 +1,151 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// GPU timing of named, nestable scopes. Every Begin() and End() writes a
+// GL_TIMESTAMP query (glQueryCounter), so scopes can nest freely, which
+// GL_TIME_ELAPSED queries can not. The queries of a frame come from a pool
+// that is only read again Latency frames later, when the GPU has normally
+// long finished them; a frame whose results are still not there is dropped
+// instead of waited for. Only Flush() waits, for the frames still in flight
+// when profiling ends.
+//
+// Results are kept per scope path ("scene/draw"): a smoothed time for the
+// budgets and the UI, a short history for graphs, and the last RecordLength
+// frames for export as CSV or JSON.
+//------------------------------------------------------------------------------
+
+#include "GLHandles.h"
+
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+class GpuProfiler
+{
+public:
+
+    static constexpr int Latency = 3;           // frames between writing a frame's queries and reading them
+    static constexpr int HistoryLength = 240;   // samples per scope for the graphs
+    static constexpr int RecordLength = 1000;   // frames kept for export
+
+    struct ScopeStats
+    {
+        std::string path {};        // names of the enclosing scopes and its own, joined by '/'
+        std::string name {};
+        int depth = 0;
+        float ms = 0.0f;            // smoothed
+        float lastMs = 0.0f;
+        uint64_t samples = 0;
+        std::vector<float> history {};  // ring of HistoryLength samples, the oldest at historyNext
+        int historyNext = 0;
+    };
+
+    struct Stats
+    {
+        uint64_t resolvedFrames = 0;
+        uint64_t droppedFrames = 0;     // results were not ready after Latency frames
+        int queries = 0;                // written in the last frame
+        float frameMs = 0.0f;           // smoothed, first to last timestamp of a frame
+    };
+
+    // Begins a scope on construction and ends it on destruction
+    class Scope
+    {
+    public:
+
+        explicit Scope(GpuProfiler & profiler, std::string const & name);
+
+        ~Scope();
+
+        Scope(Scope const &) = delete;
+        Scope & operator=(Scope const &) = delete;
+
+    private:
+
+        GpuProfiler & mProfiler;
+    };
+
+    explicit GpuProfiler();
+
+    // Reads the results of the frame Latency frames ago and starts writing this one's
+    void BeginFrame();
+
+    // Closes scopes that were left open
+    void EndFrame();
+
+    void Begin(std::string const & name);
+
+    void End();
+
+    // Waits for the frames still in flight and reads their results, e.g. before the final export
+    void Flush();
+
+    // Smoothed time of a scope, 0 until its first result arrives
+    [[nodiscard]]
+    float GetTime(std::string const & path) const;
+
+    // In the order they were opened in the last resolved frame
+    [[nodiscard]]
+    std::vector<ScopeStats const *> GetScopes() const;
+
+    [[nodiscard]]
+    Stats const & GetStats() const { return mStats; }
+
+    // The recorded frames, one line per frame and scope. Return false when the file can not be written.
+    bool ExportCsv(std::string const & path) const;
+
+    bool ExportJson(std::string const & path) const;
+
+private:
+
+    struct Marker
+    {
+        uint32_t scope = 0;     // index into mScopes
+        uint32_t begin = 0;     // query indices in the frame's pool
+        uint32_t end = 0;
+    };
+
+    struct Frame
+    {
+        std::vector<QueryHandle> queries {};    // grows to the most a frame ever used
+        uint32_t usedQueries = 0;
+        std::vector<Marker> markers {};
+        uint64_t number = 0;
+    };
+
+    struct RecordedFrame
+    {
+        uint64_t number = 0;
+        std::vector<std::pair<uint32_t, float>> times {};   // scope and milliseconds, in opening order
+    };
+
+    [[nodiscard]]
+    uint32_t WriteTimestamp();
+
+    // Index of the scope with this path, created on first use
+    [[nodiscard]]
+    uint32_t FindScope(std::string const & name);
+
+    // Reads a frame's results into the stats, waiting for them when wait is set, otherwise dropping the
+    // frame if they are not ready
+    void Resolve(Frame & frame, bool wait);
+
+    Frame mFrames[Latency] {};
+    int mFrameIndex = 0;
+    uint64_t mFrameNumber = 0;
+    bool mInFrame = false;
+
+    // scopes open in the current frame, as indices into its markers
+    std::vector<size_t> mOpen {};
+    std::string mOpenPath {};
+
+    std::vector<ScopeStats> mScopes {};
+    std::map<std::string, uint32_t> mScopeIndices {};
+    std::vector<uint32_t> mLastOrder {};
+    std::deque<RecordedFrame> mRecorded {};
+
+    Stats mStats {};
+};
@@ -0,0 +1,42 @@
+#include "InstanceBuffer.h"
+
+#include <cstddef>
+
+//======================================================================================================================
+
+InstanceBuffer::InstanceBuffer(RingBuffer& ring)
+	: ring(ring)
+	, allocation{}
+{
+}
+
+void InstanceBuffer::uploadData(const std::vector<InstanceData>& instances) {
+	GLsizeiptr const size = static_cast<GLsizeiptr>(sizeof(InstanceData) * instances.size());
+	allocation = ring.upload(instances.data(), size, sizeof(glm::vec4));
+}
+
+void InstanceBuffer::bindAttributes(GLsizei firstInstance) const {
+	bind();
+	GLsizei const stride = sizeof(InstanceData);
+	size_t const base = static_cast<size_t>(allocation.offset) + sizeof(InstanceData) * static_cast<size_t>(firstInstance);
+
+	// a mat4 attribute is four vec4 columns
+	for (GLuint column = 0; column < 4; ++column) {
+		GLuint const location = ModelMatrixLocation + column;
+		size_t const offset = base + offsetof(InstanceData, modelMatrix) + sizeof(glm::vec4) * column;
+		glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void*>(offset));
+		glVertexAttribDivisor(location, 1);
+		glEnableVertexAttribArray(location);
+	}
+
+	size_t const materialOffset = base + offsetof(InstanceData, material);
+	glVertexAttribIPointer(MaterialLocation, 4, GL_UNSIGNED_INT, stride, reinterpret_cast<void*>(materialOffset));
+	glVertexAttribDivisor(MaterialLocation, 1);
+	glEnableVertexAttribArray(MaterialLocation);
+}
+
+GLsizeiptr InstanceBuffer::frameSize(size_t instanceCount) {
+	return static_cast<GLsizeiptr>(sizeof(InstanceData) * instanceCount + sizeof(glm::vec4));
+}
+
+//======================================================================================================================
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "RingBuffer.h"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+
+// Per-instance vertex attributes for glDraw*Instanced.
+//
+// Every instance of the frame is uploaded once into this frame's region of the shared RingBuffer.
+// GL 3.3 has no base instance, so each batch re-points the instanced attributes of the bound VAO
+// at its own first instance.
+class InstanceBuffer {
+
+public:
+	// Matches the instance_* attributes in test.vert and sphere_procedural.vert
+	struct InstanceData {
+		glm::mat4 modelMatrix;
+		glm::uvec4 material; // x = material index, y = texture layer, z = eclipse occluder mask, w = emission (float bits)
+	};
+
+	static constexpr GLuint ModelMatrixLocation = 3; // takes locations 3 to 6
+	static constexpr GLuint MaterialLocation = 7;
+
+	explicit InstanceBuffer(RingBuffer& ring);
+
+	// Only refers to the ring, which owns the storage. Rule of zero
+	//
+	// https://en.cppreference.com/w/cpp/language/rule_of_three
+	// https://github.com/isocpp/CppCoreGuidelines/blob/master/CppCoreGuidelines.md#Rc-zero
+
+	// Public interface
+	void bind() const { glBindBuffer(GL_ARRAY_BUFFER, ring.getID()); }
+
+	// Must be called between the ring's beginFrame and endFrame
+	void uploadData(const std::vector<InstanceData>& instances);
+
+	// Sets up the instanced attributes of the currently bound VAO, starting at firstInstance
+	void bindAttributes(GLsizei firstInstance) const;
+
+	// Bytes a frame with instanceCount instances takes from the ring, alignment included
+	static GLsizeiptr frameSize(size_t instanceCount);
+
+private:
+	RingBuffer& ring;
+	RingBuffer::Allocation allocation;
+};
@@ -0,0 +1,237 @@
+#include "LinkedProgram.h"
+
+#include <string>
+#include <utility>
+
+#include "Log.h"
+#include "UniformBlocks.hpp"
+
+namespace {
+// How a uniform's value is read back and set again: the component type and count
+enum class ValueKind { Float, Int, UnsignedInt, Matrix };
+struct ValueType {
+  ValueKind kind;
+  int components; // columns of a (square) matrix
+};
+
+ValueType valueType(GLenum type) {
+  switch (type) {
+  case GL_FLOAT: return {ValueKind::Float, 1};
+  case GL_FLOAT_VEC2: return {ValueKind::Float, 2};
+  case GL_FLOAT_VEC3: return {ValueKind::Float, 3};
+  case GL_FLOAT_VEC4: return {ValueKind::Float, 4};
+  case GL_FLOAT_MAT2: return {ValueKind::Matrix, 2};
+  case GL_FLOAT_MAT3: return {ValueKind::Matrix, 3};
+  case GL_FLOAT_MAT4: return {ValueKind::Matrix, 4};
+  case GL_INT_VEC2:
+  case GL_BOOL_VEC2: return {ValueKind::Int, 2};
+  case GL_INT_VEC3:
+  case GL_BOOL_VEC3: return {ValueKind::Int, 3};
+  case GL_INT_VEC4:
+  case GL_BOOL_VEC4: return {ValueKind::Int, 4};
+  case GL_UNSIGNED_INT: return {ValueKind::UnsignedInt, 1};
+  case GL_UNSIGNED_INT_VEC2: return {ValueKind::UnsignedInt, 2};
+  case GL_UNSIGNED_INT_VEC3: return {ValueKind::UnsignedInt, 3};
+  case GL_UNSIGNED_INT_VEC4: return {ValueKind::UnsignedInt, 4};
+  // int and bool, and the samplers and images, whose value is a unit.
+  // No shader here uses non-square matrices or doubles.
+  default: return {ValueKind::Int, 1};
+  }
+}
+
+void copyValue(GLuint source, GLint sourceLocation, GLint location,
+               ValueType type) {
+  switch (type.kind) {
+  case ValueKind::Float: {
+    GLfloat value[4]{};
+    glGetUniformfv(source, sourceLocation, value);
+    if (type.components == 1) glUniform1fv(location, 1, value);
+    if (type.components == 2) glUniform2fv(location, 1, value);
+    if (type.components == 3) glUniform3fv(location, 1, value);
+    if (type.components == 4) glUniform4fv(location, 1, value);
+    break;
+  }
+  case ValueKind::Matrix: {
+    GLfloat value[16]{};
+    glGetUniformfv(source, sourceLocation, value);
+    if (type.components == 2) glUniformMatrix2fv(location, 1, GL_FALSE, value);
+    if (type.components == 3) glUniformMatrix3fv(location, 1, GL_FALSE, value);
+    if (type.components == 4) glUniformMatrix4fv(location, 1, GL_FALSE, value);
+    break;
+  }
+  case ValueKind::Int: {
+    GLint value[4]{};
+    glGetUniformiv(source, sourceLocation, value);
+    if (type.components == 1) glUniform1iv(location, 1, value);
+    if (type.components == 2) glUniform2iv(location, 1, value);
+    if (type.components == 3) glUniform3iv(location, 1, value);
+    if (type.components == 4) glUniform4iv(location, 1, value);
+    break;
+  }
+  case ValueKind::UnsignedInt: {
+    GLuint value[4]{};
+    glGetUniformuiv(source, sourceLocation, value);
+    if (type.components == 1) glUniform1uiv(location, 1, value);
+    if (type.components == 2) glUniform2uiv(location, 1, value);
+    if (type.components == 3) glUniform3uiv(location, 1, value);
+    if (type.components == 4) glUniform4uiv(location, 1, value);
+    break;
+  }
+  }
+}
+} // namespace
+
+LinkedProgram::LinkedProgram(std::string kind) : kind(std::move(kind)) {}
+
+bool LinkedProgram::link(GLuint program) {
+  glLinkProgram(program);
+  if (!checkAndLogLinkSuccess(program)) {
+    return false;
+  }
+  reflect(program);
+  return true;
+}
+
+LinkedProgram::Uniform LinkedProgram::uniform(const std::string &name,
+                                              bool warnIfMissing) {
+  for (size_t slot = 0; slot < slotNames.size(); ++slot) {
+    if (slotNames[slot] == name) {
+      return Uniform{static_cast<int>(slot)};
+    }
+  }
+
+  auto const found = uniforms.find(name);
+  if (found == uniforms.end() && warnIfMissing) {
+    Log::warn("{} {} has no active uniform \"{}\"", kind, this->name, name);
+  }
+
+  slotNames.push_back(name);
+  slotLocations.push_back(found != uniforms.end() ? found->second.location
+                                                  : -1);
+  return Uniform{static_cast<int>(slotNames.size() - 1)};
+}
+
+GLuint LinkedProgram::uniformBlock(const std::string &name) const {
+  auto const found = uniformBlocks.find(name);
+  return found != uniformBlocks.end() ? found->second : GL_INVALID_INDEX;
+}
+
+void LinkedProgram::reflect(GLuint program) {
+  uniforms.clear();
+  uniformBlocks.clear();
+
+  GLint uniformCount = 0;
+  GLint maxNameLength = 0;
+  glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &uniformCount);
+  glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+  std::vector<char> name(static_cast<size_t>(maxNameLength) + 1);
+
+  for (GLint i = 0; i < uniformCount; ++i) {
+    GLsizei nameLength = 0;
+    UniformInfo info{};
+    glGetActiveUniform(program, static_cast<GLuint>(i),
+                       static_cast<GLsizei>(name.size()), &nameLength,
+                       &info.size, &info.type, name.data());
+    std::string uniformName(name.data(), static_cast<size_t>(nameLength));
+
+    // members of uniform blocks have no location, they are set through the block
+    info.location = glGetUniformLocation(program, uniformName.c_str());
+    if (info.location < 0) {
+      continue;
+    }
+
+    // arrays are reported as "name[0]", register them under their plain name
+    auto const arraySuffix = uniformName.rfind("[0]");
+    if (arraySuffix != std::string::npos &&
+        arraySuffix + 3 == uniformName.size()) {
+      uniformName.erase(arraySuffix);
+    }
+    uniforms[uniformName] = info;
+  }
+
+  GLint blockCount = 0;
+  GLint maxBlockNameLength = 0;
+  glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCKS, &blockCount);
+  glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH,
+                 &maxBlockNameLength);
+  std::vector<char> blockName(static_cast<size_t>(maxBlockNameLength) + 1);
+
+  for (GLint i = 0; i < blockCount; ++i) {
+    GLsizei nameLength = 0;
+    glGetActiveUniformBlockName(program, static_cast<GLuint>(i),
+                                static_cast<GLsizei>(blockName.size()),
+                                &nameLength, blockName.data());
+    uniformBlocks[std::string(blockName.data(),
+                              static_cast<size_t>(nameLength))] =
+        static_cast<GLuint>(i);
+  }
+
+  // shared blocks always live at the same binding point, whatever the program
+  for (auto const &binding : UniformBlocks::Bindings) {
+    GLuint const blockIndex = uniformBlock(binding.name);
+    if (blockIndex != GL_INVALID_INDEX) {
+      glUniformBlockBinding(program, blockIndex, binding.point);
+    }
+  }
+}
+
+void LinkedProgram::resolveSlots() {
+  slotLocations.assign(slotNames.size(), -1);
+  for (size_t slot = 0; slot < slotNames.size(); ++slot) {
+    auto const found = uniforms.find(slotNames[slot]);
+    if (found != uniforms.end()) {
+      slotLocations[slot] = found->second.location;
+    }
+  }
+}
+
+void LinkedProgram::copyUniformValues(const LinkedProgram &sourceProgram,
+                                      GLuint source, GLuint program) const {
+  GLint previousProgram = 0;
+  glGetIntegerv(GL_CURRENT_PROGRAM, &previousProgram);
+  glUseProgram(program);
+
+  for (const auto &name : slotNames) {
+    auto const from = sourceProgram.uniforms.find(name);
+    auto const to = uniforms.find(name);
+    if (from == sourceProgram.uniforms.end() || to == uniforms.end() ||
+        from->second.type != to->second.type ||
+        from->second.size != to->second.size) {
+      continue;
+    }
+
+    ValueType const type = valueType(to->second.type);
+    if (to->second.size == 1) {
+      copyValue(source, from->second.location, to->second.location, type);
+      continue;
+    }
+    // array elements are not guaranteed to have consecutive locations
+    for (GLint element = 0; element < to->second.size; ++element) {
+      std::string const elementName =
+          name + "[" + std::to_string(element) + "]";
+      copyValue(source, glGetUniformLocation(source, elementName.c_str()),
+                glGetUniformLocation(program, elementName.c_str()), type);
+    }
+  }
+
+  glUseProgram(static_cast<GLuint>(previousProgram));
+}
+
+bool LinkedProgram::checkAndLogLinkSuccess(GLuint program) const {
+
+  GLint success;
+
+  glGetProgramiv(program, GL_LINK_STATUS, &success);
+  if (!success) {
+    GLint logLength;
+    glGetProgramiv(program, GL_INFO_LOG_LENGTH, &logLength);
+    std::vector<char> log(logLength);
+    glGetProgramInfoLog(program, logLength, NULL, log.data());
+
+    Log::error("{} linking {}:\n{}", kind, name, log.data());
+    return false;
+  } else {
+    Log::info("{} successfully compiled and linked {}", kind, name);
+    return true;
+  }
+}
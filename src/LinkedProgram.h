@@ -0,0 +1,82 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+// What ShaderProgram and ComputeProgram share once their shaders are attached: linking,
+// the reflection of the active uniforms and blocks, and the uniform handles and setters.
+class LinkedProgram {
+
+public:
+	// Handle to a uniform, resolved once at startup with uniform(name).
+	// It stays valid across ShaderProgram::recompile(), which re-resolves every handle against the new program
+	// and carries the values over, so uniforms set once at startup (sampler units) survive a reload.
+	struct Uniform {
+		int slot = -1;
+	};
+
+	// What the program reflection found for each active uniform
+	struct UniformInfo {
+		GLint location;
+		GLenum type;
+		GLint size; // array length, 1 for non-arrays
+	};
+
+	// Registers a uniform by name. No GL call is made, the location comes from the reflection
+	// done after linking. Logs a warning if the program has no such active uniform.
+	Uniform uniform(const std::string& name, bool warnIfMissing = true);
+
+	// Index of an active uniform block, GL_INVALID_INDEX if there is none with that name
+	GLuint uniformBlock(const std::string& name) const;
+
+	bool hasUniform(const std::string& name) const { return uniforms.count(name) != 0; }
+	const std::unordered_map<std::string, UniformInfo>& activeUniforms() const { return uniforms; }
+	const std::unordered_map<std::string, GLuint>& activeUniformBlocks() const { return uniformBlocks; }
+
+	// Typed setters, the program must be in use. Missing uniforms are ignored (location -1).
+	void set(Uniform u, int value) const { glUniform1i(location(u), value); }
+	void set(Uniform u, GLuint value) const { glUniform1ui(location(u), value); }
+	void set(Uniform u, float value) const { glUniform1f(location(u), value); }
+	void set(Uniform u, const glm::vec2& value) const { glUniform2fv(location(u), 1, &value[0]); }
+	void set(Uniform u, const glm::vec3& value) const { glUniform3fv(location(u), 1, &value[0]); }
+	void set(Uniform u, const glm::vec4& value) const { glUniform4fv(location(u), 1, &value[0]); }
+	void set(Uniform u, const glm::mat4& value) const { glUniformMatrix4fv(location(u), 1, GL_FALSE, &value[0][0]); }
+	void set(Uniform u, const glm::vec4* values, GLsizei count) const { glUniform4fv(location(u), count, &values[0][0]); }
+
+	GLint location(Uniform u) const { return u.slot >= 0 ? slotLocations[u.slot] : -1; }
+
+protected:
+	// kind and name only label the log messages, e.g. "SHADER_PROGRAM" and the shader paths.
+	// The derived program sets name before linking, once its shaders know their paths.
+	explicit LinkedProgram(std::string kind);
+
+	// Links the program and reflects it, returns false (after logging why) when linking failed
+	bool link(GLuint program);
+
+	// Looks every registered handle up again, after the reflection changed
+	void resolveSlots();
+
+	// Sets every registered uniform of program to its current value in source (the program linked before,
+	// with the reflection in sourceProgram). Uniforms whose type or size changed keep their defaults.
+	void copyUniformValues(const LinkedProgram& sourceProgram, GLuint source, GLuint program) const;
+
+	std::string kind;
+	std::string name;
+
+	// reflection, filled once after linking
+	std::unordered_map<std::string, UniformInfo> uniforms;
+	std::unordered_map<std::string, GLuint> uniformBlocks;
+
+	// registered handles, slot -> name/location
+	std::vector<std::string> slotNames;
+	std::vector<GLint> slotLocations;
+
+private:
+	bool checkAndLogLinkSuccess(GLuint program) const;
+	void reflect(GLuint program);
+};
@@ -0,0 +1,97 @@
+#include "MappedFile.hpp"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+//======================================================================================================================
+
+#if defined(_WIN32)
+
+MappedFile::MappedFile(std::filesystem::path const & path)
+{
+    HANDLE const file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return;
+    }
+    mFile = file;
+
+    LARGE_INTEGER size {};
+    if (GetFileSizeEx(file, &size) == FALSE || size.QuadPart == 0)
+    {
+        return;
+    }
+
+    mMapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mMapping == nullptr)
+    {
+        return;
+    }
+
+    mData = MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0);
+    mSize = mData != nullptr ? static_cast<size_t>(size.QuadPart) : 0;
+}
+
+//======================================================================================================================
+
+MappedFile::~MappedFile()
+{
+    if (mData != nullptr)
+    {
+        UnmapViewOfFile(mData);
+    }
+    if (mMapping != nullptr)
+    {
+        CloseHandle(mMapping);
+    }
+    if (mFile != nullptr)
+    {
+        CloseHandle(mFile);
+    }
+}
+
+#else
+
+MappedFile::MappedFile(std::filesystem::path const & path)
+{
+    int const file = open(path.c_str(), O_RDONLY);
+    if (file < 0)
+    {
+        return;
+    }
+
+    // the mapping stays valid after the descriptor is closed
+    struct stat status {};
+    if (fstat(file, &status) == 0 && status.st_size > 0)
+    {
+        void * const data = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+        if (data != MAP_FAILED)
+        {
+            mData = data;
+            mSize = static_cast<size_t>(status.st_size);
+        }
+    }
+    close(file);
+}
+
+//======================================================================================================================
+
+MappedFile::~MappedFile()
+{
+    if (mData != nullptr)
+    {
+        munmap(mData, mSize);
+    }
+}
+
+#endif
+
+//======================================================================================================================
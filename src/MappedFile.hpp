@@ -0,0 +1,41 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// A whole file mapped read-only into memory, for caches that are uploaded
+// straight from disk without a copy. Unmapped on destruction.
+//------------------------------------------------------------------------------
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+class MappedFile
+{
+public:
+
+    // IsOpen() is false when the file does not exist or can not be mapped
+    explicit MappedFile(std::filesystem::path const & path);
+
+    ~MappedFile();
+
+    MappedFile(MappedFile const &) = delete;
+    MappedFile & operator=(MappedFile const &) = delete;
+
+    [[nodiscard]]
+    bool IsOpen() const { return mData != nullptr; }
+
+    [[nodiscard]]
+    uint8_t const * Data() const { return static_cast<uint8_t const *>(mData); }
+
+    [[nodiscard]]
+    size_t Size() const { return mSize; }
+
+private:
+
+    void * mData = nullptr;
+    size_t mSize = 0;
+#if defined(_WIN32)
+    void * mFile = nullptr;
+    void * mMapping = nullptr;
+#endif
+};
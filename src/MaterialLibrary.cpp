@@ -0,0 +1,254 @@
+#include "MaterialLibrary.hpp"
+
+#include "AssetPath.h"
+#include "Log.h"
+
+#include <stb/stb_image.h>
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace
+{
+    // Box filter: every destination texel averages the source texels under its footprint.
+    // Downsampling averages, upsampling degrades to nearest neighbour.
+    std::vector<unsigned char> Resample(
+        unsigned char const * source,
+        glm::ivec2 const & sourceSize,
+        glm::ivec2 const & destinationSize
+    )
+    {
+        std::vector<unsigned char> destination(static_cast<size_t>(destinationSize.x) * destinationSize.y * 4);
+        glm::vec2 const scale = glm::vec2(sourceSize) / glm::vec2(destinationSize);
+
+        for (int y = 0; y < destinationSize.y; ++y)
+        {
+            int const y0 = static_cast<int>(std::floor(static_cast<float>(y) * scale.y));
+            int const y1 = std::max(y0 + 1, std::min(static_cast<int>(std::ceil(static_cast<float>(y + 1) * scale.y)), sourceSize.y));
+            for (int x = 0; x < destinationSize.x; ++x)
+            {
+                int const x0 = static_cast<int>(std::floor(static_cast<float>(x) * scale.x));
+                int const x1 = std::max(x0 + 1, std::min(static_cast<int>(std::ceil(static_cast<float>(x + 1) * scale.x)), sourceSize.x));
+
+                uint32_t sum[4] = {0, 0, 0, 0};
+                for (int sy = y0; sy < y1; ++sy)
+                {
+                    unsigned char const * row = source + (static_cast<size_t>(sy) * sourceSize.x + x0) * 4;
+                    for (int sx = x0; sx < x1; ++sx, row += 4)
+                    {
+                        sum[0] += row[0];
+                        sum[1] += row[1];
+                        sum[2] += row[2];
+                        sum[3] += row[3];
+                    }
+                }
+
+                auto const count = static_cast<uint32_t>((x1 - x0) * (y1 - y0));
+                unsigned char * texel = destination.data() + (static_cast<size_t>(y) * destinationSize.x + x) * 4;
+                for (int c = 0; c < 4; ++c)
+                {
+                    texel[c] = static_cast<unsigned char>((sum[c] + count / 2) / count);
+                }
+            }
+        }
+        return destination;
+    }
+}
+
+//======================================================================================================================
+
+MaterialLibrary::MaterialLibrary(int const maxLayerWidth)
+{
+    GLint maxTextureSize = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+    mMaxLayerWidth = std::min(maxLayerWidth, static_cast<int>(maxTextureSize));
+}
+
+//======================================================================================================================
+
+MaterialLibrary::Material MaterialLibrary::Add(std::string const & texturePath)
+{
+    return Add(Surface{texturePath});
+}
+
+//======================================================================================================================
+
+MaterialLibrary::Material MaterialLibrary::Add(Surface const & surface)
+{
+    std::string const key = surface.color + '|' + surface.specular + '|' + surface.night;
+    auto const found = mMaterials.find(key);
+    if (found != mMaterials.end())
+    {
+        return found->second;
+    }
+
+    auto const readSize = [](std::string const & fullPath)->glm::ivec2 {
+        glm::ivec2 size {};
+        int components = 0;
+        if (stbi_info(fullPath.c_str(), &size.x, &size.y, &components) == 0)
+        {
+            throw std::runtime_error("Failed to read texture data from file!");
+        }
+        return size;
+    };
+
+    std::string const fullPath = AssetPath::Instance()->Get(surface.color);
+    glm::ivec2 const size = readSize(fullPath);
+    glm::ivec2 layerSize = GetLayerSize(size);
+
+    Material material {};
+    Layer layer {fullPath};
+    if (!surface.specular.empty())
+    {
+        layer.alphaPath = AssetPath::Instance()->Get(surface.specular);
+        (void)readSize(layer.alphaPath);
+        material.features |= SpecularMask;
+    }
+
+    // the shaders find the night side at layer + 1, so it has to follow in the same array, at the smaller size
+    std::string nightPath {};
+    if (!surface.night.empty())
+    {
+        nightPath = AssetPath::Instance()->Get(surface.night);
+        glm::ivec2 const nightSize = readSize(nightPath);
+        float const aspectRatio = static_cast<float>(size.x) / static_cast<float>(size.y);
+        if (std::abs(static_cast<float>(nightSize.x) / static_cast<float>(nightSize.y) - aspectRatio) >= 0.01f)
+        {
+            throw std::runtime_error("Night texture must have the aspect ratio of the day texture!");
+        }
+        layerSize = glm::min(layerSize, GetLayerSize(nightSize));
+        material.features |= NightLights;
+    }
+
+    ArrayEntry & entry = FindArray(layerSize);
+    entry.layers.emplace_back(std::move(layer));
+    material.array = static_cast<uint32_t>(&entry - mArrays.data());
+    material.layer = static_cast<uint32_t>(entry.layers.size() - 1);
+    if (!nightPath.empty())
+    {
+        entry.layers.push_back(Layer{nightPath});
+    }
+
+    mMaterials.emplace(key, material);
+    return material;
+}
+
+//======================================================================================================================
+
+glm::ivec2 MaterialLibrary::GetLayerSize(glm::ivec2 const imageSize) const
+{
+    if (imageSize.x <= mMaxLayerWidth)
+    {
+        return imageSize;
+    }
+    float const aspectRatio = static_cast<float>(imageSize.x) / static_cast<float>(imageSize.y);
+    return {mMaxLayerWidth, std::max(1, static_cast<int>(std::lround(static_cast<float>(mMaxLayerWidth) / aspectRatio)))};
+}
+
+//======================================================================================================================
+
+MaterialLibrary::ArrayEntry & MaterialLibrary::FindArray(glm::ivec2 const layerSize)
+{
+    auto entry = std::find_if(mArrays.begin(), mArrays.end(), [layerSize](ArrayEntry const & array)->bool {
+        return array.layerSize == layerSize;
+    });
+    if (entry == mArrays.end())
+    {
+        mArrays.emplace_back();
+        entry = mArrays.end() - 1;
+        entry->layerSize = layerSize;
+    }
+    return *entry;
+}
+
+//======================================================================================================================
+
+void MaterialLibrary::Upload()
+{
+    GLint maxLayers = 0;
+    glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+
+    stbi_set_flip_vertically_on_load(true);
+
+    for (auto & array : mArrays)
+    {
+        if (static_cast<GLint>(array.layers.size()) > maxLayers)
+        {
+            throw std::runtime_error("Too many textures for one texture array!");
+        }
+
+        glm::ivec2 const layerSize = array.layerSize;
+        array.texture = std::make_unique<TextureArray>(layerSize, static_cast<GLsizei>(array.layers.size()), GL_NEAREST);
+
+        for (size_t layer = 0; layer < array.layers.size(); ++layer)
+        {
+            glm::ivec2 size {};
+            auto const data = LoadLayer(array.layers[layer], size);
+
+            if (size == layerSize)
+            {
+                array.texture->uploadLayer(static_cast<GLint>(layer), data.data());
+            }
+            else
+            {
+                // only ever smaller, the array has the size of its smallest image
+                Log::info("Downsampling {} from {}x{} to {}x{}", array.layers[layer].path, size.x, size.y, layerSize.x, layerSize.y);
+                auto const resampled = Resample(data.data(), size, layerSize);
+                array.texture->uploadLayer(static_cast<GLint>(layer), resampled.data());
+            }
+        }
+
+        Log::info("Texture array {}x{} with {} layers", layerSize.x, layerSize.y, array.layers.size());
+    }
+}
+
+//======================================================================================================================
+
+std::vector<unsigned char> MaterialLibrary::LoadLayer(Layer const & layer, glm::ivec2 & size)
+{
+    // always four channels, so every layer has the same format
+    int components = 0;
+    unsigned char * data = stbi_load(layer.path.c_str(), &size.x, &size.y, &components, 4);
+    if (data == nullptr)
+    {
+        throw std::runtime_error("Failed to read texture data from file!");
+    }
+    std::vector<unsigned char> pixels(data, data + static_cast<size_t>(size.x) * size.y * 4);
+    stbi_image_free(data);
+
+    if (layer.alphaPath.empty())
+    {
+        return pixels;
+    }
+
+    // the mask may have its own resolution, bring it to the colour size through the same box filter
+    glm::ivec2 maskSize {};
+    unsigned char * mask = stbi_load(layer.alphaPath.c_str(), &maskSize.x, &maskSize.y, &components, 4);
+    if (mask == nullptr)
+    {
+        throw std::runtime_error("Failed to read texture data from file!");
+    }
+    std::vector<unsigned char> resampledMask {};
+    unsigned char const * maskTexels = mask;
+    if (maskSize != size)
+    {
+        resampledMask = Resample(mask, maskSize, size);
+        maskTexels = resampledMask.data();
+    }
+    for (size_t texel = 0; texel < static_cast<size_t>(size.x) * size.y; ++texel)
+    {
+        pixels[texel * 4 + 3] = maskTexels[texel * 4];
+    }
+    stbi_image_free(mask);
+    return pixels;
+}
+
+//======================================================================================================================
+
+void MaterialLibrary::Bind(uint32_t const array) const
+{
+    mArrays[array].texture->bind();
+}
+
+//======================================================================================================================
@@ -0,0 +1,107 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Packs the body textures into GL_TEXTURE_2D_ARRAY layers, so bodies with
+// different surfaces can share one bind and one instanced draw. Every image is
+// converted to RGBA8 and goes into the array of its own size, downsampled first
+// if it is wider than the layer limit. Images are never upsampled, so a small
+// texture does not take the memory of the largest one; bodies in different
+// arrays still share a draw per array.
+//
+// A surface can have more maps than its colour. A specular mask is packed into
+// the alpha channel of the colour layer, a night map takes the layer right after
+// it, so both are stored at the smaller of the two sizes. The material's feature
+// bits tell which of these exist, so the renderer can pick the shader variant
+// that reads them.
+//
+// Usage: Add() every texture, then Upload() once. The material returned by
+// Add() is only usable after Upload().
+//------------------------------------------------------------------------------
+
+#include "TextureArray.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class MaterialLibrary
+{
+public:
+
+    enum Feature : uint32_t
+    {
+        SpecularMask = 1u << 0, // colour alpha scales the specular highlight
+        NightLights  = 1u << 1, // layer + 1 holds the emissive night side
+    };
+
+    struct Material
+    {
+        uint32_t array = 0;    // which texture array, also the material field of render queue keys
+        uint32_t layer = 0;    // layer inside that array, passed to the shaders per instance
+        uint32_t features = 0; // Feature bits
+    };
+
+    // Texture paths as given to AssetPath, only color is required
+    struct Surface
+    {
+        std::string color {};
+        std::string specular {}; // greyscale, white where the surface is shiny
+        std::string night {};    // must have the aspect ratio of color
+    };
+
+    // Layers are never wider than maxLayerWidth (or GL_MAX_TEXTURE_SIZE), larger images are downsampled
+    explicit MaterialLibrary(int maxLayerWidth = 4096);
+
+    // Registers a texture (path as given to AssetPath) and returns where it will live. Only the
+    // image header is read here. Adding the same path twice returns the same material.
+    [[nodiscard]]
+    Material Add(std::string const & texturePath);
+
+    // Same for a surface with several maps, the material gets a feature bit for every optional map
+    [[nodiscard]]
+    Material Add(Surface const & surface);
+
+    // Creates the arrays, then decodes, resamples and uploads every image one at a time
+    void Upload();
+
+    void Bind(uint32_t array) const;
+
+    [[nodiscard]]
+    size_t ArrayCount() const { return mArrays.size(); }
+
+    [[nodiscard]]
+    TextureArray const & GetArray(uint32_t array) const { return *mArrays[array].texture; }
+
+private:
+
+    struct Layer
+    {
+        std::string path {};
+        std::string alphaPath {}; // replaces the alpha channel of path when set
+    };
+
+    struct ArrayEntry
+    {
+        glm::ivec2 layerSize {};
+        std::vector<Layer> layers {};
+        std::unique_ptr<TextureArray> texture {};
+    };
+
+    // Size an image is stored at: its own, or downsampled to mMaxLayerWidth keeping the aspect ratio
+    [[nodiscard]]
+    glm::ivec2 GetLayerSize(glm::ivec2 imageSize) const;
+
+    // Returns the array with layers of that size, adding one if there is none yet
+    ArrayEntry & FindArray(glm::ivec2 layerSize);
+
+    // Decodes a layer to RGBA8 at the size of the colour image
+    static std::vector<unsigned char> LoadLayer(Layer const & layer, glm::ivec2 & size);
+
+    int mMaxLayerWidth;
+    std::unordered_map<std::string, Material> mMaterials {};
+    std::vector<ArrayEntry> mArrays {};
+};
@@ -0,0 +1,248 @@
+#include "MeshBuffer.hpp"
+
+#include "Log.h"
+#include "ShapeGenerator.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+//======================================================================================================================
+
+MeshBuffer::MeshBuffer(uint32_t const vertexCapacity, uint32_t const indexCapacity)
+    : mVertices(vertexCapacity)
+    , mIndices(indexCapacity)
+{
+    glBindBuffer(GL_ARRAY_BUFFER, mVertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(sizeof(Vertex)) * vertexCapacity, nullptr, GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    SetupVertexArray();
+
+    // the element buffer stays bound to the VAO
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(sizeof(Index)) * indexCapacity, nullptr, GL_STATIC_DRAW);
+}
+
+//======================================================================================================================
+
+MeshBuffer::MeshId MeshBuffer::Add(CPU_Geometry const & geometry)
+{
+    if (geometry.indices.empty())
+    {
+        throw std::runtime_error("MeshBuffer only stores indexed geometry");
+    }
+    assert(geometry.positions.size() == geometry.normals.size());
+    assert(geometry.positions.size() == geometry.uvs.size());
+
+    auto const vertexCount = static_cast<uint32_t>(geometry.positions.size());
+    auto const indexCount = static_cast<uint32_t>(geometry.indices.size());
+
+    auto baseVertex = mVertices.Allocate(vertexCount);
+    auto firstIndex = mIndices.Allocate(indexCount);
+    if (baseVertex.has_value() == false || firstIndex.has_value() == false)
+    {
+        if (baseVertex.has_value())
+        {
+            mVertices.Free(*baseVertex, vertexCount);
+        }
+        if (firstIndex.has_value())
+        {
+            mIndices.Free(*firstIndex, indexCount);
+        }
+
+        // compacting puts all the free space at the end, so this always fits afterwards
+        Reallocate(
+            std::max(mVertices.Capacity() * 2, mVertices.Used() + vertexCount),
+            std::max(mIndices.Capacity() * 2, mIndices.Used() + indexCount)
+        );
+        baseVertex = mVertices.Allocate(vertexCount);
+        firstIndex = mIndices.Allocate(indexCount);
+    }
+
+    std::vector<Vertex> vertices(vertexCount);
+    for (uint32_t i = 0; i < vertexCount; ++i)
+    {
+        vertices[i] = Vertex{geometry.positions[i], geometry.uvs[i], geometry.normals[i]};
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, mVertexBuffer);
+    glBufferSubData(
+        GL_ARRAY_BUFFER,
+        static_cast<GLintptr>(sizeof(Vertex)) * *baseVertex,
+        static_cast<GLsizeiptr>(sizeof(Vertex)) * vertexCount,
+        vertices.data()
+    );
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, mIndexBuffer);
+    glBufferSubData(
+        GL_COPY_WRITE_BUFFER,
+        static_cast<GLintptr>(sizeof(Index)) * *firstIndex,
+        static_cast<GLsizeiptr>(sizeof(Index)) * indexCount,
+        geometry.indices.data()
+    );
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    MeshId const id = mNextId++;
+    mMeshes.emplace(id, Mesh{
+        static_cast<GLint>(*baseVertex),
+        static_cast<GLsizei>(vertexCount),
+        *firstIndex,
+        static_cast<GLsizei>(indexCount)
+    });
+    return id;
+}
+
+//======================================================================================================================
+
+std::shared_ptr<MeshBuffer::MeshId const> MeshBuffer::AddShared(CPU_Geometry const & geometry)
+{
+    MeshId const id = Add(geometry);
+    return std::shared_ptr<MeshId const>(new MeshId(id), [this](MeshId const * mesh)->void {
+        Free(*mesh);
+        delete mesh;
+    });
+}
+
+//======================================================================================================================
+
+std::shared_ptr<MeshBuffer::MeshId const> MeshBuffer::AddSphere(float const radius, int const slices, int const stacks)
+{
+    std::weak_ptr<MeshId const> & cached = mSpheres[std::make_tuple(radius, slices, stacks)];
+    std::shared_ptr<MeshId const> mesh = cached.lock();
+    if (mesh == nullptr)
+    {
+        mesh = AddShared(ShapeGenerator::Sphere(radius, slices, stacks));
+        cached = mesh;
+    }
+    return mesh;
+}
+
+//======================================================================================================================
+
+void MeshBuffer::Free(MeshId const mesh)
+{
+    auto const found = mMeshes.find(mesh);
+    if (found == mMeshes.end())
+    {
+        return;
+    }
+    mVertices.Free(static_cast<uint32_t>(found->second.baseVertex), static_cast<uint32_t>(found->second.vertexCount));
+    mIndices.Free(found->second.firstIndex, static_cast<uint32_t>(found->second.indexCount));
+    mMeshes.erase(found);
+}
+
+//======================================================================================================================
+
+void MeshBuffer::Defragment()
+{
+    Reallocate(mVertices.Capacity(), mIndices.Capacity());
+}
+
+//======================================================================================================================
+
+MeshBuffer::Mesh const & MeshBuffer::Get(MeshId const mesh) const
+{
+    return mMeshes.at(mesh);
+}
+
+//======================================================================================================================
+
+MeshBuffer::Stats MeshBuffer::GetStats() const
+{
+    Stats stats{};
+    stats.meshes = static_cast<int>(mMeshes.size());
+    stats.verticesUsed = mVertices.Used();
+    stats.vertexCapacity = mVertices.Capacity();
+    stats.indicesUsed = mIndices.Used();
+    stats.indexCapacity = mIndices.Capacity();
+    stats.freeRanges = mVertices.FreeRangeCount() + mIndices.FreeRangeCount();
+    return stats;
+}
+
+//======================================================================================================================
+
+void MeshBuffer::Reallocate(uint32_t const vertexCapacity, uint32_t const indexCapacity)
+{
+    VertexBufferHandle vertexBuffer{};
+    VertexBufferHandle indexBuffer{};
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, vertexBuffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(sizeof(Vertex)) * vertexCapacity, nullptr, GL_STATIC_DRAW);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, indexBuffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(sizeof(Index)) * indexCapacity, nullptr, GL_STATIC_DRAW);
+
+    // keep the meshes in their current order, so nearby meshes stay nearby
+    std::vector<Mesh *> meshes{};
+    for (auto & [id, mesh] : mMeshes)
+    {
+        meshes.emplace_back(&mesh);
+    }
+    std::sort(meshes.begin(), meshes.end(), [](Mesh const * a, Mesh const * b)->bool {
+        return a->baseVertex < b->baseVertex;
+    });
+
+    // indices are relative to baseVertex, so they are copied unchanged
+    uint32_t vertexHead = 0;
+    uint32_t indexHead = 0;
+    for (Mesh * mesh : meshes)
+    {
+        glBindBuffer(GL_COPY_READ_BUFFER, mVertexBuffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, vertexBuffer);
+        glCopyBufferSubData(
+            GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+            static_cast<GLintptr>(sizeof(Vertex)) * mesh->baseVertex,
+            static_cast<GLintptr>(sizeof(Vertex)) * vertexHead,
+            static_cast<GLsizeiptr>(sizeof(Vertex)) * mesh->vertexCount
+        );
+
+        glBindBuffer(GL_COPY_READ_BUFFER, mIndexBuffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, indexBuffer);
+        glCopyBufferSubData(
+            GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+            static_cast<GLintptr>(sizeof(Index)) * mesh->firstIndex,
+            static_cast<GLintptr>(sizeof(Index)) * indexHead,
+            static_cast<GLsizeiptr>(sizeof(Index)) * mesh->indexCount
+        );
+
+        mesh->baseVertex = static_cast<GLint>(vertexHead);
+        mesh->firstIndex = indexHead;
+        vertexHead += static_cast<uint32_t>(mesh->vertexCount);
+        indexHead += static_cast<uint32_t>(mesh->indexCount);
+    }
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    mVertexBuffer = std::move(vertexBuffer);
+    mIndexBuffer = std::move(indexBuffer);
+    mVertices.Reset(vertexCapacity, vertexHead);
+    mIndices.Reset(indexCapacity, indexHead);
+
+    SetupVertexArray();
+
+    Log::info("MESH_BUFFER {} meshes, {}/{} vertices, {}/{} indices",
+        mMeshes.size(), vertexHead, vertexCapacity, indexHead, indexCapacity);
+}
+
+//======================================================================================================================
+
+void MeshBuffer::SetupVertexArray() const
+{
+    mVertexArray.bind();
+
+    glBindBuffer(GL_ARRAY_BUFFER, mVertexBuffer);
+    auto const stride = static_cast<GLsizei>(sizeof(Vertex));
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void *>(offsetof(Vertex, position)));
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void *>(offsetof(Vertex, uv)));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void *>(offsetof(Vertex, normal)));
+    glEnableVertexAttribArray(2);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mIndexBuffer);
+}
+
+//======================================================================================================================
@@ -0,0 +1,116 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// All static meshes in one interleaved vertex buffer and one index buffer,
+// described by a single VAO. Meshes are suballocated ranges of those buffers
+// and are drawn with base-vertex draws, so switching mesh never rebinds any
+// GL object and batched or indirect draws can span several meshes.
+//
+// Freed ranges are reused first-fit. Defragment() moves every live mesh to the
+// front of new buffers on the GPU (glCopyBufferSubData); it changes the ranges
+// of the meshes, so call it between frames and re-read them afterwards.
+//------------------------------------------------------------------------------
+
+#include "Geometry.h"
+#include "GLHandles.h"
+#include "RangeAllocator.hpp"
+#include "VertexArray.h"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <tuple>
+#include <unordered_map>
+
+class MeshBuffer
+{
+public:
+
+    using MeshId = uint32_t;
+
+    // Where a mesh lives in the shared buffers
+    struct Mesh
+    {
+        GLint baseVertex = 0;
+        GLsizei vertexCount = 0;
+        GLuint firstIndex = 0;
+        GLsizei indexCount = 0;
+
+        // byte offset of the first index, for the indices argument of glDrawElements*
+        [[nodiscard]]
+        void const * IndexOffset() const { return reinterpret_cast<void const *>(static_cast<uintptr_t>(firstIndex) * sizeof(Index)); }
+    };
+
+    struct Stats
+    {
+        int meshes = 0;
+        uint32_t verticesUsed = 0;
+        uint32_t vertexCapacity = 0;
+        uint32_t indicesUsed = 0;
+        uint32_t indexCapacity = 0;
+        size_t freeRanges = 0;      // vertex and index, a measure of fragmentation
+    };
+
+    // The one vertex format: position (location 0), uv (1), normal (2)
+    struct Vertex
+    {
+        glm::vec3 position;
+        glm::vec2 uv;
+        glm::vec3 normal;
+    };
+
+    explicit MeshBuffer(uint32_t vertexCapacity = 64 * 1024, uint32_t indexCapacity = 256 * 1024);
+
+    // Copies the geometry in, growing (and compacting) the buffers if no free range is large
+    // enough. The geometry must be indexed; colors are not part of the vertex format.
+    [[nodiscard]]
+    MeshId Add(CPU_Geometry const & geometry);
+
+    // Like Add(), but the mesh is freed when the last copy of the returned pointer goes away.
+    // The MeshBuffer must outlive every copy.
+    [[nodiscard]]
+    std::shared_ptr<MeshId const> AddShared(CPU_Geometry const & geometry);
+
+    // A shared sphere mesh, generated and added on the first request for these parameters and
+    // returned again while any copy of it is alive. Same lifetime rules as AddShared().
+    [[nodiscard]]
+    std::shared_ptr<MeshId const> AddSphere(float radius, int slices, int stacks);
+
+    void Free(MeshId mesh);
+
+    void Defragment();
+
+    [[nodiscard]]
+    Mesh const & Get(MeshId mesh) const;
+
+    void Bind() const { mVertexArray.bind(); }
+
+    [[nodiscard]]
+    GLuint VertexArrayID() const { return mVertexArray.getID(); }
+
+    [[nodiscard]]
+    Stats GetStats() const;
+
+private:
+
+    // Moves every live mesh to the front of new buffers of the given capacity
+    void Reallocate(uint32_t vertexCapacity, uint32_t indexCapacity);
+
+    void SetupVertexArray() const;
+
+    VertexArray mVertexArray {};
+    VertexBufferHandle mVertexBuffer {};
+    VertexBufferHandle mIndexBuffer {};
+
+    RangeAllocator mVertices;
+    RangeAllocator mIndices;
+
+    std::unordered_map<MeshId, Mesh> mMeshes {};
+    MeshId mNextId = 0;
+
+    // only weak references, so a sphere is freed with the last body using it
+    std::map<std::tuple<float, int, int>, std::weak_ptr<MeshId const>> mSpheres {};
+};
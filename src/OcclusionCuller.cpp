@@ -0,0 +1,289 @@
+#include "OcclusionCuller.hpp"
+
+#include "AssetPath.h"
+#include "ShapeGenerator.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+//======================================================================================================================
+
+OcclusionCuller::OcclusionCuller()
+{
+    auto const path = AssetPath::Instance();
+    mBoundsShader = std::make_unique<ShaderProgram>(
+        path->Get("shaders/bounds.vert"),
+        path->Get("shaders/bounds.frag")
+    );
+    mModelMatrixUniform = mBoundsShader->uniform("model_matrix");
+
+    // unit cube has no texture coordinates, but GPU_Geometry expects matching sizes
+    CPU_Geometry box = ShapeGenerator::UnitCube();
+    box.uvs.resize(box.positions.size(), UV{});
+    mBoxGeometry = std::make_unique<GPU_Geometry>();
+    mBoxGeometry->Update(box);
+
+    for (int size = DepthBufferSize; size >= 1; size /= 2)
+    {
+        mDepthLevels.emplace_back(static_cast<size_t>(size * size), std::numeric_limits<float>::max());
+    }
+}
+
+//======================================================================================================================
+
+void OcclusionCuller::BeginFrame(
+    Mode const mode,
+    glm::mat4 const & viewMatrix,
+    glm::mat4 const & projectionMatrix,
+    float const zNear,
+    size_t const bodyCount
+)
+{
+    mStats = {};
+
+    // collect last frame's query results without waiting on the ones that are not ready yet
+    for (size_t i = 0; i < mQueries.size(); ++i)
+    {
+        if (mQueryIssued[i] == false)
+        {
+            continue;
+        }
+        GLuint available = GL_FALSE;
+        glGetQueryObjectuiv(mQueries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available == GL_TRUE)
+        {
+            GLuint anySamplesPassed = GL_TRUE;
+            glGetQueryObjectuiv(mQueries[i], GL_QUERY_RESULT, &anySamplesPassed);
+            mStats.tested += 1;
+            mStats.occluded += anySamplesPassed == GL_FALSE ? 1 : 0;
+        }
+        mQueryIssued[i] = false;
+    }
+
+    mMode = mode;
+    mViewMatrix = viewMatrix;
+    mProjectionMatrix = projectionMatrix;
+    mCameraPosition = glm::vec3(glm::inverse(viewMatrix)[3]);
+    mZNear = zNear;
+
+    if (mMode == Mode::HardwareQueries)
+    {
+        while (mQueries.size() < bodyCount)
+        {
+            mQueries.emplace_back();
+        }
+        mQueryIssued.resize(mQueries.size(), false);
+    }
+    else if (mMode == Mode::SoftwareHiZ)
+    {
+        std::fill(mDepthLevels[0].begin(), mDepthLevels[0].end(), std::numeric_limits<float>::max());
+    }
+}
+
+//======================================================================================================================
+
+bool OcclusionCuller::IssueQuery(size_t const bodyIndex, BoundingSphere const & bounds)
+{
+    // from inside the box its faces would be clipped by the near plane, so just draw the body
+    float const boxHalfDiagonal = bounds.radius * std::sqrt(3.0f);
+    if (glm::distance(mCameraPosition, bounds.center) < boxHalfDiagonal + mZNear)
+    {
+        return false;
+    }
+
+    glm::mat4 const model_matrix =
+        glm::translate(glm::mat4(1.0f), bounds.center) *
+        glm::scale(glm::mat4(1.0f), glm::vec3(bounds.radius * 2.0f));
+
+    mBoundsShader->use();
+    mBoundsShader->set(mModelMatrixUniform, model_matrix);
+
+    GLboolean const cullFaceEnabled = glIsEnabled(GL_CULL_FACE);
+    glDisable(GL_CULL_FACE);
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    glDepthMask(GL_FALSE);
+
+    glBeginQuery(GL_ANY_SAMPLES_PASSED, mQueries[bodyIndex]);
+    mBoxGeometry->bind();
+    glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(mBoxGeometry->vertex_count()));
+    glEndQuery(GL_ANY_SAMPLES_PASSED);
+
+    glDepthMask(GL_TRUE);
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    if (cullFaceEnabled == GL_TRUE)
+    {
+        glEnable(GL_CULL_FACE);
+    }
+
+    mQueryIssued[bodyIndex] = true;
+    return true;
+}
+
+//======================================================================================================================
+
+void OcclusionCuller::BeginConditionalRender(size_t const bodyIndex) const
+{
+    glBeginConditionalRender(mQueries[bodyIndex], GL_QUERY_NO_WAIT);
+}
+
+//======================================================================================================================
+
+void OcclusionCuller::EndConditionalRender() const
+{
+    glEndConditionalRender();
+}
+
+//======================================================================================================================
+
+OcclusionCuller::ScreenRect OcclusionCuller::ProjectRect(
+    glm::vec2 const & viewMin,
+    glm::vec2 const & viewMax,
+    float const viewZ
+) const
+{
+    // the rectangle faces the camera, so two opposite corners are enough
+    auto const toTexels = [this](glm::vec3 const & viewPosition)->glm::vec2 {
+        glm::vec4 const clip = mProjectionMatrix * glm::vec4(viewPosition, 1.0f);
+        glm::vec2 const ndc = glm::vec2(clip) / clip.w;
+        return (ndc * 0.5f + 0.5f) * static_cast<float>(DepthBufferSize);
+    };
+
+    glm::vec2 const a = toTexels(glm::vec3(viewMin, viewZ));
+    glm::vec2 const b = toTexels(glm::vec3(viewMax, viewZ));
+    return ScreenRect{glm::min(a, b), glm::max(a, b)};
+}
+
+//======================================================================================================================
+
+float & OcclusionCuller::DepthAt(int const level, int const x, int const y)
+{
+    int const size = DepthBufferSize >> level;
+    return mDepthLevels[level][static_cast<size_t>(y * size + x)];
+}
+
+//======================================================================================================================
+
+void OcclusionCuller::AddOccluder(BoundingSphere const & bounds)
+{
+    glm::vec3 const center = glm::vec3(mViewMatrix * glm::vec4(bounds.center, 1.0f));
+
+    // Front face of the cube inscribed in the sphere. Every ray through it enters the sphere
+    // before reaching the face, so writing the face depth never hides anything in front of the sphere.
+    float const halfSize = bounds.radius / std::sqrt(3.0f);
+    float const faceZ = center.z + halfSize;
+    if (faceZ > -mZNear)
+    {
+        return;
+    }
+
+    ScreenRect const rect = ProjectRect(
+        glm::vec2(center) - glm::vec2(halfSize),
+        glm::vec2(center) + glm::vec2(halfSize),
+        faceZ
+    );
+
+    // only texels that are fully covered
+    int const x0 = std::max(static_cast<int>(std::ceil(rect.min.x)), 0);
+    int const y0 = std::max(static_cast<int>(std::ceil(rect.min.y)), 0);
+    int const x1 = std::min(static_cast<int>(std::floor(rect.max.x)), DepthBufferSize);
+    int const y1 = std::min(static_cast<int>(std::floor(rect.max.y)), DepthBufferSize);
+
+    float const depth = -faceZ;
+    for (int y = y0; y < y1; ++y)
+    {
+        for (int x = x0; x < x1; ++x)
+        {
+            float & texel = DepthAt(0, x, y);
+            texel = std::min(texel, depth);
+        }
+    }
+}
+
+//======================================================================================================================
+
+void OcclusionCuller::BuildHierarchy()
+{
+    // every texel keeps the farthest occluder depth of the four below it
+    for (int level = 1; level < static_cast<int>(mDepthLevels.size()); ++level)
+    {
+        int const size = DepthBufferSize >> level;
+        for (int y = 0; y < size; ++y)
+        {
+            for (int x = 0; x < size; ++x)
+            {
+                DepthAt(level, x, y) = std::max(
+                    std::max(DepthAt(level - 1, 2 * x, 2 * y), DepthAt(level - 1, 2 * x + 1, 2 * y)),
+                    std::max(DepthAt(level - 1, 2 * x, 2 * y + 1), DepthAt(level - 1, 2 * x + 1, 2 * y + 1))
+                );
+            }
+        }
+    }
+}
+
+//======================================================================================================================
+
+bool OcclusionCuller::IsOccluded(BoundingSphere const & bounds)
+{
+    glm::vec3 const center = glm::vec3(mViewMatrix * glm::vec4(bounds.center, 1.0f));
+
+    // front face of the sphere's bounding box, it is the nearest depth the sphere can reach
+    float const faceZ = center.z + bounds.radius;
+    if (faceZ > -mZNear)
+    {
+        return false;
+    }
+
+    mStats.tested += 1;
+
+    // Off the view axis the silhouette edge facing away from the axis lies deeper than the front
+    // face, so the box is projected at its front and back faces and the union covers the sphere.
+    glm::vec2 const viewMin = glm::vec2(center) - glm::vec2(bounds.radius);
+    glm::vec2 const viewMax = glm::vec2(center) + glm::vec2(bounds.radius);
+    ScreenRect const frontRect = ProjectRect(viewMin, viewMax, faceZ);
+    ScreenRect const backRect = ProjectRect(viewMin, viewMax, center.z - bounds.radius);
+    ScreenRect const rect{glm::min(frontRect.min, backRect.min), glm::max(frontRect.max, backRect.max)};
+
+    int const x0 = std::max(static_cast<int>(std::floor(rect.min.x)), 0);
+    int const y0 = std::max(static_cast<int>(std::floor(rect.min.y)), 0);
+    int const x1 = std::min(static_cast<int>(std::ceil(rect.max.x)) - 1, DepthBufferSize - 1);
+    int const y1 = std::min(static_cast<int>(std::ceil(rect.max.y)) - 1, DepthBufferSize - 1);
+    if (x0 > x1 || y0 > y1)
+    {
+        return false;
+    }
+
+    // go up the pyramid until the rectangle touches at most 2x2 texels
+    int level = 0;
+    while (level + 1 < static_cast<int>(mDepthLevels.size()) &&
+           ((x1 >> level) - (x0 >> level) > 1 || (y1 >> level) - (y0 >> level) > 1))
+    {
+        ++level;
+    }
+
+    float const nearestDepth = -faceZ;
+    for (int y = y0 >> level; y <= (y1 >> level); ++y)
+    {
+        for (int x = x0 >> level; x <= (x1 >> level); ++x)
+        {
+            if (DepthAt(level, x, y) >= nearestDepth)
+            {
+                return false;
+            }
+        }
+    }
+
+    mStats.occluded += 1;
+    return true;
+}
+
+//======================================================================================================================
+
+OcclusionCuller::Stats const & OcclusionCuller::GetStats() const
+{
+    return mStats;
+}
+
+//======================================================================================================================
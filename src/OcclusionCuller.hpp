@@ -0,0 +1,115 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Occlusion culling for bodies hidden behind large occluders (sun, planets).
+// Occluders are drawn first, then every other body is tested either with a
+// hardware occlusion query on its bounding box (drawn with conditional
+// rendering, so the CPU never waits on the result) or on the CPU against a
+// coarse software depth pyramid built from the occluders' bounding spheres.
+//------------------------------------------------------------------------------
+
+#include "Frustum.hpp"
+#include "Geometry.h"
+#include "GLHandles.h"
+#include "ShaderProgram.h"
+
+#include <glm/glm.hpp>
+
+#include <memory>
+#include <vector>
+
+class OcclusionCuller
+{
+public:
+
+    enum class Mode
+    {
+        Off,
+        HardwareQueries,
+        SoftwareHiZ
+    };
+
+    struct Stats
+    {
+        int tested = 0;
+        int occluded = 0; // for hardware queries these are the results of the previous frame
+    };
+
+    explicit OcclusionCuller();
+
+    // Resets the per frame state and grows the query pool to bodyCount
+    void BeginFrame(
+        Mode mode,
+        glm::mat4 const & viewMatrix,
+        glm::mat4 const & projectionMatrix,
+        float zNear,
+        size_t bodyCount
+    );
+
+    [[nodiscard]]
+    Mode GetMode() const { return mMode; }
+
+    // Hardware queries ------------------------------------------------------------------------------------------------
+
+    // Draws the bounding box of the body into its query with colour and depth writes off.
+    // Must be called after all the occluders are drawn, with the FrameData block bound. Returns false when no query was issued
+    // (camera inside the box), in which case the body should be drawn unconditionally.
+    bool IssueQuery(size_t bodyIndex, BoundingSphere const & bounds);
+
+    // Only draws until EndConditionalRender() if the query found visible samples.
+    // Uses GL_QUERY_NO_WAIT, so a result that is not ready yet means "draw".
+    void BeginConditionalRender(size_t bodyIndex) const;
+
+    void EndConditionalRender() const;
+
+    // Software Hi-Z ---------------------------------------------------------------------------------------------------
+
+    // Rasterizes a conservative (inner) rectangle of the sphere into the coarse depth buffer
+    void AddOccluder(BoundingSphere const & bounds);
+
+    // Builds the max-depth mip chain, call after all occluders are added
+    void BuildHierarchy();
+
+    [[nodiscard]]
+    bool IsOccluded(BoundingSphere const & bounds);
+
+    // -----------------------------------------------------------------------------------------------------------------
+
+    [[nodiscard]]
+    Stats const & GetStats() const;
+
+    static constexpr int DepthBufferSize = 128; // must be a power of two
+
+private:
+
+    struct ScreenRect
+    {
+        glm::vec2 min {};
+        glm::vec2 max {};
+    };
+
+    // Projects a view space rectangle facing the camera at depth -viewZ into depth buffer texels
+    [[nodiscard]]
+    ScreenRect ProjectRect(glm::vec2 const & viewMin, glm::vec2 const & viewMax, float viewZ) const;
+
+    [[nodiscard]]
+    float & DepthAt(int level, int x, int y);
+
+    Mode mMode = Mode::Off;
+    glm::mat4 mViewMatrix {};
+    glm::mat4 mProjectionMatrix {};
+    glm::vec3 mCameraPosition {};
+    float mZNear = 0.01f;
+
+    // hardware
+    std::unique_ptr<ShaderProgram> mBoundsShader {};
+    ShaderProgram::Uniform mModelMatrixUniform {};
+    std::unique_ptr<GPU_Geometry> mBoxGeometry {};
+    std::vector<QueryHandle> mQueries {};
+    std::vector<bool> mQueryIssued {};
+
+    // software: linear view depth, level 0 is DepthBufferSize^2 followed by the smaller levels
+    std::vector<std::vector<float>> mDepthLevels {};
+
+    Stats mStats {};
+};
@@ -0,0 +1,83 @@
+#include "OffscreenTarget.hpp"
+
+#include "Log.h"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+//======================================================================================================================
+
+OffscreenTarget::OffscreenTarget(glm::ivec2 const size)
+    : mSize(size)
+{
+    glBindTexture(GL_TEXTURE_2D, mColor);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_SRGB8_ALPHA8, size.x, size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    glBindTexture(GL_TEXTURE_2D, mDepth);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, size.x, size.y, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, mFramebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, mColor, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, mDepth, 0);
+    GLenum const status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        Log::error("Offscreen target {}x{} is incomplete ({:#x})", size.x, size.y, status);
+        throw std::runtime_error("Offscreen framebuffer is incomplete");
+    }
+}
+
+//======================================================================================================================
+
+std::vector<uint8_t> OffscreenTarget::ReadPixels() const
+{
+    size_t const rowBytes = static_cast<size_t>(mSize.x) * 3;
+    std::vector<uint8_t> pixels(rowBytes * mSize.y);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, mFramebuffer);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, mSize.x, mSize.y, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+    // GL returns the bottom row first
+    std::vector<uint8_t> row(rowBytes);
+    for (int y = 0; y < mSize.y / 2; ++y)
+    {
+        uint8_t * top = pixels.data() + rowBytes * y;
+        uint8_t * bottom = pixels.data() + rowBytes * (mSize.y - 1 - y);
+        std::memcpy(row.data(), top, rowBytes);
+        std::memcpy(top, bottom, rowBytes);
+        std::memcpy(bottom, row.data(), rowBytes);
+    }
+    return pixels;
+}
+
+//======================================================================================================================
+
+bool OffscreenTarget::WritePpm(std::filesystem::path const & path) const
+{
+    auto const pixels = ReadPixels();
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    std::string const header = "P6\n" + std::to_string(mSize.x) + " " + std::to_string(mSize.y) + "\n255\n";
+    file.write(header.data(), static_cast<std::streamsize>(header.size()));
+    file.write(reinterpret_cast<char const *>(pixels.data()), static_cast<std::streamsize>(pixels.size()));
+    if (file.good() == false)
+    {
+        Log::error("Could not write the frame to {}", path.string());
+        return false;
+    }
+    Log::info("Wrote the frame to {}", path.string());
+    return true;
+}
+
+//======================================================================================================================
@@ -0,0 +1,44 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// A framebuffer object standing in for the window's default framebuffer when
+// there is no window to present to (headless rendering). It has the same
+// attachments the frame graph expects of the backbuffer: sRGB colour and depth.
+// The colour can be read back and written out as a binary PPM, which needs no
+// image library.
+//------------------------------------------------------------------------------
+
+#include "GLHandles.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+class OffscreenTarget
+{
+public:
+
+    explicit OffscreenTarget(glm::ivec2 size);
+
+    [[nodiscard]]
+    GLuint GetFramebuffer() const { return mFramebuffer; }
+
+    [[nodiscard]]
+    glm::ivec2 GetSize() const { return mSize; }
+
+    // RGB8, top row first. Waits for the GPU to finish the frame.
+    [[nodiscard]]
+    std::vector<uint8_t> ReadPixels() const;
+
+    // Returns false when the file could not be written
+    bool WritePpm(std::filesystem::path const & path) const;
+
+private:
+
+    glm::ivec2 mSize;
+    TextureHandle mColor {};
+    TextureHandle mDepth {};
+    FramebufferHandle mFramebuffer {};
+};
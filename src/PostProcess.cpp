@@ -0,0 +1,371 @@
+#include "PostProcess.hpp"
+
+#include "AssetPath.h"
+
+#include <algorithm>
+#include <cmath>
+
+//======================================================================================================================
+
+PostProcess::PostProcess()
+{
+    auto const path = AssetPath::Instance();
+    auto const fullscreen = path->Get("shaders/fullscreen.vert");
+
+    mDownsampleShader = std::make_unique<ShaderProgram>(fullscreen, path->Get("shaders/bloom_downsample.frag"));
+    mDownsampleSource = mDownsampleShader->uniform("source");
+    mDownsampleTexelSize = mDownsampleShader->uniform("source_texel_size");
+    mDownsampleFirstLevel = mDownsampleShader->uniform("first_level");
+    mDownsampleThreshold = mDownsampleShader->uniform("threshold");
+
+    mUpsampleShader = std::make_unique<ShaderProgram>(fullscreen, path->Get("shaders/bloom_upsample.frag"));
+    mUpsampleSource = mUpsampleShader->uniform("source");
+    mUpsampleTexelSize = mUpsampleShader->uniform("source_texel_size");
+    mUpsampleRadius = mUpsampleShader->uniform("filter_radius");
+
+    mLuminanceShader = std::make_unique<ShaderProgram>(fullscreen, path->Get("shaders/luminance.frag"));
+    mLuminanceSource = mLuminanceShader->uniform("hdr_color");
+
+    mAdaptShader = std::make_unique<ShaderProgram>(fullscreen, path->Get("shaders/exposure_adapt.frag"));
+    mAdaptLogLuminance = mAdaptShader->uniform("log_luminance");
+    mAdaptLevel = mAdaptShader->uniform("luminance_level");
+    mAdaptPrevious = mAdaptShader->uniform("previous_luminance");
+    mAdaptRate = mAdaptShader->uniform("adaptation");
+
+    mTonemapShader = std::make_unique<ShaderProgram>(fullscreen, path->Get("shaders/tonemap.frag"));
+    mTonemapHdr = mTonemapShader->uniform("hdr_color");
+    mTonemapBloom = mTonemapShader->uniform("bloom");
+    mTonemapLuminance = mTonemapShader->uniform("adapted_luminance");
+    mTonemapBloomStrength = mTonemapShader->uniform("bloom_strength");
+    mTonemapBloomRect = mTonemapShader->uniform("bloom_rect");
+    mTonemapExposure = mTonemapShader->uniform("exposure_settings");
+
+    mUpscaleShader = std::make_unique<ShaderProgram>(fullscreen, path->Get("shaders/upscale.frag"));
+    mUpscaleSource = mUpscaleShader->uniform("source");
+    mUpscaleTexelSize = mUpscaleShader->uniform("source_texel_size");
+    mUpscaleSharpness = mUpscaleShader->uniform("sharpness");
+
+    // texture units never change, only what is bound to them
+    mDownsampleShader->use();
+    mDownsampleShader->set(mDownsampleSource, 0);
+    mUpsampleShader->use();
+    mUpsampleShader->set(mUpsampleSource, 0);
+    mLuminanceShader->use();
+    mLuminanceShader->set(mLuminanceSource, 0);
+    mAdaptShader->use();
+    mAdaptShader->set(mAdaptLogLuminance, 0);
+    mAdaptShader->set(mAdaptPrevious, 1);
+    mTonemapShader->use();
+    mTonemapShader->set(mTonemapHdr, 0);
+    mTonemapShader->set(mTonemapBloom, 1);
+    mTonemapShader->set(mTonemapLuminance, 2);
+    mUpscaleShader->use();
+    mUpscaleShader->set(mUpscaleSource, 0);
+    glUseProgram(0);
+
+    // start adapted to middle grey, which is an exposure of one
+    float const initial_log_luminance = std::log(mSettings.exposureKey);
+    for (auto const & texture : mAdaptedLuminance)
+    {
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, 1, 1, 0, GL_RED, GL_FLOAT, &initial_log_luminance);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+//======================================================================================================================
+
+void PostProcess::AddPasses(
+    FrameGraph & graph,
+    FrameGraph::ResourceId const hdrColor,
+    FrameGraph::ResourceId const output,
+    float const renderScale,
+    float const deltaTime
+)
+{
+    mPassNames.clear();
+
+    FrameGraph::ResourceId bloom {};
+    if (mBloomMode == BloomMode::Reuse && mRecordedBloomSize.x > 0)
+    {
+        FrameGraph::TextureDesc recorded_desc {};
+        recorded_desc.format = HdrFormat;
+        recorded_desc.size = mRecordedBloomSize;
+        bloom = graph.Import("recorded_bloom", mRecordedBloom, recorded_desc);
+    }
+    else
+    {
+        AddBloomPasses(graph, hdrColor, bloom);
+        if (mBloomMode == BloomMode::Record)
+        {
+            AddBloomRecordPass(graph, bloom);
+        }
+    }
+    glm::vec4 const bloom_rect = mBloomMode == BloomMode::Reuse ? mBloomRect : glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+
+    FrameGraph::ResourceId exposure {};
+    AddExposurePasses(graph, hdrColor, exposure, deltaTime);
+
+    // below full resolution tonemap at the scene's size, the upscale then writes the output
+    bool const upscale = renderScale < 1.0f;
+    FrameGraph::ResourceId tonemapped = output;
+    if (upscale)
+    {
+        FrameGraph::TextureDesc ldr_desc {};
+        ldr_desc.format = GL_SRGB8_ALPHA8;
+        ldr_desc.scale = renderScale;
+        tonemapped = graph.Create("ldr_color", ldr_desc);
+    }
+
+    FrameGraph::PassOptions tonemap_options {};
+    tonemap_options.srgb = true;
+    mPassNames.emplace_back("tonemap");
+    graph.AddPass(
+        mPassNames.back(),
+        [&](FrameGraph::Builder & builder)->void {
+            builder.Read(hdrColor);
+            builder.Read(bloom);
+            builder.Read(exposure);
+            builder.Write(tonemapped);
+        },
+        [this, hdrColor, bloom, exposure, bloom_rect](FrameGraph const & frameGraph)->void {
+            float const manual_exposure = mSettings.autoExposure ? 0.0f : mSettings.manualExposure;
+            mTonemapShader->use();
+            mTonemapShader->set(mTonemapBloomStrength, mSettings.bloomStrength);
+            mTonemapShader->set(mTonemapBloomRect, bloom_rect);
+            mTonemapShader->set(mTonemapExposure, glm::vec4(mSettings.exposureKey, mSettings.minExposure, mSettings.maxExposure, manual_exposure));
+            frameGraph.BindTexture(hdrColor, 0);
+            frameGraph.BindTexture(bloom, 1);
+            frameGraph.BindTexture(exposure, 2);
+            glDisable(GL_DEPTH_TEST);
+            frameGraph.DrawFullscreen();
+        },
+        tonemap_options
+    );
+
+    if (upscale)
+    {
+        AddUpscalePass(graph, tonemapped, output);
+    }
+}
+
+//======================================================================================================================
+
+void PostProcess::AddUpscalePass(FrameGraph & graph, FrameGraph::ResourceId const ldrColor, FrameGraph::ResourceId const output)
+{
+    // the source is sRGB, so filtering and sharpening happen on linear values and the write encodes them again
+    FrameGraph::PassOptions options {};
+    options.srgb = true;
+    mPassNames.emplace_back("upscale");
+    graph.AddPass(
+        mPassNames.back(),
+        [ldrColor, output](FrameGraph::Builder & builder)->void {
+            builder.Read(ldrColor);
+            builder.Write(output);
+        },
+        [this, ldrColor](FrameGraph const & frameGraph)->void {
+            mUpscaleShader->use();
+            mUpscaleShader->set(mUpscaleTexelSize, 1.0f / glm::vec2(frameGraph.GetSize(ldrColor)));
+            mUpscaleShader->set(mUpscaleSharpness, mSettings.sharpness);
+            frameGraph.BindTexture(ldrColor, 0);
+            glDisable(GL_DEPTH_TEST);
+            frameGraph.DrawFullscreen();
+        },
+        options
+    );
+}
+
+//======================================================================================================================
+
+// Level 0 is at QualitySteps[mQuality].bloomScale of the backbuffer, every further level half the size of the one
+// before. Going up, each level gets the filtered level above it added, so level 0 ends up with all of them.
+void PostProcess::AddBloomPasses(FrameGraph & graph, FrameGraph::ResourceId const hdrColor, FrameGraph::ResourceId & bloom)
+{
+    Quality const quality = QualitySteps[mQuality];
+    mStats.bloomLevels = quality.bloomLevels;
+    mStats.bloomScale = quality.bloomScale;
+
+    std::vector<FrameGraph::ResourceId> chain(static_cast<size_t>(quality.bloomLevels));
+    for (int level = 0; level < quality.bloomLevels; ++level)
+    {
+        FrameGraph::ResourceId const source = level == 0 ? hdrColor : chain[level - 1];
+        mPassNames.emplace_back("bloom_down_" + std::to_string(level));
+        graph.AddPass(
+            mPassNames.back(),
+            [&](FrameGraph::Builder & builder)->void {
+                FrameGraph::TextureDesc desc {};
+                desc.format = HdrFormat;
+                desc.scale = quality.bloomScale / static_cast<float>(1 << level);
+                chain[level] = builder.Create("bloom_" + std::to_string(level), desc);
+                builder.Read(source);
+                builder.Write(chain[level]);
+            },
+            [this, source, level](FrameGraph const & frameGraph)->void {
+                float const knee = std::max(mSettings.bloomKnee, 1e-4f);
+                mDownsampleShader->use();
+                mDownsampleShader->set(mDownsampleTexelSize, 1.0f / glm::vec2(frameGraph.GetSize(source)));
+                mDownsampleShader->set(mDownsampleFirstLevel, level == 0 ? 1 : 0);
+                mDownsampleShader->set(mDownsampleThreshold, glm::vec4(
+                    mSettings.bloomThreshold, mSettings.bloomThreshold - knee, 2.0f * knee, 0.25f / knee
+                ));
+                frameGraph.BindTexture(source, 0);
+                glDisable(GL_DEPTH_TEST);
+                frameGraph.DrawFullscreen();
+            }
+        );
+    }
+
+    for (int level = quality.bloomLevels - 2; level >= 0; --level)
+    {
+        FrameGraph::ResourceId const source = chain[level + 1];
+        FrameGraph::ResourceId const target = chain[level];
+        mPassNames.emplace_back("bloom_up_" + std::to_string(level));
+        graph.AddPass(
+            mPassNames.back(),
+            [source, target](FrameGraph::Builder & builder)->void {
+                builder.Read(source);
+                builder.Write(target);
+            },
+            [this, source](FrameGraph const & frameGraph)->void {
+                mUpsampleShader->use();
+                mUpsampleShader->set(mUpsampleTexelSize, 1.0f / glm::vec2(frameGraph.GetSize(source)));
+                mUpsampleShader->set(mUpsampleRadius, mSettings.bloomRadius);
+                frameGraph.BindTexture(source, 0);
+
+                glEnable(GL_BLEND);
+                glBlendFunc(GL_ONE, GL_ONE);
+                glDisable(GL_DEPTH_TEST);
+                frameGraph.DrawFullscreen();
+                glDisable(GL_BLEND);
+            }
+        );
+    }
+
+    bloom = chain[0];
+}
+
+//======================================================================================================================
+
+// Copies the finished bloom into a texture that outlives the frame, sized like it, for BloomMode::Reuse
+void PostProcess::AddBloomRecordPass(FrameGraph & graph, FrameGraph::ResourceId const bloom)
+{
+    // the copy is for later frames, nothing in this one reads it
+    FrameGraph::PassOptions options {};
+    options.sideEffects = true;
+    mPassNames.emplace_back("bloom_record");
+    graph.AddPass(
+        mPassNames.back(),
+        [bloom](FrameGraph::Builder & builder)->void {
+            builder.Read(bloom);
+        },
+        [this, bloom](FrameGraph const & frameGraph)->void {
+            frameGraph.CopyToTexture(bloom, mRecordedBloom, mRecordedBloomSize);
+        },
+        options
+    );
+}
+
+//======================================================================================================================
+
+void PostProcess::AddExposurePasses(
+    FrameGraph & graph,
+    FrameGraph::ResourceId const hdrColor,
+    FrameGraph::ResourceId & exposure,
+    float const deltaTime
+)
+{
+    mPassNames.emplace_back("luminance");
+    graph.AddPass(
+        mPassNames.back(),
+        [this, hdrColor](FrameGraph::Builder & builder)->void {
+            FrameGraph::TextureDesc desc {};
+            desc.format = GL_R16F;
+            desc.size = glm::ivec2(LuminanceSize);
+            desc.levels = 32; // clamped to the full chain
+            mLogLuminance = builder.Create("log_luminance", desc);
+            builder.Read(hdrColor);
+            builder.Write(mLogLuminance);
+        },
+        [this, hdrColor](FrameGraph const & frameGraph)->void {
+            mLuminanceShader->use();
+            frameGraph.BindTexture(hdrColor, 0);
+            glDisable(GL_DEPTH_TEST);
+            frameGraph.DrawFullscreen();
+
+            // averages down to the last level, which is what the adaptation reads
+            glBindTexture(GL_TEXTURE_2D, frameGraph.GetTexture(mLogLuminance));
+            glGenerateMipmap(GL_TEXTURE_2D);
+            glBindTexture(GL_TEXTURE_2D, 0);
+        }
+    );
+
+    FrameGraph::TextureDesc adapted_desc {};
+    adapted_desc.format = GL_R32F;
+    adapted_desc.size = glm::ivec2(1);
+    FrameGraph::ResourceId const previous = graph.Import("adapted_luminance_previous", mAdaptedLuminance[mAdaptedIndex], adapted_desc);
+    exposure = graph.Import("adapted_luminance", mAdaptedLuminance[1 - mAdaptedIndex], adapted_desc);
+    mAdaptedIndex = 1 - mAdaptedIndex;
+
+    float const adaptation = 1.0f - std::exp(-deltaTime * mSettings.adaptationSpeed);
+    float const top_level = std::log2(static_cast<float>(LuminanceSize));
+    mPassNames.emplace_back("exposure");
+    graph.AddPass(
+        mPassNames.back(),
+        [this, previous, exposure](FrameGraph::Builder & builder)->void {
+            builder.Read(mLogLuminance);
+            builder.Read(previous);
+            builder.Write(exposure);
+        },
+        [this, previous, adaptation, top_level](FrameGraph const & frameGraph)->void {
+            mAdaptShader->use();
+            mAdaptShader->set(mAdaptLevel, top_level);
+            mAdaptShader->set(mAdaptRate, adaptation);
+            frameGraph.BindTexture(mLogLuminance, 0);
+            frameGraph.BindTexture(previous, 1);
+            glDisable(GL_DEPTH_TEST);
+            frameGraph.DrawFullscreen();
+        }
+    );
+}
+
+//======================================================================================================================
+
+void PostProcess::SetBloomMode(BloomMode const mode, glm::vec4 const & rect)
+{
+    mBloomMode = mode;
+    mBloomRect = rect;
+}
+
+//======================================================================================================================
+
+void PostProcess::ApplyBudget(FrameGraph const & graph)
+{
+    mStats.gpuMs = 0.0f;
+    for (auto const & name : mPassNames)
+    {
+        mStats.gpuMs += graph.GetPassTime(name);
+    }
+
+    // the timings lag a few frames and are smoothed, so give them time to settle after a change
+    mFramesSinceChange += 1;
+    if (mFramesSinceChange < BudgetInterval)
+    {
+        return;
+    }
+
+    if (mStats.gpuMs > mSettings.budgetMs && mQuality + 1 < QualityStepCount)
+    {
+        mQuality += 1;
+        mFramesSinceChange = 0;
+    }
+    else if (mStats.gpuMs < 0.5f * mSettings.budgetMs && mQuality > 0)
+    {
+        mQuality -= 1;
+        mFramesSinceChange = 0;
+    }
+}
+
+//======================================================================================================================
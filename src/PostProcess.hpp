@@ -0,0 +1,165 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Everything between the HDR scene and the backbuffer: a bloom mip chain at a
+// fraction of the screen resolution (13 tap downsample, tent upsample), the
+// average scene luminance from the mip chain of a small log luminance texture,
+// exposure adaptation in a 1x1 texture that never leaves the GPU, and ACES
+// tonemapping into the sRGB backbuffer. When the scene is rendered below the
+// window resolution the tonemapped image is upscaled and sharpened last. All of
+// it is added as frame graph passes. The graph times every pass, and when the
+// stages together take longer than their budget the bloom chain gets shorter
+// and coarser.
+//------------------------------------------------------------------------------
+
+#include "FrameGraph.hpp"
+#include "GLHandles.h"
+#include "ShaderProgram.h"
+
+#include <glm/glm.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+class PostProcess
+{
+public:
+
+    static constexpr GLenum HdrFormat = GL_RGBA16F;
+
+    struct Settings
+    {
+        float bloomStrength = 0.04f;    // mix factor between the scene and the bloom
+        float bloomThreshold = 1.0f;
+        float bloomKnee = 0.5f;
+        float bloomRadius = 1.0f;       // upsample tent radius in texels
+        bool autoExposure = true;
+        float manualExposure = 1.0f;
+        float exposureKey = 0.18f;      // middle grey the average luminance is mapped to
+        float minExposure = 0.1f;
+        float maxExposure = 1.5f;
+        float adaptationSpeed = 1.5f;
+        float budgetMs = 1.0f;          // GPU time for all the stages together
+        float sharpness = 0.5f;         // of the upscale, 0 to 1
+    };
+
+    // Poster tiles (see SolarSystem::RenderPoster) would each blur only their own pixels, so the glow of a bright body
+    // would stop at every tile border. Record keeps the bloom of a frame showing the whole poster, Reuse skips the
+    // chain and samples the kept bloom over a rectangle of it instead.
+    enum class BloomMode
+    {
+        Own,
+        Record,
+        Reuse
+    };
+
+    struct Stats
+    {
+        float gpuMs = 0.0f;
+        int bloomLevels = 0;
+        float bloomScale = 0.0f;
+    };
+
+    explicit PostProcess();
+
+    // Adds the passes that turn hdrColor into the final image in output (usually the backbuffer). renderScale is the
+    // size of hdrColor relative to output, below one the image is tonemapped at that size and then upscaled.
+    void AddPasses(
+        FrameGraph & graph,
+        FrameGraph::ResourceId hdrColor,
+        FrameGraph::ResourceId output,
+        float renderScale,
+        float deltaTime
+    );
+
+    // rect is the part of the recorded frame this frame shows, offset and size in its uv, only used by Reuse
+    void SetBloomMode(BloomMode mode, glm::vec4 const & rect);
+
+    // Sums the measured time of this frame's passes and moves one quality step when it is over or well under budget
+    void ApplyBudget(FrameGraph const & graph);
+
+    [[nodiscard]]
+    Settings & GetSettings() { return mSettings; }
+
+    [[nodiscard]]
+    Stats const & GetStats() const { return mStats; }
+
+private:
+
+    struct Quality
+    {
+        float bloomScale;
+        int bloomLevels;
+    };
+
+    // best first
+    static constexpr Quality QualitySteps[] = {
+        {0.5f, 6},
+        {0.5f, 5},
+        {0.5f, 4},
+        {0.25f, 4},
+        {0.25f, 3},
+    };
+    static constexpr int QualityStepCount = static_cast<int>(sizeof(QualitySteps) / sizeof(QualitySteps[0]));
+    static constexpr int BudgetInterval = 30;  // frames between quality changes
+    static constexpr int LuminanceSize = 256;
+
+    void AddBloomPasses(FrameGraph & graph, FrameGraph::ResourceId hdrColor, FrameGraph::ResourceId & bloom);
+
+    void AddBloomRecordPass(FrameGraph & graph, FrameGraph::ResourceId bloom);
+
+    void AddExposurePasses(FrameGraph & graph, FrameGraph::ResourceId hdrColor, FrameGraph::ResourceId & exposure, float deltaTime);
+
+    void AddUpscalePass(FrameGraph & graph, FrameGraph::ResourceId ldrColor, FrameGraph::ResourceId output);
+
+    Settings mSettings {};
+    Stats mStats {};
+    int mQuality = 0;
+    int mFramesSinceChange = 0;
+    BloomMode mBloomMode = BloomMode::Own;
+    glm::vec4 mBloomRect {0.0f, 0.0f, 1.0f, 1.0f};
+    std::vector<std::string> mPassNames {};
+    FrameGraph::ResourceId mLogLuminance {}; // of the frame being built
+
+    std::unique_ptr<ShaderProgram> mDownsampleShader {};
+    ShaderProgram::Uniform mDownsampleSource {};
+    ShaderProgram::Uniform mDownsampleTexelSize {};
+    ShaderProgram::Uniform mDownsampleFirstLevel {};
+    ShaderProgram::Uniform mDownsampleThreshold {};
+
+    std::unique_ptr<ShaderProgram> mUpsampleShader {};
+    ShaderProgram::Uniform mUpsampleSource {};
+    ShaderProgram::Uniform mUpsampleTexelSize {};
+    ShaderProgram::Uniform mUpsampleRadius {};
+
+    std::unique_ptr<ShaderProgram> mLuminanceShader {};
+    ShaderProgram::Uniform mLuminanceSource {};
+
+    std::unique_ptr<ShaderProgram> mAdaptShader {};
+    ShaderProgram::Uniform mAdaptLogLuminance {};
+    ShaderProgram::Uniform mAdaptLevel {};
+    ShaderProgram::Uniform mAdaptPrevious {};
+    ShaderProgram::Uniform mAdaptRate {};
+
+    std::unique_ptr<ShaderProgram> mTonemapShader {};
+    ShaderProgram::Uniform mTonemapHdr {};
+    ShaderProgram::Uniform mTonemapBloom {};
+    ShaderProgram::Uniform mTonemapLuminance {};
+    ShaderProgram::Uniform mTonemapBloomStrength {};
+    ShaderProgram::Uniform mTonemapBloomRect {};
+    ShaderProgram::Uniform mTonemapExposure {};
+
+    std::unique_ptr<ShaderProgram> mUpscaleShader {};
+    ShaderProgram::Uniform mUpscaleSource {};
+    ShaderProgram::Uniform mUpscaleTexelSize {};
+    ShaderProgram::Uniform mUpscaleSharpness {};
+
+    // adapted log luminance, ping-ponged between frames
+    TextureHandle mAdaptedLuminance[2] {};
+    int mAdaptedIndex = 0;
+
+    // see BloomMode
+    TextureHandle mRecordedBloom {};
+    glm::ivec2 mRecordedBloomSize {0, 0};
+};
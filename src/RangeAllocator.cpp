@@ -0,0 +1,102 @@
+#include "RangeAllocator.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+//======================================================================================================================
+
+RangeAllocator::RangeAllocator(uint32_t const capacity)
+{
+    Reset(capacity, 0);
+}
+
+//======================================================================================================================
+
+std::optional<uint32_t> RangeAllocator::Allocate(uint32_t const size)
+{
+    if (size == 0)
+    {
+        return std::nullopt;
+    }
+
+    for (auto it = mFreeRanges.begin(); it != mFreeRanges.end(); ++it)
+    {
+        if (it->second < size)
+        {
+            continue;
+        }
+
+        uint32_t const offset = it->first;
+        uint32_t const remaining = it->second - size;
+        mFreeRanges.erase(it);
+        if (remaining > 0)
+        {
+            mFreeRanges.emplace(offset + size, remaining);
+        }
+        mUsed += size;
+        return offset;
+    }
+    return std::nullopt;
+}
+
+//======================================================================================================================
+
+void RangeAllocator::Free(uint32_t const offset, uint32_t const size)
+{
+    if (size == 0)
+    {
+        return;
+    }
+    mUsed -= size;
+
+    uint32_t start = offset;
+    uint32_t end = offset + size;
+
+    // merge with the free range right after
+    auto next = mFreeRanges.lower_bound(offset);
+    if (next != mFreeRanges.end() && next->first == end)
+    {
+        end += next->second;
+        next = mFreeRanges.erase(next);
+    }
+
+    // and the one right before
+    if (next != mFreeRanges.begin())
+    {
+        auto const previous = std::prev(next);
+        if (previous->first + previous->second == start)
+        {
+            start = previous->first;
+            mFreeRanges.erase(previous);
+        }
+    }
+
+    mFreeRanges.emplace(start, end - start);
+}
+
+//======================================================================================================================
+
+void RangeAllocator::Reset(uint32_t const capacity, uint32_t const used)
+{
+    mCapacity = capacity;
+    mUsed = std::min(used, capacity);
+    mFreeRanges.clear();
+    if (mUsed < mCapacity)
+    {
+        mFreeRanges.emplace(mUsed, mCapacity - mUsed);
+    }
+}
+
+//======================================================================================================================
+
+uint32_t RangeAllocator::LargestFreeRange() const
+{
+    uint32_t largest = 0;
+    for (auto const & [offset, size] : mFreeRanges)
+    {
+        largest = std::max(largest, size);
+    }
+    return largest;
+}
+
+//======================================================================================================================
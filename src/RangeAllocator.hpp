@@ -0,0 +1,39 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// First-fit allocator for ranges of a fixed size pool (vertices, indices).
+// It only does the bookkeeping, the caller owns the memory. Freed ranges are
+// merged with their free neighbours, so fragmentation only comes from the
+// order of frees; Reset() after compacting the pool removes it completely.
+//------------------------------------------------------------------------------
+
+#include <cstdint>
+#include <map>
+#include <optional>
+
+class RangeAllocator
+{
+public:
+
+    explicit RangeAllocator(uint32_t capacity = 0);
+
+    // Offset of a free range of size elements, nothing if no free range is large enough
+    [[nodiscard]]
+    std::optional<uint32_t> Allocate(uint32_t size);
+
+    void Free(uint32_t offset, uint32_t size);
+
+    // [0, used) is taken, the rest of the new capacity is one free range
+    void Reset(uint32_t capacity, uint32_t used);
+
+    [[nodiscard]] uint32_t Capacity() const { return mCapacity; }
+    [[nodiscard]] uint32_t Used() const { return mUsed; }
+    [[nodiscard]] size_t FreeRangeCount() const { return mFreeRanges.size(); }
+    [[nodiscard]] uint32_t LargestFreeRange() const;
+
+private:
+
+    std::map<uint32_t, uint32_t> mFreeRanges {}; // offset -> size
+    uint32_t mCapacity = 0;
+    uint32_t mUsed = 0;
+};
@@ -0,0 +1,126 @@
+#include "RenderQueue.hpp"
+
+#include <algorithm>
+#include <array>
+
+namespace
+{
+    constexpr int DepthShift = 0;
+    constexpr int MeshShift = DepthShift + RenderQueue::DepthBits;
+    constexpr int MaterialShift = MeshShift + RenderQueue::MeshBits;
+    constexpr int ProgramShift = MaterialShift + RenderQueue::MaterialBits;
+    constexpr int PassShift = ProgramShift + RenderQueue::ProgramBits;
+    static_assert(PassShift + RenderQueue::PassBits == 64, "sort key fields must fill 64 bits");
+
+    constexpr uint64_t Mask(int const bits)
+    {
+        return (uint64_t{1} << bits) - 1;
+    }
+}
+
+//======================================================================================================================
+
+uint64_t RenderQueue::MakeKey(
+    Pass const pass,
+    uint32_t const program,
+    uint32_t const material,
+    uint32_t const mesh,
+    float const depth
+)
+{
+    float const clampedDepth = std::clamp(depth, 0.0f, 1.0f);
+    auto const quantizedDepth = static_cast<uint64_t>(clampedDepth * static_cast<float>(Mask(DepthBits)));
+
+    return ((static_cast<uint64_t>(pass) & Mask(PassBits)) << PassShift) |
+           ((static_cast<uint64_t>(program) & Mask(ProgramBits)) << ProgramShift) |
+           ((static_cast<uint64_t>(material) & Mask(MaterialBits)) << MaterialShift) |
+           ((static_cast<uint64_t>(mesh) & Mask(MeshBits)) << MeshShift) |
+           (quantizedDepth << DepthShift);
+}
+
+//======================================================================================================================
+
+RenderQueue::Pass RenderQueue::PassOf(uint64_t const key)
+{
+    return static_cast<Pass>((key >> PassShift) & Mask(PassBits));
+}
+
+uint32_t RenderQueue::ProgramOf(uint64_t const key)
+{
+    return static_cast<uint32_t>((key >> ProgramShift) & Mask(ProgramBits));
+}
+
+uint32_t RenderQueue::MaterialOf(uint64_t const key)
+{
+    return static_cast<uint32_t>((key >> MaterialShift) & Mask(MaterialBits));
+}
+
+uint32_t RenderQueue::MeshOf(uint64_t const key)
+{
+    return static_cast<uint32_t>((key >> MeshShift) & Mask(MeshBits));
+}
+
+//======================================================================================================================
+
+void RenderQueue::Clear()
+{
+    mItems.clear();
+}
+
+//======================================================================================================================
+
+void RenderQueue::Push(uint64_t const key, uint32_t const bodyIndex)
+{
+    mItems.emplace_back(DrawItem{key, bodyIndex});
+}
+
+//======================================================================================================================
+
+void RenderQueue::Sort()
+{
+    size_t const count = mItems.size();
+    if (count < 2)
+    {
+        return;
+    }
+
+    mScratch.resize(count);
+    DrawItem * source = mItems.data();
+    DrawItem * destination = mScratch.data();
+
+    for (int shift = 0; shift < 64; shift += 8)
+    {
+        std::array<size_t, 256> offsets{};
+        for (size_t i = 0; i < count; ++i)
+        {
+            offsets[(source[i].key >> shift) & 0xFF] += 1;
+        }
+
+        // every key has the same byte here, the order would not change
+        if (offsets[(source[0].key >> shift) & 0xFF] == count)
+        {
+            continue;
+        }
+
+        size_t total = 0;
+        for (auto & offset : offsets)
+        {
+            size_t const bucketCount = offset;
+            offset = total;
+            total += bucketCount;
+        }
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            destination[offsets[(source[i].key >> shift) & 0xFF]++] = source[i];
+        }
+        std::swap(source, destination);
+    }
+
+    if (source != mItems.data())
+    {
+        std::copy(source, source + count, mItems.data());
+    }
+}
+
+//======================================================================================================================
@@ -0,0 +1,61 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Draw items with a packed 64 bit sort key, radix sorted so that submitting
+// them in order only changes GL state when a key field actually changes.
+//
+//  63      60 59       52 51             36 35        24 23             0
+// [  pass   ][ program   ][ material/texture][   mesh    ][     depth     ]
+//------------------------------------------------------------------------------
+
+#include <cstdint>
+#include <vector>
+
+class RenderQueue
+{
+public:
+
+    // Passes are submitted in this order
+    enum class Pass : uint32_t
+    {
+        Occluders = 0,  // large bodies, only split out when occlusion culling is on
+        Opaque = 1,
+        Transparent = 2 // without depth writes into the weighted blended targets, see Transparency
+    };
+
+    struct DrawItem
+    {
+        uint64_t key;
+        uint32_t bodyIndex;
+    };
+
+    static constexpr int DepthBits = 24;
+    static constexpr int MeshBits = 12;
+    static constexpr int MaterialBits = 16;
+    static constexpr int ProgramBits = 8;
+    static constexpr int PassBits = 4;
+
+    // depth is normalized to [0, 1] and sorts front to back
+    [[nodiscard]]
+    static uint64_t MakeKey(Pass pass, uint32_t program, uint32_t material, uint32_t mesh, float depth);
+
+    [[nodiscard]] static Pass PassOf(uint64_t key);
+    [[nodiscard]] static uint32_t ProgramOf(uint64_t key);
+    [[nodiscard]] static uint32_t MaterialOf(uint64_t key);
+    [[nodiscard]] static uint32_t MeshOf(uint64_t key);
+
+    void Clear();
+
+    void Push(uint64_t key, uint32_t bodyIndex);
+
+    // LSD radix sort, 8 bits per pass. Passes where every key has the same byte are skipped.
+    void Sort();
+
+    [[nodiscard]]
+    std::vector<DrawItem> const & Items() const { return mItems; }
+
+private:
+
+    std::vector<DrawItem> mItems {};
+    std::vector<DrawItem> mScratch {};
+};
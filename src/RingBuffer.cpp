@@ -0,0 +1,142 @@
+#include "RingBuffer.h"
+
+#include "Log.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+//======================================================================================================================
+
+RingBuffer::RingBuffer(GLsizeiptr frameCapacity, int framesInFlight)
+	: bufferID{}
+	, frameCapacity(frameCapacity)
+	, framesInFlight(std::clamp(framesInFlight, 1, MaxFramesInFlight))
+{
+	allocateStorage();
+	Log::info("RING_BUFFER {} frames in flight, {}", this->framesInFlight, isPersistent() ? "persistently mapped" : "orphaned");
+}
+
+RingBuffer::~RingBuffer() {
+	waitForAllFences();
+	if (mappedData != nullptr) {
+		glBindBuffer(GL_ARRAY_BUFFER, bufferID);
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+	}
+}
+
+void RingBuffer::reserve(GLsizeiptr newFrameCapacity) {
+	if (newFrameCapacity <= frameCapacity) {
+		return;
+	}
+
+	// draws of the last frames may still read the old storage
+	waitForAllFences();
+	if (mappedData != nullptr) {
+		glBindBuffer(GL_ARRAY_BUFFER, bufferID);
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+		mappedData = nullptr;
+	}
+
+	frameCapacity = newFrameCapacity;
+	bufferID = VertexBufferHandle{};
+	allocateStorage();
+}
+
+void RingBuffer::beginFrame() {
+	region = (region + 1) % framesInFlight;
+	head = 0;
+	inFrame = true;
+	stats.bytesUsed = 0;
+
+	GLsync& fence = fences[static_cast<size_t>(region)];
+	if (fence != nullptr) {
+		// only blocks when the GPU is still on the frame that last used this region
+		GLenum result = glClientWaitSync(fence, 0, 0);
+		if (result == GL_TIMEOUT_EXPIRED) {
+			stats.fenceWaits += 1;
+			while (result == GL_TIMEOUT_EXPIRED) {
+				result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000); // 1 ms
+			}
+		}
+		glDeleteSync(fence);
+		fence = nullptr;
+	}
+
+	if (mappedData == nullptr) {
+		glBindBuffer(GL_ARRAY_BUFFER, bufferID);
+		glBufferData(GL_ARRAY_BUFFER, frameCapacity * framesInFlight, nullptr, GL_STREAM_DRAW);
+	}
+}
+
+RingBuffer::Allocation RingBuffer::upload(const void* data, GLsizeiptr size, GLsizeiptr alignment) {
+	if (inFrame == false) {
+		throw std::runtime_error("RingBuffer::upload called outside beginFrame/endFrame");
+	}
+
+	GLsizeiptr const start = ((head + alignment - 1) / alignment) * alignment;
+	if (start + size > frameCapacity) {
+		Log::error("RING_BUFFER frame region of {} bytes is full, {} more needed", frameCapacity, start + size - frameCapacity);
+		throw std::runtime_error("RingBuffer frame region is full");
+	}
+
+	Allocation const allocation{static_cast<GLintptr>(region) * frameCapacity + start, size};
+	if (mappedData != nullptr) {
+		std::memcpy(mappedData + allocation.offset, data, static_cast<size_t>(size));
+	}
+	else {
+		glBindBuffer(GL_ARRAY_BUFFER, bufferID);
+		glBufferSubData(GL_ARRAY_BUFFER, allocation.offset, size, data);
+	}
+
+	head = start + size;
+	stats.bytesUsed = head;
+	return allocation;
+}
+
+void RingBuffer::endFrame() {
+	inFrame = false;
+	if (mappedData != nullptr) {
+		fences[static_cast<size_t>(region)] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+}
+
+GLsizeiptr RingBuffer::bindAlignment() {
+	static GLint alignment = 0;
+	if (alignment == 0) {
+		GLint uniformAlignment = 16;
+		glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformAlignment);
+		GLint storageAlignment = 16;
+		if (GLAD_GL_VERSION_4_3) {
+			glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &storageAlignment);
+		}
+		alignment = std::max({uniformAlignment, storageAlignment, 16});
+	}
+	return alignment;
+}
+
+void RingBuffer::allocateStorage() {
+	glBindBuffer(GL_ARRAY_BUFFER, bufferID);
+	GLsizeiptr const size = frameCapacity * framesInFlight;
+
+	if (GLAD_GL_VERSION_4_4) {
+		GLbitfield const flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(GL_ARRAY_BUFFER, size, nullptr, flags);
+		mappedData = static_cast<uint8_t*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, size, flags));
+	}
+	else {
+		glBufferData(GL_ARRAY_BUFFER, size, nullptr, GL_STREAM_DRAW);
+	}
+}
+
+void RingBuffer::waitForAllFences() {
+	for (GLsync& fence : fences) {
+		if (fence != nullptr) {
+			glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+			glDeleteSync(fence);
+			fence = nullptr;
+		}
+	}
+}
+
+//======================================================================================================================
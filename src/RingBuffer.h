@@ -0,0 +1,81 @@
+#pragma once
+
+#include "GLHandles.h"
+
+#include <glad/glad.h>
+
+#include <array>
+#include <cstdint>
+
+
+// Per-frame data (camera block, instance matrices, body transforms) goes through one buffer
+// split into framesInFlight regions. Frame N writes its region while the GPU may still be
+// reading the regions of frames N-1 and N-2, so an upload never waits on a draw.
+//
+// On GL 4.4+ the buffer is persistently mapped and every region is guarded by a GLsync
+// fence, which is only waited on if the GPU is more than framesInFlight frames behind.
+// On 3.3 the buffer is orphaned at the start of every frame and written with
+// glBufferSubData, so the driver hands out fresh storage instead of syncing.
+//
+// Usage per frame: beginFrame(), any number of upload(), then endFrame() after the
+// last draw that reads this frame's data.
+class RingBuffer {
+
+public:
+	static constexpr int MaxFramesInFlight = 4;
+
+	struct Allocation {
+		GLintptr offset = 0;	// from the start of the buffer, for glBindBufferRange or attribute offsets
+		GLsizeiptr size = 0;
+	};
+
+	struct Stats {
+		GLsizeiptr bytesUsed = 0;	// by the current frame
+		int fenceWaits = 0;			// frames that had to wait for the GPU, since startup
+	};
+
+	RingBuffer(GLsizeiptr frameCapacity, int framesInFlight = 3);
+
+	// Owns a mapping and fences besides the buffer handle, so it can't be copied
+	RingBuffer(const RingBuffer&) = delete;
+	RingBuffer& operator=(const RingBuffer&) = delete;
+	~RingBuffer();
+
+	// Public interface
+
+	// Makes every region at least frameCapacity bytes. Call outside beginFrame/endFrame,
+	// growing waits for the GPU to finish with the old buffer.
+	void reserve(GLsizeiptr frameCapacity);
+
+	void beginFrame();
+
+	// Copies size bytes into this frame's region at a multiple of alignment.
+	// Throws if the region is full, reserve() enough up front.
+	Allocation upload(const void* data, GLsizeiptr size, GLsizeiptr alignment);
+
+	void endFrame();
+
+	GLuint getID() const { return bufferID; }
+	bool isPersistent() const { return mappedData != nullptr; }
+	const Stats& getStats() const { return stats; }
+
+	// The largest offset alignment of the binding targets the ring is used with (uniform, storage, 16)
+	static GLsizeiptr bindAlignment();
+
+private:
+	VertexBufferHandle bufferID;
+	GLsizeiptr frameCapacity = 0;
+	int framesInFlight;
+
+	int region = 0;				// region of the current frame
+	GLsizeiptr head = 0;		// next free byte in that region
+	bool inFrame = false;
+
+	uint8_t* mappedData = nullptr;	// persistent mapping, null on 3.3
+	std::array<GLsync, MaxFramesInFlight> fences{};
+
+	Stats stats;
+
+	void allocateStorage();
+	void waitForAllFences();
+};
@@ -11,9 +11,15 @@
 
 
 Shader::Shader(const std::string& path, GLenum type)
+	: Shader(path, type, {})
+{
+}
+
+Shader::Shader(const std::string& path, GLenum type, const std::vector<std::string>& defines)
 	: shaderID(type)
 	, type(type)
 	, path(path)
+	, defines(defines)
 {
 	if (!compile()) {
 		throw std::runtime_error("Shader did not compile");
@@ -46,6 +52,18 @@ bool Shader::compile() {
 		Log::error("SHADER reading {}:\n{}", path, strerror(errno));
 		return false;
 	}
+
+	// the defines go right after #version, which has to stay the first line. #line keeps the
+	// line numbers of compile errors pointing into the file
+	if (!defines.empty()) {
+		size_t const versionEnd = sourceString.find('\n') + 1;
+		std::string defineLines;
+		for (const auto& define : defines) {
+			defineLines += "#define " + define + "\n";
+		}
+		defineLines += "#line 2\n";
+		sourceString.insert(versionEnd, defineLines);
+	}
 	const GLchar* sourceCode = sourceString.c_str();
 
 
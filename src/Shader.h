@@ -5,14 +5,19 @@
 #include <glad/glad.h>
 
 #include <string>
+#include <vector>
 
 class ShaderProgram;
+class ComputeProgram;
 
 class Shader {
 
 public:
 	Shader(const std::string& path, GLenum type);
 
+	// Compiles the file with a #define for every name inserted after its #version line
+	Shader(const std::string& path, GLenum type, const std::vector<std::string>& defines);
+
 	// Because we're using the ShaderHandle to do RAII for the shader for us
 	// and our other types are trivial or provide their own RAII
 	// we don't have to provide any specialized functions here. Rule of zero
@@ -23,14 +28,17 @@ public:
 	// Public interface
 	std::string getPath() const { return path; }
 	GLenum getType() const { return type; }
+	const std::vector<std::string>& getDefines() const { return defines; }
 
 	void friend attach(ShaderProgram& sp, Shader& s);
+	void friend attach(ComputeProgram& cp, Shader& s);
 
 private:
 	ShaderHandle shaderID;
 	GLenum type;
 
 	std::string path;
+	std::vector<std::string> defines;
 
 	bool compile();
 };
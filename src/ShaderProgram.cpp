@@ -9,14 +9,22 @@
 
 ShaderProgram::ShaderProgram(const std::string &vertexPath,
                              const std::string &fragmentPath)
-    : programID(),
-      vertex(AssetPath::Instance()->Get(vertexPath), GL_VERTEX_SHADER),
-      fragment(AssetPath::Instance()->Get(fragmentPath), GL_FRAGMENT_SHADER) {
+    : ShaderProgram(vertexPath, fragmentPath, {}) {}
+
+ShaderProgram::ShaderProgram(const std::string &vertexPath,
+                             const std::string &fragmentPath,
+                             const std::vector<std::string> &defines)
+    : LinkedProgram("SHADER_PROGRAM"),
+      programID(),
+      vertex(AssetPath::Instance()->Get(vertexPath), GL_VERTEX_SHADER,
+             defines),
+      fragment(AssetPath::Instance()->Get(fragmentPath), GL_FRAGMENT_SHADER,
+               defines) {
   attach(*this, vertex);
   attach(*this, fragment);
-  glLinkProgram(programID);
+  name = vertex.getPath() + " + " + fragment.getPath();
 
-  if (!checkAndLogLinkSuccess()) {
+  if (!link(programID)) {
     glDeleteProgram(programID);
     throw std::runtime_error("Shaders did not link.");
   }
@@ -26,7 +34,19 @@ bool ShaderProgram::recompile() {
 
   try {
     // Try to create a new program
-    ShaderProgram newProgram(vertex.getPath(), fragment.getPath());
+    ShaderProgram newProgram(vertex.getPath(), fragment.getPath(),
+                             vertex.getDefines());
+    // keep every handle handed out so far valid in the new program
+    newProgram.slotNames = slotNames;
+    newProgram.resolveSlots();
+    for (size_t slot = 0; slot < slotNames.size(); ++slot) {
+      if (slotLocations[slot] >= 0 && newProgram.slotLocations[slot] < 0) {
+        Log::warn("SHADER_PROGRAM uniform \"{}\" is no longer active",
+                  slotNames[slot]);
+      }
+    }
+    // the values set so far, e.g. sampler units that are only set at startup
+    newProgram.copyUniformValues(*this, programID, newProgram.programID);
     *this = std::move(newProgram);
     return true;
   } catch (std::runtime_error &e) {
@@ -38,24 +58,3 @@ bool ShaderProgram::recompile() {
 void attach(ShaderProgram &sp, Shader &s) {
   glAttachShader(sp.programID, s.shaderID);
 }
-
-bool ShaderProgram::checkAndLogLinkSuccess() const {
-
-  GLint success;
-
-  glGetProgramiv(programID, GL_LINK_STATUS, &success);
-  if (!success) {
-    GLint logLength;
-    glGetProgramiv(programID, GL_INFO_LOG_LENGTH, &logLength);
-    std::vector<char> log(logLength);
-    glGetProgramInfoLog(programID, logLength, NULL, log.data());
-
-    Log::error("SHADER_PROGRAM linking {} + {}:\n{}", vertex.getPath(),
-               fragment.getPath(), log.data());
-    return false;
-  } else {
-    Log::info("SHADER_PROGRAM successfully compiled and linked {} + {}",
-              vertex.getPath(), fragment.getPath());
-    return true;
-  }
-}
@@ -1,19 +1,24 @@
 #pragma once
 
+#include "LinkedProgram.h"
 #include "Shader.h"
 
 #include "GLHandles.h"
 
 #include <glad/glad.h>
+#include <glm/glm.hpp>
 
 #include <string>
-#include <optional>
+#include <vector>
 
 
-class ShaderProgram {
+class ShaderProgram : public LinkedProgram {
 
 public:
 	ShaderProgram(const std::string& vertexPath, const std::string& fragmentPath);
+
+	// A variant: both stages are compiled with a #define for every name, see Shader
+	ShaderProgram(const std::string& vertexPath, const std::string& fragmentPath, const std::vector<std::string>& defines);
 	// Because we're using the ShaderProgramHandle to do RAII for the shader for us
 	// and our other types are trivial or provide their own RAII
 	// we don't have to provide any specialized functions here. Rule of zero
@@ -36,6 +41,4 @@ private:
 
 	Shader vertex;
 	Shader fragment;
-
-	bool checkAndLogLinkSuccess() const;
 };
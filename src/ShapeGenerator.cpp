@@ -7,6 +7,8 @@
 //======================================================================================================================
 
 // will be called inside Celestial body class.
+// Vertices are shared between neighbouring quads and the triangles come from the index list,
+// so bodies can be drawn with glDrawElements(Instanced).
 CPU_Geometry ShapeGenerator::Sphere(float const radius, int const slices, int const stacks)
 {
     CPU_Geometry geometry{};
@@ -15,71 +17,56 @@ CPU_Geometry ShapeGenerator::Sphere(float const radius, int const slices, int co
     float phi_step = glm::pi<float>() / static_cast<float>(stacks); // latitude
     float theta_step = glm::two_pi<float>() / static_cast<float>(slices); // longitude
 
-    // loop over vertical divisions
-    for (int stack_index = 0; stack_index < stacks; ++stack_index)
+    // one vertex per grid point, the seam and the poles are duplicated so the uvs stay continuous
+    for (int stack_index = 0; stack_index <= stacks; ++stack_index)
     {
         float phi = stack_index * phi_step;
-        float next_phi = (stack_index + 1) * phi_step;
 
-        // loop over horizontal divisions
-        for (int slice_index = 0; slice_index < slices; ++slice_index)
+        for (int slice_index = 0; slice_index <= slices; ++slice_index)
         {
             float theta = slice_index * theta_step;
-            float next_theta = (slice_index + 1) * theta_step;
 
-            // four vertices for a quad - converting spherical coords (theta, phi)
-            // to x,y,z cartesian coords
-            glm::vec3 vertex_1 = glm::vec3(
+            // converting spherical coords (theta, phi) to x,y,z cartesian coords
+            glm::vec3 unit_vertex = glm::vec3(
                 -cos(theta) * sin(phi),     // x
                 -cos(phi),                  // y
                 sin(theta) * sin(phi)       // z
-            ) * radius;                     // scale
-
-            glm::vec3 vertex_2 = glm::vec3(
-                -cos(next_theta) * sin(phi),
-                -cos(phi),
-                sin(next_theta) * sin(phi)
-            ) * radius;
-
-            glm::vec3 vertex_3 = glm::vec3(
-                -cos(next_theta) * sin(next_phi),
-                -cos(next_phi),
-                sin(next_theta) * sin(next_phi)
-            ) * radius;
-
-            glm::vec3 vertex_4 = glm::vec3(
-                -cos(theta) * sin(next_phi),
-                -cos(next_phi),
-                sin(theta) * sin(next_phi)
-            ) * radius;
-
-            // two triangles per quad on the sphere surface
-            // winding order 1-2-3
-            geometry.positions.push_back(vertex_1);
-            geometry.positions.push_back(vertex_2);
-            geometry.positions.push_back(vertex_3);
+            );
 
-            // winding order 1-3-4
-            geometry.positions.push_back(vertex_1);
-            geometry.positions.push_back(vertex_3);
-            geometry.positions.push_back(vertex_4);
-
-            // normals
-            geometry.normals.push_back(vertex_1);
-            geometry.normals.push_back(vertex_2);
-            geometry.normals.push_back(vertex_3);
-            geometry.normals.push_back(vertex_1);
-            geometry.normals.push_back(vertex_3);
-            geometry.normals.push_back(vertex_4);
+            geometry.positions.push_back(unit_vertex * radius);
+            geometry.normals.push_back(unit_vertex);
 
             // Texture coordinates using spherical projection (u = theta/2pi, v = phi/pi)
-            geometry.uvs.push_back(glm::vec2(theta / glm::two_pi<float>(), phi / glm::pi<float>()));
-            geometry.uvs.push_back(glm::vec2(next_theta / glm::two_pi<float>(), phi / glm::pi<float>()));
-            geometry.uvs.push_back(glm::vec2(next_theta / glm::two_pi<float>(), next_phi / glm::pi<float>()));
+            geometry.uvs.push_back(glm::vec2(
+                static_cast<float>(slice_index) / static_cast<float>(slices),
+                static_cast<float>(stack_index) / static_cast<float>(stacks)
+            ));
+        }
+    }
 
-            geometry.uvs.push_back(glm::vec2(theta / glm::two_pi<float>(), phi / glm::pi<float>()));
-            geometry.uvs.push_back(glm::vec2(next_theta / glm::two_pi<float>(), next_phi / glm::pi<float>()));
-            geometry.uvs.push_back(glm::vec2(theta / glm::two_pi<float>(), next_phi / glm::pi<float>()));
+    // two triangles per quad on the sphere surface
+    auto const vertex_index = [slices](int const stack_index, int const slice_index)->Index {
+        return static_cast<Index>(stack_index * (slices + 1) + slice_index);
+    };
+
+    for (int stack_index = 0; stack_index < stacks; ++stack_index)
+    {
+        for (int slice_index = 0; slice_index < slices; ++slice_index)
+        {
+            Index const vertex_1 = vertex_index(stack_index, slice_index);
+            Index const vertex_2 = vertex_index(stack_index, slice_index + 1);
+            Index const vertex_3 = vertex_index(stack_index + 1, slice_index + 1);
+            Index const vertex_4 = vertex_index(stack_index + 1, slice_index);
+
+            // winding order 1-2-3
+            geometry.indices.push_back(vertex_1);
+            geometry.indices.push_back(vertex_2);
+            geometry.indices.push_back(vertex_3);
+
+            // winding order 1-3-4
+            geometry.indices.push_back(vertex_1);
+            geometry.indices.push_back(vertex_3);
+            geometry.indices.push_back(vertex_4);
         }
     }
 
@@ -0,0 +1,205 @@
+#include "Skybox.hpp"
+
+#include "AssetPath.h"
+#include "CacheFile.hpp"
+#include "Log.h"
+
+#include <stb/stb_image.h>
+
+#include <glm/gtc/constants.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace
+{
+    // changes whenever the source image is replaced
+    uint64_t SourceKey(std::filesystem::path const & source)
+    {
+        auto const size = static_cast<uint64_t>(std::filesystem::file_size(source));
+        auto const time = static_cast<uint64_t>(std::filesystem::last_write_time(source).time_since_epoch().count());
+        return size ^ (time * 0x9E3779B97F4A7C15ull);
+    }
+
+    CacheFile::Header CacheHeader(uint64_t const sourceKey, int const faceSize)
+    {
+        return {{'S', 'K', 'Y', 'C'}, 2, sourceKey, {static_cast<uint32_t>(faceSize), Skybox::FaceCount, 0, 0}};
+    }
+
+    // Direction through the centre of texel (s, t) of a face, s and t in [-1, 1]. These are the
+    // sc/tc selection rules of the GL spec run backwards, with row 0 at t = -1.
+    glm::vec3 FaceDirection(int const face, float const s, float const t)
+    {
+        switch (face)
+        {
+        case 0: return glm::vec3(1.0f, -t, -s);
+        case 1: return glm::vec3(-1.0f, -t, s);
+        case 2: return glm::vec3(s, 1.0f, t);
+        case 3: return glm::vec3(s, -1.0f, -t);
+        case 4: return glm::vec3(s, -t, 1.0f);
+        default: return glm::vec3(-s, -t, -1.0f);
+        }
+    }
+}
+
+//======================================================================================================================
+
+Skybox::Skybox(std::string const & imagePath, std::filesystem::path const & cacheDirectory, int const faceSize)
+{
+    auto const start = std::chrono::steady_clock::now();
+
+    auto const path = AssetPath::Instance();
+    mShader = std::make_unique<ShaderProgram>(path->Get("shaders/sky.vert"), path->Get("shaders/sky.frag"));
+    mSkyUniform = mShader->uniform("sky");
+    mIntensityUniform = mShader->uniform("intensity");
+    mShader->use();
+    mShader->set(mSkyUniform, 0);
+    glUseProgram(0);
+
+    std::string const fullPath = path->Get(imagePath);
+    std::filesystem::path const cachePath = cacheDirectory /
+        (std::filesystem::path(imagePath).stem().string() + "_" + std::to_string(faceSize) + ".cube");
+    CacheFile::Header const header = CacheHeader(SourceKey(fullPath), faceSize);
+    mStats.faceSize = faceSize;
+
+    // unmapped again before a stale file is overwritten
+    {
+        CacheFile const cache(cachePath, header, static_cast<size_t>(FaceCount) * faceSize * faceSize * 3, "sky");
+        mStats.fromCache = cache.IsValid();
+        if (mStats.fromCache)
+        {
+            Upload(cache.Payload());
+        }
+    }
+    if (mStats.fromCache == false)
+    {
+        Faces const faces = Convert(fullPath, faceSize);
+        CacheFile::Write(cachePath, header, {{faces.data(), faces.size()}}, "sky");
+        Upload(faces.data());
+    }
+
+    std::chrono::duration<float, std::milli> const elapsed = std::chrono::steady_clock::now() - start;
+    mStats.loadMs = elapsed.count();
+    Log::info("Sky cubemap {}x{} {} in {:.0f} ms", faceSize, faceSize, mStats.fromCache ? "read from cache" : "converted", mStats.loadMs);
+}
+
+//======================================================================================================================
+
+void Skybox::Draw(FrameGraph const & frameGraph) const
+{
+    // the triangle is on the far plane, so only pixels the clear left at 1 pass
+    glEnable(GL_DEPTH_TEST);
+    glDepthFunc(GL_EQUAL);
+    glDepthMask(GL_FALSE);
+
+    mShader->use();
+    mShader->set(mIntensityUniform, mIntensity);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, mCubemap);
+    frameGraph.DrawFullscreen();
+
+    // leave the defaults the rest of the frame expects
+    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+    glDepthFunc(GL_LESS);
+    glDepthMask(GL_TRUE);
+}
+
+//======================================================================================================================
+
+// Bilinear lookups into the equirectangular image, wrapping around in longitude. The mapping matches the uvs of
+// ShapeGenerator's spheres (seen from the inside), so the sky is oriented like the star sphere it replaces.
+Skybox::Faces Skybox::Convert(std::string const & imagePath, int const faceSize)
+{
+    // row 0 is the top of the image, which is +y
+    stbi_set_flip_vertically_on_load(false);
+    glm::ivec2 size {};
+    int components = 0;
+    unsigned char * data = stbi_load(imagePath.c_str(), &size.x, &size.y, &components, 3);
+    if (data == nullptr)
+    {
+        throw std::runtime_error("Failed to read texture data from file!");
+    }
+
+    auto const texel = [&](int const x, int const y)->glm::vec3 {
+        int const wrapped_x = (x % size.x + size.x) % size.x;
+        int const clamped_y = std::clamp(y, 0, size.y - 1);
+        unsigned char const * pixel = data + (static_cast<size_t>(clamped_y) * size.x + wrapped_x) * 3;
+        return glm::vec3(pixel[0], pixel[1], pixel[2]);
+    };
+
+    Faces faces(static_cast<size_t>(FaceCount) * faceSize * faceSize * 3);
+    uint8_t * output = faces.data();
+    for (int face = 0; face < FaceCount; ++face)
+    {
+        for (int row = 0; row < faceSize; ++row)
+        {
+            float const t = 2.0f * (static_cast<float>(row) + 0.5f) / static_cast<float>(faceSize) - 1.0f;
+            for (int column = 0; column < faceSize; ++column)
+            {
+                float const s = 2.0f * (static_cast<float>(column) + 0.5f) / static_cast<float>(faceSize) - 1.0f;
+                glm::vec3 const direction = glm::normalize(FaceDirection(face, s, t));
+
+                // inverse of ShapeGenerator: x = -cos(theta) sin(phi), y = -cos(phi), z = sin(theta) sin(phi)
+                float theta = std::atan2(direction.z, -direction.x);
+                if (theta < 0.0f)
+                {
+                    theta += glm::two_pi<float>();
+                }
+                float const phi = std::acos(std::clamp(-direction.y, -1.0f, 1.0f));
+                float const u = theta / glm::two_pi<float>();
+                float const v = phi / glm::pi<float>();
+
+                glm::vec2 const position = glm::vec2(u * static_cast<float>(size.x), (1.0f - v) * static_cast<float>(size.y)) - 0.5f;
+                glm::ivec2 const base = glm::ivec2(glm::floor(position));
+                glm::vec2 const weight = position - glm::vec2(base);
+                glm::vec3 const color = glm::mix(
+                    glm::mix(texel(base.x, base.y), texel(base.x + 1, base.y), weight.x),
+                    glm::mix(texel(base.x, base.y + 1), texel(base.x + 1, base.y + 1), weight.x),
+                    weight.y
+                );
+
+                for (int channel = 0; channel < 3; ++channel)
+                {
+                    *output++ = static_cast<uint8_t>(std::lround(std::clamp(color[channel], 0.0f, 255.0f)));
+                }
+            }
+        }
+    }
+
+    stbi_image_free(data);
+    return faces;
+}
+
+//======================================================================================================================
+
+void Skybox::Upload(uint8_t const * faces)
+{
+    size_t const faceBytes = static_cast<size_t>(mStats.faceSize) * mStats.faceSize * 3;
+    mStats.levels = static_cast<int>(std::floor(std::log2(static_cast<float>(mStats.faceSize)))) + 1;
+
+    // no seams between faces when filtering near the edges and across mip levels
+    glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, mCubemap);
+    for (int face = 0; face < FaceCount; ++face)
+    {
+        glTexImage2D(
+            GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0, GL_RGB8, mStats.faceSize, mStats.faceSize, 0,
+            GL_RGB, GL_UNSIGNED_BYTE, faces + faceBytes * face
+        );
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    // only level 0 is cached, the rest of the chain is cheaper to build on the GPU than to read
+    glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+}
+
+//======================================================================================================================
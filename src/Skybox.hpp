@@ -0,0 +1,70 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// The star background as a mipmapped cubemap. The equirectangular source is
+// converted on the CPU the first time and the faces are cached on disk, keyed
+// by the source's size and modification time, so later runs only read them
+// back. The sky is drawn after the opaque bodies as one full-screen triangle
+// on the far plane with an equal depth test, so every pixel a body covers is
+// rejected before shading.
+//------------------------------------------------------------------------------
+
+#include "FrameGraph.hpp"
+#include "GLHandles.h"
+#include "ShaderProgram.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+class Skybox
+{
+public:
+
+    struct Stats
+    {
+        int faceSize = 0;
+        int levels = 0;
+        bool fromCache = false;
+        float loadMs = 0.0f;    // conversion or cache read, and the upload
+    };
+
+    // imagePath is the equirectangular image, cacheDirectory is created when it does not exist
+    explicit Skybox(std::string const & imagePath, std::filesystem::path const & cacheDirectory, int faceSize = DefaultFaceSize);
+
+    // Inside a frame graph pass. Needs the FrameData block bound and a depth buffer cleared to the
+    // far plane, leaves depth testing on.
+    void Draw(FrameGraph const & frameGraph) const;
+
+    [[nodiscard]]
+    float & GetIntensity() { return mIntensity; }
+
+    [[nodiscard]]
+    Stats const & GetStats() const { return mStats; }
+
+    // a quarter of the 4096 wide layers the star sphere was limited to, which keeps the same texel density
+    static constexpr int DefaultFaceSize = 1024;
+    static constexpr int FaceCount = 6;
+
+private:
+
+    // tightly packed RGB8, faces in GL_TEXTURE_CUBE_MAP_POSITIVE_X + face order
+    using Faces = std::vector<uint8_t>;
+
+    [[nodiscard]]
+    static Faces Convert(std::string const & imagePath, int faceSize);
+
+    // faces as laid out in Faces, from a conversion or straight from the cache mapping
+    void Upload(uint8_t const * faces);
+
+    std::unique_ptr<ShaderProgram> mShader {};
+    ShaderProgram::Uniform mSkyUniform {};
+    ShaderProgram::Uniform mIntensityUniform {};
+    TextureHandle mCubemap {};
+    float mIntensity = 1.0f;
+    Stats mStats {};
+};
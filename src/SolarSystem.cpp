@@ -1,16 +1,23 @@
 #include "SolarSystem.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
 #include <filesystem>
+#include <fstream>
 
 #include "GLDebug.h"
 #include "Log.h"
 
+#include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <backends/imgui_impl_glfw.h>
 #include <backends/imgui_impl_opengl3.h>
 #include <imgui.h>
 
 #include "ShapeGenerator.hpp"
+#include "UniformBlocks.hpp"
 
 // Step 1: Create a sphere with positions, indices, and uv values
 // Step 2: Create the solar system with sun, earth and moon
@@ -19,12 +26,27 @@
 //======================================================================================================================
 
 SolarSystem::SolarSystem()
+    : SolarSystem(Options{})
+{
+}
+
+//======================================================================================================================
+
+SolarSystem::SolarSystem(Options const & options)
+    : mOptions(options)
 {
     mPath = AssetPath::Instance();
     mTime = Time::Instance();
 
-    glfwWindowHint(GLFW_SAMPLES, 32);
-    mWindow = std::make_unique<Window>(800, 800, "Solar system");
+    // the scene is multisampled offscreen, the window only receives the tonemapped image
+    if (mOptions.headless)
+    {
+        mWindow = std::make_unique<Window>(mOptions.size.x, mOptions.size.y, "Solar system", mOptions.contextApi);
+    }
+    else
+    {
+        mWindow = std::make_unique<Window>(mOptions.size.x, mOptions.size.y, "Solar system");
+    }
 
     // Standard ImGui/GLFW middleware
     IMGUI_CHECKVERSION();
@@ -35,9 +57,6 @@ SolarSystem::SolarSystem()
 
 
     glEnable(GL_MULTISAMPLE);
-    int samples = 0;
-    glGetIntegerv(GL_SAMPLES, &samples);
-    Log::info("MSAA Samples: {0}", samples);
 
     GLDebug::enable(); // ON Submission you may comments this out to avoid unnecessary prints to the console
 
@@ -49,16 +68,70 @@ SolarSystem::SolarSystem()
     mWindow->setCallbacks(mInputManager);
 
     // phong shader
-    phong_shader = std::make_unique<ShaderProgram>(
-        mPath->Get("shaders/test.vert"),
-        mPath->Get("shaders/phong.frag")
-    );
+    phong_shader = AddBodyShader("shaders/test.vert", "shaders/phong.frag");
 
     // provided basic shader
-    mBasicShader = std::make_unique<ShaderProgram>(
-        mPath->Get("shaders/test.vert"),
-        mPath->Get("shaders/test.frag")
-    );
+    mBasicShader = AddBodyShader("shaders/test.vert", "shaders/test.frag");
+
+    // attribute-less sphere shaders
+    mProceduralPhongShader = AddBodyShader("shaders/sphere_procedural.vert", "shaders/phong.frag");
+    mProceduralBasicShader = AddBodyShader("shaders/sphere_procedural.vert", "shaders/test.frag");
+
+    // coverage from the texture, composited by Transparency
+    mTransparentShader = AddBodyShader("shaders/test.vert", "shaders/transparent.frag");
+    mProceduralTransparentShader = AddBodyShader("shaders/sphere_procedural.vert", "shaders/transparent.frag");
+
+    mEmptyVertexArray = std::make_unique<VertexArray>();
+
+    mUploadRing = std::make_unique<RingBuffer>(64 * 1024);
+    mInstanceBuffer = std::make_unique<InstanceBuffer>(*mUploadRing);
+    mMaterials = std::make_unique<MaterialLibrary>();
+    mMeshes = std::make_unique<MeshBuffer>();
+
+    mOcclusionCuller = std::make_unique<OcclusionCuller>();
+    mFrameGraph = std::make_unique<FrameGraph>();
+    if (mOptions.headless)
+    {
+        // the same passes, the backbuffer is just a framebuffer object. Resolution scaling is for
+        // holding a frame rate, server side frames are rendered at full quality.
+        mOffscreen = std::make_unique<OffscreenTarget>(mOptions.size);
+        mFrameGraph->SetBackbuffer(mOffscreen->GetFramebuffer());
+        mDynamicResolution.GetSettings().enabled = false;
+    }
+
+    // a fixed step makes clips independent of how long frames take to render and encode, headless
+    // captures run faster than real time
+    if (mOptions.capture.empty() == false || mOptions.capturePipe.empty() == false)
+    {
+        int framebuffer_width, framebuffer_height;
+        glfwGetFramebufferSize(mWindow->getGLFWwindow(), &framebuffer_width, &framebuffer_height);
+        bool const pipe = mOptions.capturePipe.empty() == false;
+        mFrameCapture = std::make_unique<FrameCapture>(
+            pipe ? FrameCapture::Sink::Pipe : FrameCapture::Sink::PngSequence,
+            pipe ? mOptions.capturePipe : mOptions.capture,
+            glm::ivec2(framebuffer_width, framebuffer_height)
+        );
+        mTime->SetFixedStep(1.0f / static_cast<float>(mOptions.captureFps));
+        mDynamicResolution.GetSettings().enabled = false;
+    }
+
+    // nothing is watching a headless run or a capture in real time, so they render as fast as they can
+    auto & pacing_settings = mFramePacer.GetSettings();
+    pacing_settings.mode = mOptions.pacing;
+    pacing_settings.maxFps = mOptions.maxFps;
+    if (mOptions.headless || mFrameCapture != nullptr)
+    {
+        pacing_settings.mode = FramePacer::Mode::Uncapped;
+    }
+    mFramePacer.SetRefreshRate(mWindow->getRefreshRate());
+    mWindow->setSwapInterval(mFramePacer.GetSwapInterval());
+    mAntiAliasing = std::make_unique<AntiAliasing>();
+    mAntiAliasing->GetSettings().mode = mOptions.antiAliasing;
+    mAntiAliasing->GetSettings().msaaSamples = mOptions.msaaSamples;
+    mPostProcess = std::make_unique<PostProcess>();
+    mSkybox = std::make_unique<Skybox>("textures/8k_stars_milky_way.jpg", AssetPath::CacheDirectory());
+    mTransparency = std::make_unique<Transparency>();
+    mAtmosphere = std::make_unique<Atmosphere>(Atmosphere::Parameters{}, AssetPath::CacheDirectory());
 
     TurnTableCamera::Params cam_params;
     cam_params.defaultDistance = 20.0f;
@@ -68,6 +141,47 @@ SolarSystem::SolarSystem()
     mTurnTableCamera = std::make_unique<TurnTableCamera>(cam_params);
 
     PrepareSphereGeometry();
+
+    // pack all the body textures, bodies then only differ by the layer in their instance data
+    for (auto const & body_ptr : m_bodies)
+    {
+        body_ptr->material = mMaterials->Add(body_ptr->get_surface());
+    }
+    mMaterials->Upload();
+
+    CreatePhongVariants();
+
+    SetupGpuDrivenPath();
+
+    // the body count is fixed from here on, so one frame's uploads have a known upper bound
+    GLsizeiptr frame_upload_size = static_cast<GLsizeiptr>(sizeof(UniformBlocks::FrameData)) + RingBuffer::bindAlignment();
+    frame_upload_size += static_cast<GLsizeiptr>(sizeof(UniformBlocks::EclipseData)) + RingBuffer::bindAlignment();
+    frame_upload_size += InstanceBuffer::frameSize(m_bodies.size());
+    if (mGpuRenderer != nullptr)
+    {
+        frame_upload_size += mGpuRenderer->FrameUploadSize();
+    }
+    mUploadRing->reserve(frame_upload_size);
+}
+
+//======================================================================================================================
+
+SolarSystem::BodyShader::BodyShader(
+    uint32_t const id,
+    std::string const & vertexPath,
+    std::string const & fragmentPath,
+    std::vector<std::string> const & defines
+)
+    : id(id)
+    , program(vertexPath, fragmentPath, defines)
+{
+    textureSampler = program.uniform("texture_sampler");
+    sphereSlices = program.uniform("sphere_slices", false);
+    sphereStacks = program.uniform("sphere_stacks", false);
+
+    // every body samples from unit 0, so this never changes after startup
+    program.use();
+    program.set(textureSampler, 0);
 }
 
 //======================================================================================================================
@@ -84,41 +198,203 @@ SolarSystem::~SolarSystem()
 
 void SolarSystem::Run()
 {
-    while (mWindow->shouldClose() == false)
+    // headless runs and posters stop after a number of frames, a window runs until it is closed
+    bool const poster = mOptions.posterSize.x > 0 && mOptions.posterSize.y > 0;
+    bool const bounded = mOptions.headless || poster;
+    int frame = 0;
+    while (mWindow->shouldClose() == false && (bounded == false || frame < mOptions.frames))
     {
         glfwPollEvents(); // Propagate events to the callback class
 
         mTime->Update();
         Update(mTime->DeltaTimeSec());
 
-        glEnable(GL_FRAMEBUFFER_SRGB); // Expect Colour to be encoded in sRGB standard (as opposed to RGB)
-
-        // https://www.viewsonic.com/library/creative-work/srgb-vs-adobe-rgb-which-one-to-use/
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT); // Clear render screen (all zero) and depth (all max depth)
-
         // macOS window size is different than framebuffer. 
         // I think this still works with linux/windows, but if there are window sizing issues
         // they probably arise here.
         int framebuffer_width, framebuffer_height;
         glfwGetFramebufferSize(mWindow->getGLFWwindow(), &framebuffer_width, &framebuffer_height);
-        glViewport(0, 0, framebuffer_width, framebuffer_height);
-
-        Render();
 
-        glDisable(GL_FRAMEBUFFER_SRGB); // disable sRGB for things like imgui (if used)
+        mRenderScale = mDynamicResolution.GetScale();
+        mFrameGraph->Reset();
+        AddFramePasses();
+        mFrameGraph->Compile(glm::ivec2(framebuffer_width, framebuffer_height));
 
-        // Starting the new ImGui frame
-        ImGui_ImplOpenGL3_NewFrame();
-        ImGui_ImplGlfw_NewFrame();
-        ImGui::NewFrame();
+        mUploadRing->beginFrame();
+        mFrameGraph->Execute();
+        mUploadRing->endFrame();
 
-        UI();
+        mPostProcess->ApplyBudget(*mFrameGraph);
+        mAntiAliasing->UpdateStats(*mFrameGraph);
+        mDynamicResolution.Update(mFrameGraph->GetTotalTime());
 
-        ImGui::Render(); // Render the ImGui window
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData()); // Some middleware thing
+        if (mFrameCapture != nullptr)
+        {
+            GLuint const backbuffer = mOffscreen != nullptr ? mOffscreen->GetFramebuffer() : 0;
+            mFrameCapture->Capture(backbuffer, glm::ivec2(framebuffer_width, framebuffer_height));
+        }
 
+        mFramePacer.Wait();
         mWindow->swapBuffers(); // Swap the buffers while displaying the previous
+        ++frame;
+    }
+
+    if (mFrameCapture != nullptr)
+    {
+        mFrameCapture->Finish();
+    }
+
+    if (mOptions.profileOutput.empty() == false)
+    {
+        auto & profiler = mFrameGraph->GetProfiler();
+        profiler.Flush();
+        if (std::filesystem::path(mOptions.profileOutput).extension() == ".json")
+        {
+            profiler.ExportJson(mOptions.profileOutput);
+        }
+        else
+        {
+            profiler.ExportCsv(mOptions.profileOutput);
+        }
+    }
+
+    if (poster)
+    {
+        RenderPoster(mOptions.posterSize, mOptions.posterTile, mOptions.output);
+    }
+    else if (mOffscreen != nullptr && mOptions.output.empty() == false)
+    {
+        mOffscreen->WritePpm(mOptions.output);
+    }
+}
+
+//======================================================================================================================
+
+// Every pass of the frame and what it reads and writes. The frame graph works out the order, skips passes whose
+// output is never used and binds the targets, so a new effect only needs its own AddPass here.
+void SolarSystem::AddFramePasses()
+{
+    // HDR scene, multisampled and then resolved when MSAA is on
+    int const scene_samples = mAntiAliasing->GetSceneSamples();
+    FrameGraph::TextureDesc color_desc {};
+    color_desc.format = PostProcess::HdrFormat;
+    color_desc.scale = mRenderScale;
+    color_desc.samples = scene_samples;
+    FrameGraph::TextureDesc depth_desc {};
+    depth_desc.format = GL_DEPTH_COMPONENT24;
+    depth_desc.scale = mRenderScale;
+    depth_desc.samples = scene_samples;
+
+    FrameGraph::ResourceId scene_color {};
+    FrameGraph::ResourceId scene_depth {};
+    FrameGraph::PassOptions scene_options {};
+    scene_options.clear = GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT;
+    mFrameGraph->AddPass(
+        "scene",
+        [&](FrameGraph::Builder & builder)->void {
+            scene_color = builder.Create("scene_color", color_desc);
+            builder.Write(scene_color);
+            scene_depth = builder.Create("scene_depth", depth_desc);
+            builder.Write(scene_depth);
+        },
+        [this, scene_color](FrameGraph const & frameGraph)->void {
+            mSceneSize = frameGraph.GetSize(scene_color);
+            Render();
+        },
+        scene_options
+    );
+
+    // after the bodies, so the depth test rejects every pixel they cover
+    mFrameGraph->AddPass(
+        "sky",
+        [&](FrameGraph::Builder & builder)->void {
+            builder.Write(scene_color);
+            builder.Write(scene_depth);
+        },
+        [this](FrameGraph const & frameGraph)->void {
+            mSkybox->Draw(frameGraph);
+        }
+    );
+
+    // scattering shells around the bodies that have an atmosphere, over the sky and the ground
+    if (mAtmosphere->GetSettings().enabled)
+    {
+        mFrameGraph->AddPass(
+            "atmosphere",
+            [&](FrameGraph::Builder & builder)->void {
+                builder.Write(scene_color);
+                builder.Write(scene_depth);
+            },
+            [this](FrameGraph const &)->void {
+                for (auto const & body_ptr : m_bodies)
+                {
+                    if (body_ptr->has_atmosphere)
+                    {
+                        mAtmosphere->Draw(body_ptr->get_world_bounds(), *mMeshes, body_ptr->get_mesh());
+                    }
+                }
+            }
+        );
+    }
+
+    FrameGraph::ResourceId hdr_color = scene_color;
+    if (scene_samples > 1)
+    {
+        mFrameGraph->AddPass(
+            "resolve",
+            [&](FrameGraph::Builder & builder)->void {
+                FrameGraph::TextureDesc resolved_desc {};
+                resolved_desc.format = PostProcess::HdrFormat;
+                resolved_desc.scale = mRenderScale;
+                hdr_color = builder.Create("hdr_color", resolved_desc);
+                builder.Read(scene_color);
+                builder.Write(hdr_color);
+            },
+            [scene_color](FrameGraph const & frameGraph)->void {
+                frameGraph.Blit(scene_color, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+            }
+        );
+    }
+
+    // clouds and other transparent bodies over the resolved scene, at a fraction of its resolution
+    mTransparency->AddPasses(*mFrameGraph, hdr_color, scene_depth, depth_desc, [this]()->void {
+        RenderTransparent();
+    });
+
+    // FXAA or the TAA resolve on the single sample scene, nothing for MSAA
+    FrameGraph::ResourceId antialiased_color {};
+    mAntiAliasing->AddPasses(*mFrameGraph, hdr_color, scene_depth, mRenderScale, antialiased_color);
+
+    // bloom, exposure and tonemapping into the sRGB backbuffer, upscaled when the scene is rendered smaller
+    // poster tiles keep the exposure the previous frames adapted to, so all of them match
+    float const exposure_time = mRenderingPoster ? 0.0f : mTime->DeltaTimeSec();
+    mPostProcess->AddPasses(*mFrameGraph, antialiased_color, FrameGraph::Backbuffer, mRenderScale, exposure_time);
+
+    // nobody would see the UI of a headless frame, and clips are captured without it
+    if (mOptions.headless || mFrameCapture != nullptr || mRenderingPoster)
+    {
+        return;
     }
+
+    // without sRGB for imgui
+    mFrameGraph->AddPass(
+        "ui",
+        [](FrameGraph::Builder & builder)->void {
+            builder.Write(FrameGraph::Backbuffer);
+        },
+        [this](FrameGraph const &)->void {
+            // Starting the new ImGui frame
+            ImGui_ImplOpenGL3_NewFrame();
+            ImGui_ImplGlfw_NewFrame();
+            ImGui::NewFrame();
+
+            UI();
+            ProfilerUI();
+
+            ImGui::Render(); // Render the ImGui window
+            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData()); // Some middleware thing
+        }
+    );
 }
 
 //======================================================================================================================
@@ -198,78 +474,856 @@ void SolarSystem::Render()
     glDepthFunc(GL_LESS);
 
     // projection and view matrices for this frame
-    float const aspect_ratio = static_cast<float>(mWindow->getWidth()) / static_cast<float>(mWindow->getHeight());
-    glm::mat4 const projection_matrix = glm::perspective(mFovY, aspect_ratio, mZNear, mZFar);
+    float aspect_ratio = static_cast<float>(mWindow->getWidth()) / static_cast<float>(mWindow->getHeight());
+    if (mRenderingPoster)
+    {
+        aspect_ratio = mPosterAspectRatio;
+    }
     glm::mat4 const view_matrix = mTurnTableCamera->ViewMatrix();
+    glm::mat4 const projection_matrix = mAntiAliasing->Jitter(
+        mProjectionCrop * glm::perspective(mFovY, aspect_ratio, mZNear, mZFar), view_matrix, mSceneSize
+    );
     glm::vec3 const camera_position = mTurnTableCamera->Position();
 
-    glActiveTexture(GL_TEXTURE0);
+    mFrustum.SetViewProjection(projection_matrix * view_matrix);
 
-    // render loop for each celestial body
+    // world space bounds, for culling and for finding which bodies can eclipse each other
+    mBodyBounds.clear();
     for (const auto& body_ptr : m_bodies)
     {
-        CelestialBody* body = body_ptr.get();
+        mBodyBounds.emplace_back(body_ptr->get_world_bounds());
+    }
+    UpdateEclipses();
+
+    if (mRenderPath == RenderPath::GpuDriven && mGpuRenderer != nullptr)
+    {
+        UploadFrameUniforms(view_matrix, projection_matrix, camera_position);
+        RenderGpuDriven(projection_matrix, camera_position);
+        return;
+    }
 
-        // star background
-        if (body == m_stars)
+    // test every body against the view frustum up front, only the visible ones get drawn
+    mFrustum.Clear();
+    for (auto const & bounds : mBodyBounds)
+    {
+        mFrustum.AddSphere(bounds);
+    }
+    mFrustum.Cull();
+
+    mOcclusionCuller->BeginFrame(mOcclusionMode, view_matrix, projection_matrix, mZNear, m_bodies.size());
+
+    UploadFrameUniforms(view_matrix, projection_matrix, camera_position);
+
+    // the software test only needs the occluders' bounds, so it is done before anything is queued
+    if (mOcclusionMode == OcclusionCuller::Mode::SoftwareHiZ)
+    {
+        for (size_t body_index = 0; body_index < m_bodies.size(); ++body_index)
         {
-            glDisable(GL_CULL_FACE); // disabled back face culling so that texture appears on the inside of this sphere
-            glDepthMask(GL_FALSE);
+            if (m_bodies[body_index]->is_occluder && IsInFrustum(body_index))
+            {
+                mOcclusionCuller->AddOccluder(mBodyBounds[body_index]);
+            }
+        }
+        mOcclusionCuller->BuildHierarchy();
+    }
 
-            mBasicShader->use(); 
-            glUniform1i(glGetUniformLocation(*mBasicShader, "texture_sampler"), 0);
-            glUniformMatrix4fv(glGetUniformLocation(*mBasicShader, "model_matrix"), 1, GL_FALSE, glm::value_ptr(m_stars->get_model_matrix()));
-            glUniformMatrix4fv(glGetUniformLocation(*mBasicShader, "view_matrix"), 1, GL_FALSE, glm::value_ptr(view_matrix));
-            glUniformMatrix4fv(glGetUniformLocation(*mBasicShader, "projection_matrix"), 1, GL_FALSE, glm::value_ptr(projection_matrix));
+    // Turn every visible body into a draw item. With occlusion culling on the large occluders get
+    // their own pass so they are drawn before anything is tested against them.
+    bool const occlusion_culling = mOcclusionMode != OcclusionCuller::Mode::Off;
+    mRenderQueue.Clear();
+    for (size_t body_index = 0; body_index < m_bodies.size(); ++body_index)
+    {
+        if (IsInFrustum(body_index) == false)
+        {
+            continue;
+        }
 
-            m_stars->get_texture().bind();
-            m_stars->get_geometry().bind();
-            glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(m_stars->get_geometry().vertex_count()));
-            m_stars->get_texture().unbind();
+        CelestialBody & body = *m_bodies[body_index];
 
-            glDepthMask(GL_TRUE);
-            glEnable(GL_CULL_FACE); // re-enabled for other spheres
+        auto pass = RenderQueue::Pass::Opaque;
+        if (body.is_transparent)
+        {
+            if (mTransparency->GetSettings().enabled == false)
+            {
+                continue;
+            }
+            pass = RenderQueue::Pass::Transparent;
         }
-        // render the sun - needed separate conditional because of back face culling
-        else if (body == m_sun)
+        else if (occlusion_culling && body.is_occluder)
+        {
+            pass = RenderQueue::Pass::Occluders;
+        }
+
+        if (pass == RenderQueue::Pass::Opaque &&
+            mOcclusionMode == OcclusionCuller::Mode::SoftwareHiZ &&
+            mOcclusionCuller->IsOccluded(mBodyBounds[body_index]))
+        {
+            continue;
+        }
+
+        GLuint const mesh = mSphereRenderMode == SphereRenderMode::Procedural ? 0 : body.get_mesh();
+        float const depth = glm::distance(camera_position, mBodyBounds[body_index].center) / mZFar;
+
+        mRenderQueue.Push(
+            RenderQueue::MakeKey(pass, SelectShader(body).id, body.material.array, mesh, depth),
+            static_cast<uint32_t>(body_index)
+        );
+    }
+    mRenderQueue.Sort();
+
+    BuildBatches();
+
+    // transparent bodies sort last, their batches wait for the transparent pass
+    auto const & items = mRenderQueue.Items();
+    mFirstTransparentBatch = 0;
+    while (mFirstTransparentBatch < mBatches.size() &&
+        RenderQueue::PassOf(items[mBatches[mFirstTransparentBatch].firstItem].key) != RenderQueue::Pass::Transparent)
+    {
+        mFirstTransparentBatch += 1;
+    }
+
+    mRenderStats = {};
+    if (mBatches.empty() == false)
+    {
+        mInstanceBuffer->uploadData(mInstances);
+    }
+    GpuProfiler::Scope const draw_scope(mFrameGraph->GetProfiler(), "draw");
+    SubmitRenderQueue(0, mFirstTransparentBatch);
+}
+
+//======================================================================================================================
+
+// Splits the sorted queue into runs that can share one instanced draw and writes their
+// instance data in queue order, so every batch is a contiguous range of the instance buffer.
+void SolarSystem::BuildBatches()
+{
+    mBatches.clear();
+    mInstances.clear();
+
+    bool const procedural = mSphereRenderMode == SphereRenderMode::Procedural;
+    bool const hardware_occlusion = mOcclusionMode == OcclusionCuller::Mode::HardwareQueries;
+
+    auto const & items = mRenderQueue.Items();
+    for (size_t item_index = 0; item_index < items.size(); ++item_index)
+    {
+        auto const & item = items[item_index];
+        CelestialBody const & body = *m_bodies[item.bodyIndex];
+
+        // the queue key only drops the depth bits, everything above them must match
+        constexpr uint64_t stateMask = ~((uint64_t{1} << RenderQueue::DepthBits) - 1);
+        bool joins_batch = mBatches.empty() == false;
+        if (joins_batch)
         {
-            // sun emits light (i.e. not phong shaded)
-            mBasicShader->use();
-            glUniform1i(glGetUniformLocation(*mBasicShader, "texture_sampler"), 0);
-            glUniformMatrix4fv(glGetUniformLocation(*mBasicShader, "model_matrix"), 1, GL_FALSE, glm::value_ptr(body->get_model_matrix()));
-            glUniformMatrix4fv(glGetUniformLocation(*mBasicShader, "view_matrix"), 1, GL_FALSE, glm::value_ptr(view_matrix));
-            glUniformMatrix4fv(glGetUniformLocation(*mBasicShader, "projection_matrix"), 1, GL_FALSE, glm::value_ptr(projection_matrix));
+            auto const & previous = items[item_index - 1];
+            joins_batch = (previous.key & stateMask) == (item.key & stateMask);
+
+            // each queried body sits in its own conditional render
+            joins_batch = joins_batch &&
+                (hardware_occlusion == false || RenderQueue::PassOf(item.key) != RenderQueue::Pass::Opaque);
 
-            body->get_texture().bind();
-            body->get_geometry().bind();
-            glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(body->get_geometry().vertex_count()));
-            body->get_texture().unbind();
+            // the procedural vertex count depends on the tessellation
+            joins_batch = joins_batch &&
+                (procedural == false || ProceduralTessellation(*m_bodies[previous.bodyIndex]) == ProceduralTessellation(body));
+        }
+
+        if (joins_batch)
+        {
+            mBatches.back().count += 1;
         }
-        // earth and moon - phong shaded
         else
         {
-            phong_shader->use();
-            glUniform1i(glGetUniformLocation(*phong_shader, "texture_sampler"), 0);
-            glUniformMatrix4fv(glGetUniformLocation(*phong_shader, "view_matrix"), 1, GL_FALSE, glm::value_ptr(view_matrix));
-            glUniformMatrix4fv(glGetUniformLocation(*phong_shader, "projection_matrix"), 1, GL_FALSE, glm::value_ptr(projection_matrix));
-            glUniform3fv(glGetUniformLocation(*phong_shader, "camera_position"), 1, glm::value_ptr(camera_position));
-            glUniformMatrix4fv(glGetUniformLocation(*phong_shader, "model_matrix"), 1, GL_FALSE, glm::value_ptr(body->get_model_matrix()));
+            mBatches.emplace_back(DrawBatch{item_index, 1});
+        }
 
-            body->get_texture().bind();
-            body->get_geometry().bind();
-            glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(body->get_geometry().vertex_count()));
-            body->get_texture().unbind();
+        // the procedural shader builds a unit sphere, the vertex buffers already have the radius in them
+        glm::mat4 model_matrix = body.get_model_matrix();
+        if (procedural)
+        {
+            model_matrix = model_matrix * glm::scale(glm::mat4(1.0f), glm::vec3(body.get_radius()));
         }
+
+        InstanceBuffer::InstanceData instance{};
+        instance.modelMatrix = model_matrix;
+        instance.material = glm::uvec4(
+            body.material.array,
+            body.material.layer,
+            mEclipses.GetMask(item.bodyIndex),
+            glm::floatBitsToUint(body.emission)
+        );
+        mInstances.emplace_back(instance);
     }
 }
 
 //======================================================================================================================
 
+// Draws the batches in queue order, only touching GL state that differs from the previous batch.
+// Program, texture array and VAO changes therefore scale with the number of distinct
+// texture arrays, and draw calls with the number of distinct program/material/mesh combinations.
+void SolarSystem::SubmitRenderQueue(size_t const firstBatch, size_t const endBatch)
+{
+    if (firstBatch >= endBatch)
+    {
+        return;
+    }
+
+    bool const hardware_occlusion = mOcclusionMode == OcclusionCuller::Mode::HardwareQueries;
+    bool const procedural = mSphereRenderMode == SphereRenderMode::Procedural;
+
+    bool first_batch = true;
+    auto current_pass = RenderQueue::Pass::Opaque;
+    BodyShader * current_shader = nullptr;
+    bool texture_bound = false;
+    uint32_t current_texture = 0;
+    GLuint current_vertex_array = 0;
+
+    glActiveTexture(GL_TEXTURE0);
+
+    auto const & items = mRenderQueue.Items();
+    for (size_t batch_index = firstBatch; batch_index < endBatch; ++batch_index)
+    {
+        DrawBatch const & batch = mBatches[batch_index];
+        auto const & item = items[batch.firstItem];
+        CelestialBody & body = *m_bodies[item.bodyIndex];
+
+        auto const pass = RenderQueue::PassOf(item.key);
+        if (first_batch || pass != current_pass)
+        {
+            glEnable(GL_CULL_FACE);
+            glDepthMask(pass == RenderQueue::Pass::Transparent ? GL_FALSE : GL_TRUE);
+            current_pass = pass;
+            first_batch = false;
+        }
+
+        // bounding box queries use their own program and VAO, so forget what was bound
+        bool queried = false;
+        if (hardware_occlusion && pass == RenderQueue::Pass::Opaque)
+        {
+            queried = mOcclusionCuller->IssueQuery(item.bodyIndex, mBodyBounds[item.bodyIndex]);
+            if (queried)
+            {
+                current_shader = nullptr;
+                current_vertex_array = 0;
+                mOcclusionCuller->BeginConditionalRender(item.bodyIndex);
+            }
+        }
+
+        BodyShader * const shader = mBodyShaders[RenderQueue::ProgramOf(item.key)];
+        if (shader != current_shader)
+        {
+            shader->program.use();
+            current_shader = shader;
+            mRenderStats.programChanges += 1;
+        }
+
+        uint32_t const texture = RenderQueue::MaterialOf(item.key);
+        if (texture_bound == false || texture != current_texture)
+        {
+            mMaterials->Bind(texture);
+            current_texture = texture;
+            texture_bound = true;
+            mRenderStats.textureChanges += 1;
+        }
+
+        // every mesh lives in the mesh buffer's VAO, so this only changes with the sphere mode
+        GLuint const vertex_array = procedural ? mEmptyVertexArray->getID() : mMeshes->VertexArrayID();
+        if (vertex_array != current_vertex_array)
+        {
+            if (procedural)
+            {
+                mEmptyVertexArray->bind();
+            }
+            else
+            {
+                mMeshes->Bind();
+            }
+            current_vertex_array = vertex_array;
+            mRenderStats.vertexArrayChanges += 1;
+        }
+
+        // the instanced attributes live in the VAO, point them at this batch's range
+        mInstanceBuffer->bindAttributes(static_cast<GLsizei>(batch.firstItem));
+
+        auto const instance_count = static_cast<GLsizei>(batch.count);
+        if (procedural)
+        {
+            glm::ivec2 const tessellation = ProceduralTessellation(body);
+            shader->program.set(shader->sphereSlices, tessellation.x);
+            shader->program.set(shader->sphereStacks, tessellation.y);
+            glDrawArraysInstanced(GL_TRIANGLES, 0, static_cast<GLsizei>(tessellation.x * tessellation.y * 6), instance_count);
+        }
+        else
+        {
+            MeshBuffer::Mesh const & mesh = mMeshes->Get(body.get_mesh());
+            glDrawElementsInstancedBaseVertex(
+                GL_TRIANGLES,
+                mesh.indexCount,
+                GL_UNSIGNED_INT,
+                mesh.IndexOffset(),
+                instance_count,
+                mesh.baseVertex
+            );
+        }
+        mRenderStats.draws += 1;
+        mRenderStats.instances += instance_count;
+
+        if (queried)
+        {
+            mOcclusionCuller->EndConditionalRender();
+        }
+    }
+
+    // leave the defaults the rest of the frame expects
+    glEnable(GL_CULL_FACE);
+    glDepthMask(GL_TRUE);
+}
+
+//======================================================================================================================
+
+// Render() already culled, sorted and uploaded the transparent bodies with everything else, only the draws were held
+// back until the weighted blended targets are bound.
+void SolarSystem::RenderTransparent()
+{
+    glEnable(GL_CULL_FACE);
+    glCullFace(GL_BACK);
+
+    if (mRenderPath == RenderPath::GpuDriven && mGpuRenderer != nullptr)
+    {
+        glActiveTexture(GL_TEXTURE0);
+        auto const & ranges = mGpuRenderer->GetRanges();
+        for (size_t range_index = 0; range_index < ranges.size(); ++range_index)
+        {
+            uint64_t const key = ranges[range_index].stateKey;
+            if (RenderQueue::PassOf(key) != RenderQueue::Pass::Transparent)
+            {
+                continue;
+            }
+            mBodyShaders[RenderQueue::ProgramOf(key)]->program.use();
+            mMaterials->Bind(RenderQueue::MaterialOf(key));
+            mGpuRenderer->Draw(range_index);
+            mRenderStats.draws += 1;
+        }
+        return;
+    }
+
+    SubmitRenderQueue(mFirstTransparentBatch, mBatches.size());
+}
+
+//======================================================================================================================
+
+// Creates the GPU-driven renderer and its programs when the context is new enough, and makes
+// it the default.
+void SolarSystem::SetupGpuDrivenPath()
+{
+    if (GpuDrivenRenderer::IsSupported() == false)
+    {
+        Log::info("OpenGL 4.3 is not available, using the CPU instanced path");
+        return;
+    }
+
+    mGpuBasicShader = AddBodyShader("shaders/body_gpu.vert", "shaders/test.frag");
+    mGpuPhongShader = AddBodyShader("shaders/body_gpu.vert", "shaders/phong.frag");
+    mGpuTransparentShader = AddBodyShader("shaders/body_gpu.vert", "shaders/transparent.frag");
+
+    mGpuRenderer = std::make_unique<GpuDrivenRenderer>(*mMeshes);
+    UpdateGpuDrivenBodies();
+
+    mRenderPath = RenderPath::GpuDriven;
+}
+
+//======================================================================================================================
+
+// Describes the bodies to the GPU-driven renderer. Bodies are static after PrepareSphereGeometry,
+// so this only has to run again when mesh ranges move (defragmentation).
+void SolarSystem::UpdateGpuDrivenBodies()
+{
+    if (mGpuRenderer == nullptr)
+    {
+        return;
+    }
+
+    // Occlusion culling is CPU side only, so there is no occluder pass here. Every mesh shares
+    // the mesh buffer's VAO, so the mesh is not part of the range key.
+    std::vector<GpuDrivenRenderer::BodyDesc> bodies{};
+    for (auto const & body_ptr : m_bodies)
+    {
+        CelestialBody const & body = *body_ptr;
+        // same order as SelectShader, there are no variants for transparent or emissive bodies
+        auto pass = RenderQueue::Pass::Opaque;
+        BodyShader const * shader = mGpuPhongShader.get();
+        if (body.is_transparent)
+        {
+            pass = RenderQueue::Pass::Transparent;
+            shader = mGpuTransparentShader.get();
+        }
+        else if (body.is_emissive)
+        {
+            shader = mGpuBasicShader.get();
+        }
+        else if (body.material.features != 0)
+        {
+            shader = mPhongVariants.at(body.material.features).gpu.get();
+        }
+
+        bodies.emplace_back(GpuDrivenRenderer::BodyDesc{
+            RenderQueue::MakeKey(pass, shader->id, body.material.array, 0, 0.0f),
+            mMeshes->Get(body.get_mesh()),
+            body.get_local_bounds(),
+            body.material.layer,
+            body.emission
+        });
+    }
+    mGpuRenderer->SetBodies(bodies);
+}
+
+//======================================================================================================================
+
+// The CPU only copies the transforms and walks the draw ranges, culling and command
+// generation happen in cull_bodies.comp.
+void SolarSystem::RenderGpuDriven(glm::mat4 const & projectionMatrix, glm::vec3 const & cameraPosition)
+{
+    for (size_t body_index = 0; body_index < m_bodies.size(); ++body_index)
+    {
+        mGpuRenderer->SetModelMatrix(body_index, m_bodies[body_index]->get_model_matrix());
+        mGpuRenderer->SetEclipseMask(body_index, mEclipses.GetMask(body_index));
+    }
+
+    // the pixel radius test is against the scene target, which is smaller than the backbuffer under dynamic
+    // resolution. The backbuffer is a poster tile while one is rendered.
+    glm::ivec2 const backbuffer_size = mFrameGraph->GetSize(FrameGraph::Backbuffer);
+    int const target_height = static_cast<int>(std::round(static_cast<float>(backbuffer_size.y) * mRenderScale));
+    {
+        GpuProfiler::Scope const cull_scope(mFrameGraph->GetProfiler(), "cull");
+        mGpuRenderer->Cull(*mUploadRing, mFrustum, mFrustumCullingEnabled, mMinPixelRadius, projectionMatrix, cameraPosition, target_height);
+    }
+    GpuProfiler::Scope const draw_scope(mFrameGraph->GetProfiler(), "draw");
+
+    mRenderStats = {};
+    glActiveTexture(GL_TEXTURE0);
+    glEnable(GL_CULL_FACE);
+    glDepthMask(GL_TRUE);
+
+    auto const & ranges = mGpuRenderer->GetRanges();
+    for (size_t range_index = 0; range_index < ranges.size(); ++range_index)
+    {
+        uint64_t const key = ranges[range_index].stateKey;
+        if (RenderQueue::PassOf(key) == RenderQueue::Pass::Transparent)
+        {
+            continue; // drawn by RenderTransparent
+        }
+
+        mBodyShaders[RenderQueue::ProgramOf(key)]->program.use();
+        mMaterials->Bind(RenderQueue::MaterialOf(key));
+        mGpuRenderer->Draw(range_index);
+        mRenderStats.draws += 1;
+    }
+}
+
+//======================================================================================================================
+
+bool SolarSystem::IsInFrustum(size_t const bodyIndex) const
+{
+    return mFrustumCullingEnabled == false || mFrustum.IsVisible(bodyIndex);
+}
+
+//======================================================================================================================
+
+// Compiles a body program and registers it in mBodyShaders, its index there is the id render
+// queue keys refer to it by.
+std::unique_ptr<SolarSystem::BodyShader> SolarSystem::AddBodyShader(
+    std::string const & vertexPath,
+    std::string const & fragmentPath,
+    std::vector<std::string> const & defines
+)
+{
+    auto shader = std::make_unique<BodyShader>(
+        static_cast<uint32_t>(mBodyShaders.size()),
+        mPath->Get(vertexPath),
+        mPath->Get(fragmentPath),
+        defines
+    );
+    mBodyShaders.emplace_back(shader.get());
+    return shader;
+}
+
+//======================================================================================================================
+
+// The phong programs reading the optional maps of every feature set in use. Emissive and
+// transparent bodies ignore material features, so they need no variants.
+void SolarSystem::CreatePhongVariants()
+{
+    for (auto const & body_ptr : m_bodies)
+    {
+        uint32_t const features = body_ptr->material.features;
+        if (features == 0 || body_ptr->is_emissive || body_ptr->is_transparent || mPhongVariants.count(features) > 0)
+        {
+            continue;
+        }
+
+        std::vector<std::string> defines{};
+        if ((features & MaterialLibrary::SpecularMask) != 0)
+        {
+            defines.emplace_back("SPECULAR_MASK");
+        }
+        if ((features & MaterialLibrary::NightLights) != 0)
+        {
+            defines.emplace_back("NIGHT_LIGHTS");
+        }
+
+        PhongVariants & variants = mPhongVariants[features];
+        variants.instanced = AddBodyShader("shaders/test.vert", "shaders/phong.frag", defines);
+        variants.procedural = AddBodyShader("shaders/sphere_procedural.vert", "shaders/phong.frag", defines);
+        if (GpuDrivenRenderer::IsSupported())
+        {
+            variants.gpu = AddBodyShader("shaders/body_gpu.vert", "shaders/phong.frag", defines);
+        }
+        Log::info("Phong variant for material features {:#x}", features);
+    }
+}
+
+//======================================================================================================================
+
+// Emissive bodies (the sun) are not lit, transparent ones get their own shader, everything else is phong shaded,
+// with the variant for its material features if it has any
+SolarSystem::BodyShader & SolarSystem::SelectShader(CelestialBody const & body) const
+{
+    bool const procedural = mSphereRenderMode == SphereRenderMode::Procedural;
+    if (body.is_transparent)
+    {
+        return procedural ? *mProceduralTransparentShader : *mTransparentShader;
+    }
+    if (body.is_emissive)
+    {
+        return procedural ? *mProceduralBasicShader : *mBasicShader;
+    }
+    if (body.material.features != 0)
+    {
+        PhongVariants const & variants = mPhongVariants.at(body.material.features);
+        return procedural ? *variants.procedural : *variants.instanced;
+    }
+    return procedural ? *mProceduralPhongShader : *phong_shader;
+}
+
+//======================================================================================================================
+
+// Writes the camera block once, every program reads it from the same binding point.
+void SolarSystem::UploadFrameUniforms(
+    glm::mat4 const & viewMatrix,
+    glm::mat4 const & projectionMatrix,
+    glm::vec3 const & cameraPosition
+)
+{
+    UniformBlocks::FrameData const frame_data{viewMatrix, projectionMatrix, glm::vec4(cameraPosition, 1.0f)};
+    RingBuffer::Allocation const allocation = mUploadRing->upload(&frame_data, sizeof(frame_data), RingBuffer::bindAlignment());
+    glBindBufferRange(GL_UNIFORM_BUFFER, UniformBlocks::FrameDataBinding, mUploadRing->getID(), allocation.offset, allocation.size);
+
+    RingBuffer::Allocation const eclipses = mUploadRing->upload(&mEclipses.GetBlock(), sizeof(UniformBlocks::EclipseData), RingBuffer::bindAlignment());
+    glBindBufferRange(GL_UNIFORM_BUFFER, UniformBlocks::EclipsesBinding, mUploadRing->getID(), eclipses.offset, eclipses.size);
+}
+
+//======================================================================================================================
+
+// Planets and moons shadow each other. The sun is neither lit nor in the way, and cloud layers are lit without eclipses.
+void SolarSystem::UpdateEclipses()
+{
+    BoundingSphere const sun_bounds = m_sun->get_world_bounds();
+    if (mEclipsesEnabled == false)
+    {
+        mEclipses.Clear(sun_bounds, m_bodies.size());
+        return;
+    }
+
+    std::vector<EclipseShadows::Body> bodies{};
+    for (size_t body_index = 0; body_index < m_bodies.size(); ++body_index)
+    {
+        CelestialBody const & body = *m_bodies[body_index];
+        bool const lit = body.is_emissive == false && body.is_transparent == false;
+        bodies.emplace_back(EclipseShadows::Body{mBodyBounds[body_index], lit, lit});
+    }
+    mEclipses.Update(sun_bounds, bodies);
+}
+
+//======================================================================================================================
+
+// Slices and stacks the procedural path draws the body with. Tessellation is only a uniform
+// of the draw, so it can be overridden here without touching any buffer.
+glm::ivec2 SolarSystem::ProceduralTessellation(CelestialBody const & body) const
+{
+    if (mProceduralTessellation > 0)
+    {
+        return glm::ivec2(mProceduralTessellation);
+    }
+    return glm::ivec2(body.get_slices(), body.get_stacks());
+}
+
+//======================================================================================================================
+
 // I'm keeping this to monitor performance
 void SolarSystem::UI()
 {
     ImGui::Begin("FPS Counter");
-    ImGui::Text("FPS: %f", 1.0f / mTime->DeltaTimeSec());
+    ImGui::Text("FPS: %.1f (CPU frame %.2f ms), GPU frame: %.2f ms",
+        1.0f / mTime->DeltaTimeSec(), mTime->DeltaTimeSec() * 1000.0f, mFrameGraph->GetProfiler().GetStats().frameMs);
+    ImGui::Checkbox("GPU profiler", &mShowProfiler);
+
+    if (ImGui::CollapsingHeader("Frame pacing"))
+    {
+        auto & pacing_settings = mFramePacer.GetSettings();
+        auto const & pacing_stats = mFramePacer.GetStats();
+        int pacing_mode = static_cast<int>(pacing_settings.mode);
+        if (ImGui::Combo("Pacing", &pacing_mode, FramePacer::ModeNames))
+        {
+            pacing_settings.mode = static_cast<FramePacer::Mode>(pacing_mode);
+            mWindow->setSwapInterval(mFramePacer.GetSwapInterval());
+        }
+        if (pacing_settings.mode == FramePacer::Mode::Limited)
+        {
+            ImGui::SliderFloat("Max FPS", &pacing_settings.maxFps, 24.0f, 360.0f);
+            ImGui::SliderFloat("Spin (ms)", &pacing_settings.spinMs, 0.0f, 4.0f);
+            ImGui::Text("Slept %.2f ms, spun %.2f ms, oversleep %.3f ms",
+                pacing_stats.sleepMs, pacing_stats.spinMs, pacing_stats.oversleepMs);
+        }
+        ImGui::Text("Target: %.2f ms, frame: %.2f ms, jitter: %.3f ms, missed: %llu of %llu",
+            pacing_stats.targetMs, pacing_stats.frameMs, pacing_stats.jitterMs,
+            static_cast<unsigned long long>(pacing_stats.missed), static_cast<unsigned long long>(pacing_stats.frames));
+        auto const & pacing_history = mFramePacer.GetHistory();
+        ImGui::PlotLines("Frame times", pacing_history.data(), FramePacer::HistoryLength,
+            mFramePacer.GetHistoryOffset(), nullptr, 0.0f, 2.0f * std::max(pacing_stats.frameMs, 1.0f), ImVec2(0.0f, 60.0f));
+    }
+
+    if (mGpuRenderer != nullptr)
+    {
+        int render_path = static_cast<int>(mRenderPath);
+        ImGui::Combo("Render path", &render_path, "CPU instanced\0GPU driven\0");
+        mRenderPath = static_cast<RenderPath>(render_path);
+    }
+    else
+    {
+        ImGui::Text("GPU-driven path needs OpenGL 4.3");
+    }
+
+    auto const & ring_stats = mUploadRing->getStats();
+    ImGui::Text("Uploads: %.1f KB/frame (%s), fence waits: %d",
+        static_cast<float>(ring_stats.bytesUsed) / 1024.0f, mUploadRing->isPersistent() ? "persistent" : "orphaned", ring_stats.fenceWaits);
+
+    auto const & graph_stats = mFrameGraph->GetStats();
+    ImGui::Text("Frame graph: %d passes, %d culled, %d targets in %d textures (%.1f of %.1f MB)",
+        graph_stats.passes, graph_stats.culledPasses, graph_stats.transientTextures, graph_stats.physicalTextures,
+        static_cast<float>(graph_stats.physicalBytes) / (1024.0f * 1024.0f),
+        static_cast<float>(graph_stats.transientBytes) / (1024.0f * 1024.0f));
+    if (ImGui::TreeNode("Pass order"))
+    {
+        for (auto const & pass_name : mFrameGraph->GetExecutionOrder())
+        {
+            ImGui::BulletText("%s", pass_name.c_str());
+        }
+        ImGui::TreePop();
+    }
+
+    auto const mesh_stats = mMeshes->GetStats();
+    ImGui::Text("Meshes: %d, vertices %u/%u, indices %u/%u, free ranges: %d",
+        mesh_stats.meshes, mesh_stats.verticesUsed, mesh_stats.vertexCapacity,
+        mesh_stats.indicesUsed, mesh_stats.indexCapacity, static_cast<int>(mesh_stats.freeRanges));
+    if (ImGui::Button("Defragment meshes"))
+    {
+        // between frames, the copies are ordered before the next frame's draws
+        mMeshes->Defragment();
+        UpdateGpuDrivenBodies();
+    }
+
+    if (ImGui::CollapsingHeader("HDR"))
+    {
+        auto & post_settings = mPostProcess->GetSettings();
+        auto const & post_stats = mPostProcess->GetStats();
+        ImGui::Text("Post GPU time: %.3f ms (budget %.2f ms), bloom: %d levels at %.2fx",
+            post_stats.gpuMs, post_settings.budgetMs, post_stats.bloomLevels, post_stats.bloomScale);
+        ImGui::Text("Scene: %.3f ms, sky: %.3f ms",
+            mFrameGraph->GetPassTime("scene"), mFrameGraph->GetPassTime("sky"));
+
+        auto & aa_settings = mAntiAliasing->GetSettings();
+        auto const & aa_stats = mAntiAliasing->GetStats();
+        int aa_mode = static_cast<int>(aa_settings.mode);
+        ImGui::Combo("Anti-aliasing", &aa_mode, AntiAliasing::ModeNames);
+        aa_settings.mode = static_cast<AntiAliasing::Mode>(aa_mode);
+        if (aa_settings.mode == AntiAliasing::Mode::Msaa)
+        {
+            ImGui::SliderInt("MSAA samples", &aa_settings.msaaSamples, 2, aa_stats.maxSamples);
+        }
+        else if (aa_settings.mode == AntiAliasing::Mode::Fxaa)
+        {
+            ImGui::SliderFloat("FXAA edge threshold", &aa_settings.fxaaEdgeThreshold, 0.063f, 0.333f);
+            ImGui::SliderFloat("FXAA subpixel", &aa_settings.fxaaSubpixel, 0.0f, 1.0f);
+        }
+        else if (aa_settings.mode == AntiAliasing::Mode::Taa)
+        {
+            ImGui::SliderFloat("TAA feedback", &aa_settings.taaFeedback, 0.5f, 0.98f);
+        }
+        ImGui::Text("AA passes: %.3f ms, MSAA: %dx", aa_stats.passMs, mAntiAliasing->GetSceneSamples());
+        // the whole frame, so the MSAA cost in the scene passes is included
+        ImGui::Text("GPU frame by mode (ms): off %.2f, MSAA %.2f, FXAA %.2f, TAA %.2f",
+            aa_stats.frameMs[0], aa_stats.frameMs[1], aa_stats.frameMs[2], aa_stats.frameMs[3]);
+
+        auto & resolution_settings = mDynamicResolution.GetSettings();
+        ImGui::Text("GPU frame: %.3f ms, render scale: %.2f", mFrameGraph->GetTotalTime(), mRenderScale);
+        ImGui::Checkbox("Dynamic resolution", &resolution_settings.enabled);
+        if (resolution_settings.enabled)
+        {
+            ImGui::SliderFloat("Target frame time (ms)", &resolution_settings.targetFrameMs, 4.0f, 50.0f);
+            ImGui::SliderFloat("Min render scale", &resolution_settings.minScale, 0.25f, 1.0f);
+            ImGui::SliderFloat("Upscale sharpness", &post_settings.sharpness, 0.0f, 1.0f);
+        }
+
+        ImGui::SliderFloat("Post budget (ms)", &post_settings.budgetMs, 0.1f, 5.0f);
+        ImGui::SliderFloat("Bloom strength", &post_settings.bloomStrength, 0.0f, 0.3f);
+        ImGui::SliderFloat("Bloom threshold", &post_settings.bloomThreshold, 0.0f, 4.0f);
+        ImGui::Checkbox("Auto exposure", &post_settings.autoExposure);
+        if (post_settings.autoExposure)
+        {
+            ImGui::SliderFloat("Exposure key", &post_settings.exposureKey, 0.02f, 1.0f);
+            ImGui::SliderFloat("Adaptation speed", &post_settings.adaptationSpeed, 0.1f, 10.0f);
+        }
+        else
+        {
+            ImGui::SliderFloat("Exposure", &post_settings.manualExposure, 0.05f, 8.0f);
+        }
+        ImGui::SliderFloat("Sky intensity", &mSkybox->GetIntensity(), 0.0f, 4.0f);
+
+        auto & atmosphere_settings = mAtmosphere->GetSettings();
+        auto const & atmosphere_stats = mAtmosphere->GetStats();
+        ImGui::Checkbox("Atmospheres", &atmosphere_settings.enabled);
+        if (atmosphere_settings.enabled)
+        {
+            ImGui::Text("Atmosphere: %.3f ms, tables %s in %.1f ms",
+                mFrameGraph->GetPassTime("atmosphere"),
+                atmosphere_stats.fromCache ? "mapped from cache" : "built", atmosphere_stats.loadMs);
+            ImGui::SliderFloat("Sun illuminance", &atmosphere_settings.sunIlluminance, 0.0f, 10.0f);
+        }
+
+        auto & transparency_settings = mTransparency->GetSettings();
+        ImGui::Checkbox("Transparent bodies", &transparency_settings.enabled);
+        if (transparency_settings.enabled)
+        {
+            ImGui::Text("Transparency: %.3f ms, composite: %.3f ms",
+                mFrameGraph->GetPassTime("transparent"), mFrameGraph->GetPassTime("transparent_composite"));
+            ImGui::SliderFloat("Transparency resolution", &transparency_settings.resolutionScale, 0.25f, 1.0f);
+        }
+    }
+
+    ImGui::Checkbox("Frustum culling", &mFrustumCullingEnabled);
+
+    ImGui::Checkbox("Eclipse shadows", &mEclipsesEnabled);
+    if (mEclipsesEnabled)
+    {
+        auto const & eclipse_stats = mEclipses.GetStats();
+        ImGui::Text("Occluders: %d, shadowed bodies: %d, dropped: %d",
+            eclipse_stats.occluders, eclipse_stats.shadowedBodies, eclipse_stats.dropped);
+    }
+
+    if (mRenderPath == RenderPath::GpuDriven && mGpuRenderer != nullptr)
+    {
+        auto const & gpu_stats = mGpuRenderer->GetStats();
+        ImGui::Text("Bodies: %d, draw ranges: %d, multi-draws: %d", gpu_stats.bodies, gpu_stats.ranges, gpu_stats.multiDraws);
+        ImGui::SliderFloat("Min pixel radius", &mMinPixelRadius, 0.0f, 8.0f);
+        ImGui::End();
+        return;
+    }
+
+    auto const & cull_stats = mFrustum.GetStats();
+    ImGui::Text("Draws: %d, instances: %d, program/texture/VAO changes: %d/%d/%d",
+        mRenderStats.draws, mRenderStats.instances, mRenderStats.programChanges, mRenderStats.textureChanges, mRenderStats.vertexArrayChanges);
+    ImGui::Text("Bodies visible: %d, culled: %d", cull_stats.visible, cull_stats.culled);
+
+    int occlusion_mode = static_cast<int>(mOcclusionMode);
+    ImGui::Combo("Occlusion culling", &occlusion_mode, "Off\0Hardware queries\0Software Hi-Z\0");
+    mOcclusionMode = static_cast<OcclusionCuller::Mode>(occlusion_mode);
+    if (mOcclusionMode != OcclusionCuller::Mode::Off)
+    {
+        auto const & occlusion_stats = mOcclusionCuller->GetStats();
+        ImGui::Text("Occlusion tested: %d, occluded: %d", occlusion_stats.tested, occlusion_stats.occluded);
+    }
+
+    int sphere_mode = static_cast<int>(mSphereRenderMode);
+    ImGui::RadioButton("Vertex buffers", &sphere_mode, static_cast<int>(SphereRenderMode::VertexBuffers));
+    ImGui::SameLine();
+    ImGui::RadioButton("Procedural", &sphere_mode, static_cast<int>(SphereRenderMode::Procedural));
+    mSphereRenderMode = static_cast<SphereRenderMode>(sphere_mode);
+
+    if (mSphereRenderMode == SphereRenderMode::Procedural)
+    {
+        ImGui::SliderInt("Tessellation (0 = per body)", &mProceduralTessellation, 0, 256);
+    }
+    ImGui::End();
+}
+
+//======================================================================================================================
+
+// Scopes are indented by nesting depth. The graph shows the history of one scope, picked by clicking its row.
+void SolarSystem::ProfilerUI()
+{
+    if (mShowProfiler == false)
+    {
+        return;
+    }
+
+    GpuProfiler & profiler = mFrameGraph->GetProfiler();
+    auto const & stats = profiler.GetStats();
+    ImGui::Begin("GPU profiler", &mShowProfiler);
+    ImGui::Text("GPU frame: %.3f ms, %d timestamps, %llu frames resolved, %llu dropped",
+        stats.frameMs, stats.queries,
+        static_cast<unsigned long long>(stats.resolvedFrames), static_cast<unsigned long long>(stats.droppedFrames));
+
+    auto const scopes = profiler.GetScopes();
+    mProfilerGraphScope = std::clamp(mProfilerGraphScope, 0, std::max(static_cast<int>(scopes.size()) - 1, 0));
+    if (scopes.empty() == false)
+    {
+        auto const & graph_scope = *scopes[mProfilerGraphScope];
+        float const graph_max = std::max(*std::max_element(graph_scope.history.begin(), graph_scope.history.end()), 0.1f);
+        ImGui::PlotLines(
+            "##history",
+            graph_scope.history.data(),
+            GpuProfiler::HistoryLength,
+            graph_scope.historyNext,
+            graph_scope.path.c_str(),
+            0.0f,
+            graph_max * 1.2f,
+            ImVec2(0.0f, 80.0f)
+        );
+    }
+
+    if (ImGui::BeginTable("scopes", 3, ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingStretchProp))
+    {
+        ImGui::TableSetupColumn("Scope");
+        ImGui::TableSetupColumn("ms");
+        ImGui::TableSetupColumn("last");
+        ImGui::TableHeadersRow();
+        for (int scope_index = 0; scope_index < static_cast<int>(scopes.size()); ++scope_index)
+        {
+            auto const & scope = *scopes[scope_index];
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            std::string const label = std::string(static_cast<size_t>(scope.depth) * 2, ' ') + scope.name;
+            ImGui::PushID(scope_index);
+            if (ImGui::Selectable(label.c_str(), scope_index == mProfilerGraphScope, ImGuiSelectableFlags_SpanAllColumns))
+            {
+                mProfilerGraphScope = scope_index;
+            }
+            ImGui::PopID();
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", scope.ms);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", scope.lastMs);
+        }
+        ImGui::EndTable();
+    }
+
+    if (ImGui::Button("Export CSV"))
+    {
+        profiler.ExportCsv("gpu_profile.csv");
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Export JSON"))
+    {
+        profiler.ExportJson("gpu_profile.json");
+    }
     ImGui::End();
 }
 
@@ -286,19 +1340,6 @@ void SolarSystem::UI()
 // ShapeGenerator::Sphere and the methods in CelestialBody.cpp/hpp
 void SolarSystem::PrepareSphereGeometry()
 {
-    // STARS
-    auto stars = std::make_unique<CelestialBody>();
-    stars->initialize_geometry(1.0f, 40, 40);
-    stars->set_texture("textures/8k_stars_milky_way.jpg");
-    stars->scale = 100.0f;
-    stars->axis_rotation_speed = 0.0f;
-    stars->orbit_rotation_speed = 0.0f;
-    stars->upload_to_gpu();
-
-    m_stars = stars.get();
-    m_bodies.push_back(std::move(stars));
-
-
     // SUN
     auto sun = std::make_unique<CelestialBody>();
     sun->initialize_geometry(1.0f, 40, 40);
@@ -306,7 +1347,10 @@ void SolarSystem::PrepareSphereGeometry()
     sun->scale = 1.0f;
     sun->axis_rotation_speed = 0.4f;
     sun->orbit_rotation_speed = 0.0f;
-    sun->upload_to_gpu();
+    sun->is_occluder = true;
+    sun->is_emissive = true; // sun emits light (i.e. not phong shaded)
+    sun->emission = 8.0f;    // far above white, so it blooms
+    sun->upload_to_gpu(*mMeshes);
 
     m_sun = sun.get();
     m_bodies.push_back(std::move(sun));
@@ -314,7 +1358,11 @@ void SolarSystem::PrepareSphereGeometry()
     // EARTH
     auto earth = std::make_unique<CelestialBody>();
     earth->initialize_geometry(1.0f, 40, 40);
-    earth->set_texture("textures/8k_earth_daymap.jpg");
+    earth->set_surface(MaterialLibrary::Surface{
+        "textures/2k_earth_daymap.jpg",
+        "textures/EarthSpec.png",
+        "textures/2k_earth_nightmap.jpg"
+    });
     earth->scale = 0.45f;
     earth->axis_tilt = glm::radians(23.4f);
     earth->orbit_tilt = glm::radians(15.0f);
@@ -322,23 +1370,26 @@ void SolarSystem::PrepareSphereGeometry()
     earth->axis_rotation_speed = 5.0f;
     earth->orbit_rotation_speed = 0.5f;
     earth->set_parent(m_sun);
-    earth->upload_to_gpu();
+    earth->is_occluder = true;
+    earth->has_atmosphere = true;
+    earth->upload_to_gpu(*mMeshes);
 
     CelestialBody* earth_ptr = earth.get();
     m_bodies.push_back(std::move(earth));
 
-    // looked into getting the cloud rendering working, but
-    // I don't think I'll have time to get transparency working
-    // EARTH CLOUDS
-    // auto earth_clouds = std::make_unique<CelestialBody>();
-    // earth_clouds->initialize_geometry(1.0f, 40, 40);
-    // earth_clouds->set_texture("textures/8k_earth_clouds.jpg");
-    // earth_clouds->set_parent(earth_ptr);
-    // earth_clouds->scale = 1.01f;
-    // earth_clouds->axis_rotation_speed = 4.8f; 
-    // earth_clouds->orbit_rotation_speed = 0.5f; 
-    // earth_clouds->upload_to_gpu();
-    // m_bodies.push_back(std::move(earth_clouds));
+    // EARTH CLOUDS, spinning a little slower than the surface
+    auto earth_clouds = std::make_unique<CelestialBody>();
+    earth_clouds->initialize_geometry(1.0f, 40, 40);
+    earth_clouds->set_texture("textures/2k_earth_clouds.jpg");
+    earth_clouds->set_parent(earth_ptr);
+    earth_clouds->scale = 1.01f;
+    earth_clouds->axis_rotation_speed = 4.8f;
+    earth_clouds->orbit_rotation_speed = 0.0f;
+    earth_clouds->is_transparent = true;
+    earth_clouds->upload_to_gpu(*mMeshes);
+
+    m_clouds = earth_clouds.get();
+    m_bodies.push_back(std::move(earth_clouds));
 
     // MOON
     auto moon = std::make_unique<CelestialBody>();
@@ -351,12 +1402,115 @@ void SolarSystem::PrepareSphereGeometry()
     moon->axis_rotation_speed = 0.5f;
     moon->orbit_rotation_speed = 2.0f;
     moon->set_parent(earth_ptr);
-    moon->upload_to_gpu();
+    moon->upload_to_gpu(*mMeshes);
 
     m_bodies.push_back(std::move(moon));
 }
 //======================================================================================================================
 
+// A still larger than any framebuffer. The view frustum is cut into a grid of tiles, each rendered through the usual
+// frame graph into an offscreen target with an off-axis crop of the full projection. Tiles are rendered with a guard
+// band around them, so bloom near a border sees the same neighbourhood it would in one big image, and the exposure is
+// frozen at what the frames before adapted to. Every row of tiles goes to the file as soon as it is done, so memory
+// stays at one row.
+bool SolarSystem::RenderPoster(glm::ivec2 const posterSize, int tileSize, std::string const & path)
+{
+    GLint max_texture_size = 0;
+    GLint max_viewport[2] = {0, 0};
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_texture_size);
+    glGetIntegerv(GL_MAX_VIEWPORT_DIMS, max_viewport);
+    int const max_render_size = std::min({max_texture_size, max_viewport[0], max_viewport[1]});
+    tileSize = std::min(tileSize, max_render_size * 4 / 5);
+    int const margin = tileSize / 8;
+    int const render_size = tileSize + 2 * margin;
+    glm::ivec2 const tiles = (posterSize + tileSize - 1) / tileSize;
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    std::string const header = "P6\n" + std::to_string(posterSize.x) + " " + std::to_string(posterSize.y) + "\n255\n";
+    file.write(header.data(), static_cast<std::streamsize>(header.size()));
+
+    Log::info("Poster {}x{} in {}x{} tiles of {} pixels", posterSize.x, posterSize.y, tiles.x, tiles.y, tileSize);
+    auto const start = std::chrono::high_resolution_clock::now();
+
+    OffscreenTarget const target {glm::ivec2(render_size)};
+    mFrameGraph->SetBackbuffer(target.GetFramebuffer());
+    mRenderingPoster = true;
+    mPosterAspectRatio = static_cast<float>(posterSize.x) / static_cast<float>(posterSize.y);
+    mRenderScale = 1.0f;
+
+    // the whole poster once at the poster's aspect ratio, the tiles take their bloom from this frame
+    glm::vec2 const fit = glm::vec2(posterSize) * (static_cast<float>(render_size) / static_cast<float>(std::max(posterSize.x, posterSize.y)));
+    mPostProcess->SetBloomMode(PostProcess::BloomMode::Record, glm::vec4(0.0f, 0.0f, 1.0f, 1.0f));
+    mAntiAliasing->ResetHistory(); // every tile shows a different part of the view, TAA has nothing to reproject
+    mFrameGraph->Reset();
+    AddFramePasses();
+    mFrameGraph->Compile(glm::max(glm::ivec2(fit), glm::ivec2(1)));
+    mUploadRing->beginFrame();
+    mFrameGraph->Execute();
+    mUploadRing->endFrame();
+
+    size_t const poster_row_bytes = static_cast<size_t>(posterSize.x) * 3;
+    std::vector<uint8_t> row_of_tiles(poster_row_bytes * tileSize);
+    for (int tile_y = 0; tile_y < tiles.y && file.good(); ++tile_y)
+    {
+        int const top = tile_y * tileSize;
+        int const rows = std::min(tileSize, posterSize.y - top);
+        for (int tile_x = 0; tile_x < tiles.x; ++tile_x)
+        {
+            int const left = tile_x * tileSize;
+            int const columns = std::min(tileSize, posterSize.x - left);
+
+            // the rendered square with its guard band in normalized device coordinates of the whole poster (y up),
+            // the crop maps it onto the full target
+            glm::vec2 const low = glm::vec2(left - margin, posterSize.y - top - tileSize - margin);
+            glm::vec2 const ndc_low = low / glm::vec2(posterSize) * 2.0f - 1.0f;
+            glm::vec2 const ndc_high = (low + static_cast<float>(render_size)) / glm::vec2(posterSize) * 2.0f - 1.0f;
+            mProjectionCrop = glm::mat4(1.0f);
+            mProjectionCrop[0][0] = 2.0f / (ndc_high.x - ndc_low.x);
+            mProjectionCrop[1][1] = 2.0f / (ndc_high.y - ndc_low.y);
+            mProjectionCrop[3][0] = -(ndc_high.x + ndc_low.x) / (ndc_high.x - ndc_low.x);
+            mProjectionCrop[3][1] = -(ndc_high.y + ndc_low.y) / (ndc_high.y - ndc_low.y);
+            mPostProcess->SetBloomMode(PostProcess::BloomMode::Reuse, glm::vec4(low, glm::vec2(static_cast<float>(render_size))) / glm::vec4(posterSize, posterSize));
+
+            mAntiAliasing->ResetHistory();
+            mFrameGraph->Reset();
+            AddFramePasses();
+            mFrameGraph->Compile(glm::ivec2(render_size));
+            mUploadRing->beginFrame();
+            mFrameGraph->Execute();
+            mUploadRing->endFrame();
+
+            // top row first, the tile starts after the guard band
+            auto const pixels = target.ReadPixels();
+            for (int y = 0; y < rows; ++y)
+            {
+                uint8_t const * source = pixels.data() + (static_cast<size_t>(margin + y) * render_size + margin) * 3;
+                std::memcpy(row_of_tiles.data() + static_cast<size_t>(y) * poster_row_bytes + static_cast<size_t>(left) * 3, source, static_cast<size_t>(columns) * 3);
+            }
+        }
+
+        file.write(reinterpret_cast<char const *>(row_of_tiles.data()), static_cast<std::streamsize>(poster_row_bytes * rows));
+        Log::info("Poster row {}/{} written", tile_y + 1, tiles.y);
+    }
+
+    mProjectionCrop = glm::mat4(1.0f);
+    mPostProcess->SetBloomMode(PostProcess::BloomMode::Own, glm::vec4(0.0f, 0.0f, 1.0f, 1.0f));
+    mAntiAliasing->ResetHistory();
+    mRenderingPoster = false;
+    mFrameGraph->SetBackbuffer(mOffscreen != nullptr ? mOffscreen->GetFramebuffer() : 0);
+
+    if (file.good() == false)
+    {
+        Log::error("Could not write the poster to {}", path);
+        return false;
+    }
+    std::chrono::duration<float> const duration = std::chrono::high_resolution_clock::now() - start;
+    Log::info("Poster written to {} in {:.1f} s", path, duration.count());
+    return true;
+}
+
+//======================================================================================================================
+
 // I'm doing this on MacOS, so the window size differs from the actual framebuffer size.
 // glfwGetFramebufferSize gets correct pixel dimensions for setting the viewport.
 void SolarSystem::OnResize(int width, int height)
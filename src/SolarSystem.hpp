@@ -1,5 +1,6 @@
 #pragma once
 
+#include "AntiAliasing.hpp"
 #include "AssetPath.h"
 #include "Geometry.h"
 #include "InputManager.hpp"
@@ -7,15 +8,80 @@
 #include "Texture.h"
 #include "Time.hpp"
 #include "TurnTableCamera.hpp"
+#include "RingBuffer.h"
+#include "Atmosphere.hpp"
 #include "CelestialBody.hpp"
+#include "DynamicResolution.hpp"
+#include "EclipseShadows.hpp"
+#include "FrameCapture.hpp"
+#include "FrameGraph.hpp"
+#include "FramePacer.hpp"
+#include "Frustum.hpp"
+#include "GpuDrivenRenderer.hpp"
+#include "InstanceBuffer.h"
+#include "MaterialLibrary.hpp"
+#include "MeshBuffer.hpp"
+#include "OcclusionCuller.hpp"
+#include "OffscreenTarget.hpp"
+#include "PostProcess.hpp"
+#include "RenderQueue.hpp"
+#include "Skybox.hpp"
+#include "Transparency.hpp"
+#include <array>
+#include <map>
+#include <string>
 #include <vector>
 
 class SolarSystem
 {
 public:
 
+    // How the sphere vertices reach the vertex shader
+    enum class SphereRenderMode
+    {
+        VertexBuffers,  // ShapeGenerator::Sphere meshes suballocated from the shared MeshBuffer, base-vertex draws
+        Procedural      // no attributes, rebuilt from gl_VertexID in sphere_procedural.vert
+    };
+
+    // Who decides what gets drawn
+    enum class RenderPath
+    {
+        CpuInstanced,   // culling and batching on the CPU, GL 3.3
+        GpuDriven       // culling in a compute shader, indirect multi-draws, GL 4.3+ (see GpuDrivenRenderer)
+    };
+
+    // From the command line, see main.cpp
+    struct Options
+    {
+        glm::ivec2 size {800, 800};
+        // no window on screen, frames go into an OffscreenTarget. glfwInit has to select the null
+        // platform first, see Window::ContextApi.
+        bool headless = false;
+        Window::ContextApi contextApi = Window::ContextApi::EGL;
+        int frames = 1;             // headless only, Run() returns after that many frames
+        std::string output {};      // headless only, the last frame is written there as PPM when set
+        // capture every frame (without the UI) as a PNG sequence into this directory, or pipe raw rgb24 frames
+        // into the stdin of this command, see FrameCapture
+        std::string capture {};
+        std::string capturePipe {};
+        int captureFps = 60;        // while capturing the simulation advances 1 / captureFps seconds per frame
+        // above zero, Run() renders frames (headless or not) and then one still of this size in tiles of
+        // posterTile pixels into output as PPM, see RenderPoster
+        glm::ivec2 posterSize {0, 0};
+        int posterTile = 2048;
+        AntiAliasing::Mode antiAliasing = AntiAliasing::Mode::Msaa;
+        int msaaSamples = 8;
+        // the GPU profile of the last frames is exported there when Run() returns, CSV or JSON by the extension
+        std::string profileOutput {};
+        // windows only, headless runs and captures never wait
+        FramePacer::Mode pacing = FramePacer::Mode::Vsync;
+        float maxFps = 120.0f;      // of FramePacer::Mode::Limited
+    };
+
     explicit SolarSystem();
 
+    explicit SolarSystem(Options const & options);
+
     ~SolarSystem();
 
     void Run();
@@ -24,25 +90,156 @@ private:
 
     void Update(float deltaTime);
 
+    void AddFramePasses();
+
     void Render();
 
     void UI();
 
+    // Per scope GPU times of the frame graph's profiler, with graphs and export
+    void ProfilerUI();
+
+    // A body program and the handles of the uniforms it needs. Camera data comes from the
+    // FrameData block and per body data from the instance attributes.
+    struct BodyShader
+    {
+        // both stages compiled with these #defines
+        explicit BodyShader(
+            uint32_t id,
+            std::string const & vertexPath,
+            std::string const & fragmentPath,
+            std::vector<std::string> const & defines
+        );
+
+        uint32_t id;    // index into mBodyShaders, stored in render queue keys
+        ShaderProgram program;
+
+        ShaderProgram::Uniform textureSampler{};
+        ShaderProgram::Uniform sphereSlices{};  // procedural programs only
+        ShaderProgram::Uniform sphereStacks{};
+    };
+
+    // A run of consecutive queue items drawn with one instanced call
+    struct DrawBatch
+    {
+        size_t firstItem = 0;
+        size_t count = 0;
+    };
+
+    void UploadFrameUniforms(glm::mat4 const & viewMatrix, glm::mat4 const & projectionMatrix, glm::vec3 const & cameraPosition);
+
+    void UpdateEclipses();
+
+    void BuildBatches();
+
+    // Draws mBatches[firstBatch, endBatch)
+    void SubmitRenderQueue(size_t firstBatch, size_t endBatch);
+
+    // The transparent bodies of the frame Render() prepared, called inside the transparent pass
+    void RenderTransparent();
+
+    // Compiles a body program (asset relative paths) and appends it to mBodyShaders
+    [[nodiscard]]
+    std::unique_ptr<BodyShader> AddBodyShader(
+        std::string const & vertexPath,
+        std::string const & fragmentPath,
+        std::vector<std::string> const & defines = {}
+    );
+
+    // Phong programs for every material feature set the bodies use, see mPhongVariants
+    void CreatePhongVariants();
+
+    void SetupGpuDrivenPath();
+
+    void UpdateGpuDrivenBodies();
+
+    void RenderGpuDriven(glm::mat4 const & projectionMatrix, glm::vec3 const & cameraPosition);
+
+    [[nodiscard]]
+    bool IsInFrustum(size_t bodyIndex) const;
+
+    [[nodiscard]]
+    BodyShader & SelectShader(CelestialBody const & body) const;
+
+    [[nodiscard]]
+    glm::ivec2 ProceduralTessellation(CelestialBody const & body) const;
+
     void PrepareUnitSphereGeometry();
 
     void PrepareSphereGeometry();
 
+    // Renders the current view at posterSize: every tile crops the same projection with a guard band around it, the
+    // bloom comes from one frame of the whole view. Returns false when the image could not be written
+    bool RenderPoster(glm::ivec2 posterSize, int tileSize, std::string const & path);
+
     void OnResize(int width, int height);
 
     void OnMouseWheelChange(double xOffset, double yOffset) const;
 
     std::shared_ptr<AssetPath> mPath{};
     std::shared_ptr<Time> mTime{};
+    Options mOptions;
     std::unique_ptr<Window> mWindow;
+    std::unique_ptr<OffscreenTarget> mOffscreen{}; // the backbuffer of headless runs
+    std::unique_ptr<FrameCapture> mFrameCapture{};
     std::shared_ptr<InputManager> mInputManager{};
 
-    std::unique_ptr<ShaderProgram> mBasicShader{};
-    std::unique_ptr<ShaderProgram> phong_shader{};
+    std::unique_ptr<BodyShader> mBasicShader{};
+    std::unique_ptr<BodyShader> phong_shader{};
+
+    // same fragment shaders, but with the attribute-less sphere vertex shader
+    std::unique_ptr<BodyShader> mProceduralBasicShader{};
+    std::unique_ptr<BodyShader> mProceduralPhongShader{};
+
+    // same fragment shaders, vertex shader reading the body storage buffer. Only created when the
+    // context can run the GPU-driven path.
+    std::unique_ptr<BodyShader> mGpuBasicShader{};
+    std::unique_ptr<BodyShader> mGpuPhongShader{};
+
+    // transparent bodies, one per vertex shader
+    std::unique_ptr<BodyShader> mTransparentShader{};
+    std::unique_ptr<BodyShader> mProceduralTransparentShader{};
+    std::unique_ptr<BodyShader> mGpuTransparentShader{};
+
+    // Phong with material features compiled in (MaterialLibrary::Feature), one program per vertex
+    // shader like above. Keyed by the feature bits, bodies without features use phong_shader.
+    struct PhongVariants
+    {
+        std::unique_ptr<BodyShader> instanced{};
+        std::unique_ptr<BodyShader> procedural{};
+        std::unique_ptr<BodyShader> gpu{}; // only with the GPU-driven path
+    };
+    std::map<uint32_t, PhongVariants> mPhongVariants{};
+
+    // every program in creation order, filled by AddBodyShader
+    std::vector<BodyShader *> mBodyShaders{};
+    // core profile needs a VAO bound for any draw, even without attributes
+    std::unique_ptr<VertexArray> mEmptyVertexArray{};
+
+    // Everything written every frame (camera block, instances, GPU body transforms) goes through
+    // this ring, so uploads never wait on draws of the previous frames.
+    std::unique_ptr<RingBuffer> mUploadRing{};
+
+    // Per body data of the whole queue, in queue order, uploaded once per frame. Bodies that share
+    // a program, material and mesh are drawn together with glDraw*Instanced.
+    std::unique_ptr<InstanceBuffer> mInstanceBuffer{};
+    std::vector<InstanceBuffer::InstanceData> mInstances{};
+    std::vector<DrawBatch> mBatches{};
+    size_t mFirstTransparentBatch = 0; // the transparent pass draws the batches from here on
+
+    // null when the context is older than GL 4.3, the CPU path is used then
+    std::unique_ptr<GpuDrivenRenderer> mGpuRenderer{};
+    RenderPath mRenderPath = RenderPath::CpuInstanced;
+    float mMinPixelRadius = 0.5f;
+
+    // all static body meshes, suballocated from one vertex and one index buffer
+    std::unique_ptr<MeshBuffer> mMeshes{};
+
+    // every body texture as a layer of a few texture arrays
+    std::unique_ptr<MaterialLibrary> mMaterials{};
+
+    SphereRenderMode mSphereRenderMode = SphereRenderMode::VertexBuffers;
+    int mProceduralTessellation = 0; // 0 keeps each body's own slices/stacks
 
     std::unique_ptr<GPU_Geometry> mUnitCubeGeometry;
     int mUnitCubeIndexCount{};
@@ -53,6 +250,56 @@ private:
 
     glm::mat4 mProjectionMatrix{};
 
+    // rebuilt every frame from the bodies' bounding spheres
+    Frustum mFrustum{};
+    bool mFrustumCullingEnabled = true;
+    std::vector<BoundingSphere> mBodyBounds{};
+
+    // bodies behind the sun or a planet are skipped, see OcclusionCuller
+    std::unique_ptr<OcclusionCuller> mOcclusionCuller{};
+    OcclusionCuller::Mode mOcclusionMode = OcclusionCuller::Mode::Off;
+
+    // occluding spheres for the analytic eclipse shadows in phong.frag
+    EclipseShadows mEclipses{};
+    bool mEclipsesEnabled = true;
+
+    // declared again every frame by AddFramePasses, keeps the transient textures between frames
+    std::unique_ptr<FrameGraph> mFrameGraph{};
+
+    // the scene is drawn into an HDR target, multisampled or anti-aliased after the fact depending on the mode,
+    // then bloom, exposure and tonemapping take it to the backbuffer
+    std::unique_ptr<AntiAliasing> mAntiAliasing{};
+    glm::ivec2 mSceneSize{0, 0};    // of the scene targets, set when the scene pass runs
+    std::unique_ptr<PostProcess> mPostProcess{};
+    std::unique_ptr<Skybox> mSkybox{};
+    std::unique_ptr<Transparency> mTransparency{};
+    std::unique_ptr<Atmosphere> mAtmosphere{};
+    DynamicResolution mDynamicResolution{};
+    FramePacer mFramePacer{};
+    float mRenderScale = 1.0f;  // of the frame being built
+
+    // visible bodies become draw items, sorted to minimize state changes
+    RenderQueue mRenderQueue{};
+
+    struct RenderStats
+    {
+        int draws = 0;
+        int instances = 0;
+        int programChanges = 0;
+        int textureChanges = 0;
+        int vertexArrayChanges = 0;
+    };
+    RenderStats mRenderStats{};
+
+    // off-axis crop applied to the projection while a poster tile is rendered, see RenderPoster
+    glm::mat4 mProjectionCrop{1.0f};
+    float mPosterAspectRatio = 0.0f;    // replaces the window's while rendering a poster
+    bool mRenderingPoster = false;
+
+    // GPU profiler window
+    bool mShowProfiler = false;
+    int mProfilerGraphScope = 0;    // index into the profiler's scopes of the last frame
+
     float mFovY = 120.0f;
     float mZNear = 0.01f;
     float mZFar = 500.0f;
@@ -62,7 +309,6 @@ private:
     // 
     std::vector<std::unique_ptr<CelestialBody>> m_bodies;
     CelestialBody* m_sun = nullptr;
-    CelestialBody* m_stars = nullptr;
     // below not used in my current submission, 
     // but setup just in case.
     CelestialBody* m_earth = nullptr;
@@ -0,0 +1,106 @@
+#include "SurfacelessContext.h"
+
+#include "Log.h"
+
+#include <cstring>
+#include <stdexcept>
+
+#ifdef SOLARSYSTEM_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+
+#ifdef SOLARSYSTEM_EGL
+
+SurfacelessContext::SurfacelessContext(int major, int minor) {
+	// the surfaceless platform first, the default display may want an X server
+	EGLDisplay eglDisplay = EGL_NO_DISPLAY;
+	auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+		eglGetProcAddress("eglGetPlatformDisplayEXT")
+	);
+	if (getPlatformDisplay != nullptr) {
+		eglDisplay = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+	}
+	if (eglDisplay == EGL_NO_DISPLAY) {
+		eglDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	}
+
+	EGLint eglMajor = 0;
+	EGLint eglMinor = 0;
+	if (eglDisplay == EGL_NO_DISPLAY || eglInitialize(eglDisplay, &eglMajor, &eglMinor) == EGL_FALSE) {
+		Log::error("EGL failed to initialize a display");
+		throw std::runtime_error("Failed to initialize EGL.");
+	}
+	display = eglDisplay;
+	Log::info("EGL {}.{} from {}", eglMajor, eglMinor, eglQueryString(eglDisplay, EGL_VENDOR));
+
+	const char* extensions = eglQueryString(eglDisplay, EGL_EXTENSIONS);
+	if (extensions == nullptr || std::strstr(extensions, "EGL_KHR_surfaceless_context") == nullptr) {
+		eglTerminate(eglDisplay);
+		throw std::runtime_error("EGL does not support surfaceless contexts.");
+	}
+
+	// a surface type of 0 matches every config, nothing is ever created from it
+	const EGLint configAttributes[] = {
+		EGL_SURFACE_TYPE, 0,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_NONE
+	};
+	EGLConfig config = nullptr;
+	EGLint configCount = 0;
+	if (eglChooseConfig(eglDisplay, configAttributes, &config, 1, &configCount) == EGL_FALSE || configCount == 0) {
+		eglTerminate(eglDisplay);
+		throw std::runtime_error("EGL has no config for desktop OpenGL.");
+	}
+
+	// same as the windowed context, see Window
+	eglBindAPI(EGL_OPENGL_API);
+	const EGLint contextAttributes[] = {
+		EGL_CONTEXT_MAJOR_VERSION_KHR, major,
+		EGL_CONTEXT_MINOR_VERSION_KHR, minor,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK_KHR, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT_KHR,
+		EGL_CONTEXT_FLAGS_KHR, EGL_CONTEXT_OPENGL_FORWARD_COMPATIBLE_BIT_KHR | EGL_CONTEXT_OPENGL_DEBUG_BIT_KHR,
+		EGL_NONE
+	};
+	context = eglCreateContext(eglDisplay, config, EGL_NO_CONTEXT, contextAttributes);
+	if (context == EGL_NO_CONTEXT) {
+		eglTerminate(eglDisplay);
+		Log::error("EGL failed to create a {}.{} core context", major, minor);
+		throw std::runtime_error("Failed to create EGL context.");
+	}
+
+	if (eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, context) == EGL_FALSE) {
+		eglDestroyContext(eglDisplay, context);
+		eglTerminate(eglDisplay);
+		throw std::runtime_error("Failed to make the EGL context current.");
+	}
+}
+
+
+SurfacelessContext::~SurfacelessContext() {
+	eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	eglDestroyContext(display, context);
+	eglTerminate(display);
+}
+
+
+void* SurfacelessContext::getProcAddress(const char* name) {
+	return reinterpret_cast<void*>(eglGetProcAddress(name));
+}
+
+#else
+
+SurfacelessContext::SurfacelessContext(int, int) {
+	throw std::runtime_error("This build has no EGL, use the OSMesa context instead.");
+}
+
+
+SurfacelessContext::~SurfacelessContext() = default;
+
+
+void* SurfacelessContext::getProcAddress(const char*) {
+	return nullptr;
+}
+
+#endif
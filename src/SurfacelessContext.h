@@ -0,0 +1,29 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// An OpenGL context without any surface, made current on construction. It uses
+// EGL_MESA_platform_surfaceless, so it needs neither a display server nor a GPU
+// (Mesa's llvmpipe renders on the CPU). Everything is drawn into framebuffer
+// objects, there is no default framebuffer.
+//
+// Only available when the build found EGL (SOLARSYSTEM_EGL), the constructor
+// throws otherwise.
+//------------------------------------------------------------------------------
+
+class SurfacelessContext {
+
+public:
+	// Core profile of at least this version
+	SurfacelessContext(int major, int minor);
+	~SurfacelessContext();
+
+	SurfacelessContext(const SurfacelessContext&) = delete;
+	SurfacelessContext& operator=(const SurfacelessContext&) = delete;
+
+	// For gladLoadGLLoader
+	static void* getProcAddress(const char* name);
+
+private:
+	void* display = nullptr; // EGLDisplay
+	void* context = nullptr; // EGLContext
+};
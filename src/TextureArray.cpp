@@ -0,0 +1,26 @@
+#include "TextureArray.h"
+
+//======================================================================================================================
+
+TextureArray::TextureArray(glm::ivec2 layerSize, GLsizei layerCount, GLint interpolation)
+	: textureID(), layerSize(layerSize), layerCount(layerCount)
+{
+	bind();
+	// storage for every layer up front, filled one layer at a time by uploadLayer
+	glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, layerSize.x, layerSize.y, layerCount, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, interpolation);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, interpolation);
+	unbind();
+}
+
+void TextureArray::uploadLayer(GLint layer, const unsigned char* pixels) {
+	bind();
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, layerSize.x, layerSize.y, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);	//Return to default alignment
+	unbind();
+}
+
+//======================================================================================================================
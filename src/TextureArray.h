@@ -0,0 +1,37 @@
+#pragma once
+
+#include "GLHandles.h"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+
+// A GL_TEXTURE_2D_ARRAY with a fixed number of RGBA8 layers of the same size.
+// Shaders pick the layer with the third texture coordinate of a sampler2DArray.
+class TextureArray {
+public:
+	TextureArray(glm::ivec2 layerSize, GLsizei layerCount, GLint interpolation);
+
+	// Because we're using the TextureHandle to do RAII for the texture for us
+	// and our other types are trivial or provide their own RAII
+	// we don't have to provide any specialized functions here. Rule of zero
+	//
+	// https://en.cppreference.com/w/cpp/language/rule_of_three
+	// https://github.com/isocpp/CppCoreGuidelines/blob/master/CppCoreGuidelines.md#Rc-zero
+
+	// Public interface
+	glm::ivec2 getLayerSize() const { return layerSize; }
+	GLsizei getLayerCount() const { return layerCount; }
+	GLuint getID() const { return textureID; }
+
+	// pixels must be layerSize.x * layerSize.y RGBA8 texels
+	void uploadLayer(GLint layer, const unsigned char* pixels);
+
+	void bind() const { glBindTexture(GL_TEXTURE_2D_ARRAY, textureID); }
+	void unbind() const { glBindTexture(GL_TEXTURE_2D_ARRAY, 0); }
+
+private:
+	TextureHandle textureID;
+	glm::ivec2 layerSize;
+	GLsizei layerCount;
+};
@@ -1,7 +1,6 @@
 #include "Time.hpp"
 
 #include <chrono>
-#include <thread>
 
 //======================================================================================================================
 
@@ -33,17 +32,15 @@ Time::~Time() = default;
 
 void Time::Update()
 {
-    auto timePoint = std::chrono::high_resolution_clock::now();
+    if (_fixedStep > 0.0f)
     {
-        std::chrono::duration<float> const duration = timePoint - _now;
-        _deltaTime = duration.count();
+        _deltaTime = _fixedStep;
+        _timeSec += _fixedStep;
+        return;
     }
 
-    if (_deltaTime <= MinDeltaTime)
+    auto const timePoint = std::chrono::high_resolution_clock::now();
     {
-        int const dtMs = static_cast<int>((MinDeltaTime - _deltaTime) * 1000.0f);
-        std::this_thread::sleep_for(std::chrono::milliseconds(dtMs));
-        timePoint = std::chrono::high_resolution_clock::now();
         std::chrono::duration<float> const duration = timePoint - _now;
         _deltaTime = duration.count();
     }
@@ -58,6 +55,13 @@ void Time::Update()
 
 //======================================================================================================================
 
+void Time::SetFixedStep(float const seconds)
+{
+    _fixedStep = seconds;
+}
+
+//======================================================================================================================
+
 float Time::DeltaTimeSec() const
 {
     return _deltaTime;
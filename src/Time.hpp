@@ -7,9 +7,7 @@ class Time
 {
 public:
 
-    static constexpr int MaxFramerate = 120;
     static constexpr int MinFramerate = 30;
-    static constexpr float MinDeltaTime = 1.0f / static_cast<float>(MaxFramerate);
     static constexpr float MaxDeltaTime = 1.0f / static_cast<float>(MinFramerate);
 
     static std::shared_ptr<Time> Instance();
@@ -25,8 +23,13 @@ public:
     Time(Time&&) = delete;                 // Move constructor
     Time& operator=(Time&&) = delete;      // Move assignment
 
+    // Measures the time since the last call, the frame rate is left to FramePacer
     void Update();
 
+    // Above zero, every Update() advances by exactly this many seconds without looking at the
+    // clock or sleeping, so captured clips play at the intended speed however long frames take
+    void SetFixedStep(float seconds);
+
     [[nodiscard]]
     float DeltaTimeSec() const;
 
@@ -43,4 +46,5 @@ private:
     TimePoint _now {};
     float _deltaTime {};
     float _timeSec{};
+    float _fixedStep{};
 };
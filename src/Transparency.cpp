@@ -0,0 +1,144 @@
+#include "Transparency.hpp"
+
+#include "AssetPath.h"
+
+//======================================================================================================================
+
+Transparency::Transparency()
+{
+    auto const path = AssetPath::Instance();
+    mCompositeShader = std::make_unique<ShaderProgram>(path->Get("shaders/fullscreen.vert"), path->Get("shaders/oit_composite.frag"));
+    mCompositeAccumulation = mCompositeShader->uniform("accumulation");
+    mCompositeWeights = mCompositeShader->uniform("weights");
+
+    // the composite pass binds the two targets to these units
+    mCompositeShader->use();
+    mCompositeShader->set(mCompositeAccumulation, 0);
+    mCompositeShader->set(mCompositeWeights, 1);
+    glUseProgram(0);
+}
+
+//======================================================================================================================
+
+void Transparency::AddPasses(
+    FrameGraph & graph,
+    FrameGraph::ResourceId const hdrColor,
+    FrameGraph::ResourceId const sceneDepth,
+    FrameGraph::TextureDesc const & depthDesc,
+    DrawFunction draw
+)
+{
+    if (mSettings.enabled == false)
+    {
+        return;
+    }
+
+    FrameGraph::ResourceId const depth = AddDepthPasses(graph, sceneDepth, depthDesc);
+
+    FrameGraph::TextureDesc target_desc {};
+    target_desc.scale = depthDesc.scale * mSettings.resolutionScale;
+    target_desc.format = AccumulationFormat;
+    FrameGraph::ResourceId const accumulation = graph.Create("transparent_accumulation", target_desc);
+    target_desc.format = WeightFormat;
+    FrameGraph::ResourceId const weights = graph.Create("transparent_weights", target_desc);
+
+    graph.AddPass(
+        "transparent",
+        [accumulation, weights, depth](FrameGraph::Builder & builder)->void {
+            builder.Write(accumulation);
+            builder.Write(weights);
+            builder.Write(depth); // only tested
+        },
+        [draw = std::move(draw)](FrameGraph const &)->void {
+            // nothing in front of the scene yet: no colour, everything revealed
+            GLfloat const clear_accumulation[] = {0.0f, 0.0f, 0.0f, 1.0f};
+            GLfloat const clear_weights[] = {0.0f, 0.0f, 0.0f, 0.0f};
+            glClearBufferfv(GL_COLOR, 0, clear_accumulation);
+            glClearBufferfv(GL_COLOR, 1, clear_weights);
+
+            // GL 3.3 has no per target blend functions, so both targets share one that adds colour and multiplies
+            // alpha: accumulation.rgb and weights.r are sums, accumulation.a is the product of (1 - alpha)
+            glEnable(GL_BLEND);
+            glBlendFuncSeparate(GL_ONE, GL_ONE, GL_ZERO, GL_ONE_MINUS_SRC_ALPHA);
+            glEnable(GL_DEPTH_TEST);
+            glDepthFunc(GL_LESS);
+            glDepthMask(GL_FALSE);
+
+            draw();
+
+            glDepthMask(GL_TRUE);
+            glDisable(GL_BLEND);
+        }
+    );
+
+    graph.AddPass(
+        "transparent_composite",
+        [hdrColor, accumulation, weights](FrameGraph::Builder & builder)->void {
+            builder.Read(accumulation);
+            builder.Read(weights);
+            builder.Write(hdrColor);
+        },
+        [this, accumulation, weights](FrameGraph const & frameGraph)->void {
+            mCompositeShader->use();
+            frameGraph.BindTexture(accumulation, 0);
+            frameGraph.BindTexture(weights, 1);
+
+            glDisable(GL_DEPTH_TEST);
+            glEnable(GL_BLEND);
+            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+            frameGraph.DrawFullscreen();
+            glDisable(GL_BLEND);
+        }
+    );
+}
+
+//======================================================================================================================
+
+FrameGraph::ResourceId Transparency::AddDepthPasses(
+    FrameGraph & graph,
+    FrameGraph::ResourceId const sceneDepth,
+    FrameGraph::TextureDesc const & depthDesc
+)
+{
+    FrameGraph::ResourceId depth = sceneDepth;
+    FrameGraph::TextureDesc desc = depthDesc;
+    desc.samples = 1;
+
+    if (depthDesc.samples > 1)
+    {
+        FrameGraph::ResourceId const source = depth;
+        depth = graph.Create("transparent_depth_resolved", desc);
+        graph.AddPass(
+            "transparent_depth_resolve",
+            [source, depth](FrameGraph::Builder & builder)->void {
+                builder.Read(source);
+                builder.Write(depth);
+            },
+            [source](FrameGraph const & frameGraph)->void {
+                frameGraph.Blit(source, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+            }
+        );
+    }
+
+    if (mSettings.resolutionScale < 1.0f)
+    {
+        // the nearest sample, depth can not be filtered
+        FrameGraph::ResourceId const source = depth;
+        desc.scale = depthDesc.scale * mSettings.resolutionScale;
+        depth = graph.Create("transparent_depth", desc);
+        graph.AddPass(
+            "transparent_depth_downsample",
+            [source, depth](FrameGraph::Builder & builder)->void {
+                builder.Read(source);
+                builder.Write(depth);
+            },
+            [source](FrameGraph const & frameGraph)->void {
+                frameGraph.Blit(source, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+            }
+        );
+    }
+
+    return depth;
+}
+
+//======================================================================================================================
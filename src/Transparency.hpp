@@ -0,0 +1,63 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Weighted blended order independent transparency (McGuire and Bavoil 2013).
+// Transparent surfaces are drawn in any order into two targets: the sum of
+// their depth weighted premultiplied colours, with the product of their
+// transmittance (the revealage) in its alpha, and the sum of the weights. A
+// full-screen pass then blends the weighted average colour over the scene by
+// one minus the revealage, so no per-frame sorting is needed. The targets are
+// a fraction of the scene's resolution to bound the fill rate, tested against
+// a copy of the scene depth at that size.
+//------------------------------------------------------------------------------
+
+#include "FrameGraph.hpp"
+#include "ShaderProgram.h"
+
+#include <functional>
+#include <memory>
+
+class Transparency
+{
+public:
+
+    struct Settings
+    {
+        bool enabled = true;
+        float resolutionScale = 0.5f;   // of the scene targets
+    };
+
+    // Draws the transparent surfaces, with the blend state and both targets already set up
+    using DrawFunction = std::function<void()>;
+
+    explicit Transparency();
+
+    // Adds the passes that composite draw's surfaces over hdrColor. sceneDepth is tested against but never written,
+    // depthDesc is the description it was created with.
+    void AddPasses(
+        FrameGraph & graph,
+        FrameGraph::ResourceId hdrColor,
+        FrameGraph::ResourceId sceneDepth,
+        FrameGraph::TextureDesc const & depthDesc,
+        DrawFunction draw
+    );
+
+    [[nodiscard]]
+    Settings & GetSettings() { return mSettings; }
+
+    static constexpr GLenum AccumulationFormat = GL_RGBA16F;
+    static constexpr GLenum WeightFormat = GL_R16F;
+
+private:
+
+    // A single sample copy of the scene depth at the transparent resolution, blitted down in up to two steps
+    // because multisample sources can only be resolved at their own size
+    [[nodiscard]]
+    FrameGraph::ResourceId AddDepthPasses(FrameGraph & graph, FrameGraph::ResourceId sceneDepth, FrameGraph::TextureDesc const & depthDesc);
+
+    Settings mSettings {};
+
+    std::unique_ptr<ShaderProgram> mCompositeShader {};
+    ShaderProgram::Uniform mCompositeAccumulation {};
+    ShaderProgram::Uniform mCompositeWeights {};
+};
@@ -0,0 +1,64 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// std140 uniform blocks shared by every shader program. The C++ structs below
+// mirror the GLSL declarations, so they must be kept in the same order and
+// padded the same way. ShaderProgram binds any block listed in Bindings to
+// its fixed binding point right after linking.
+//------------------------------------------------------------------------------
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+namespace UniformBlocks
+{
+    // layout (std140) uniform FrameData - written once per frame
+    struct FrameData
+    {
+        glm::mat4 viewMatrix;
+        glm::mat4 projectionMatrix;
+        glm::vec4 cameraPosition; // w unused
+    };
+    static_assert(sizeof(FrameData) == 144, "FrameData must match the std140 layout");
+
+    inline constexpr GLuint FrameDataBinding = 0;
+
+    inline constexpr int MaxEclipseOccluders = 16;
+
+    // layout (std140) uniform Eclipses - the spheres that can shadow a lit body this frame, see EclipseShadows.
+    // Each body selects its occluders with a bit mask in its instance data.
+    struct EclipseData
+    {
+        glm::vec4 sun;              // xyz centre, w radius
+        glm::uvec4 info;            // x = occluder count, yzw unused
+        glm::vec4 occluders[MaxEclipseOccluders]; // xyz centre, w radius
+    };
+    static_assert(sizeof(EclipseData) == 288, "EclipseData must match the std140 layout");
+
+    inline constexpr GLuint EclipsesBinding = 1;
+
+    // layout (std140) uniform Atmosphere - the scattering model of Atmosphere, in kilometres. Written once.
+    struct AtmosphereData
+    {
+        glm::vec4 radii;              // x ground, y top of the atmosphere, z Mie phase asymmetry, w ground albedo
+        glm::vec4 rayleighScattering; // rgb per km at the ground, w scale height
+        glm::vec4 mie;                // x scattering, y extinction per km at the ground, z scale height, w unused
+        glm::vec4 ozoneAbsorption;    // rgb per km at the peak, w peak height
+        glm::vec4 ozone;              // x half width of the tent shaped layer, yzw unused
+    };
+    static_assert(sizeof(AtmosphereData) == 80, "AtmosphereData must match the std140 layout");
+
+    inline constexpr GLuint AtmosphereBinding = 2;
+
+    struct Binding
+    {
+        char const * name;
+        GLuint point;
+    };
+
+    inline constexpr Binding Bindings[] = {
+        {"FrameData", FrameDataBinding},
+        {"Eclipses", EclipsesBinding},
+        {"Atmosphere", AtmosphereBinding},
+    };
+}
@@ -0,0 +1,26 @@
+#include "UniformBuffer.h"
+
+//======================================================================================================================
+
+UniformBuffer::UniformBuffer(GLuint bindingPoint)
+	: bufferID{}
+	, bindingPoint(bindingPoint)
+{
+}
+
+void UniformBuffer::uploadData(GLsizeiptr size, const void* data) {
+	bind();
+	if (size > capacity) {
+		capacity = size;
+		glBufferData(GL_UNIFORM_BUFFER, capacity, data, GL_DYNAMIC_DRAW);
+		return;
+	}
+	glBufferData(GL_UNIFORM_BUFFER, capacity, nullptr, GL_DYNAMIC_DRAW);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, size, data);
+}
+
+void UniformBuffer::bindBase() const {
+	glBindBufferBase(GL_UNIFORM_BUFFER, bindingPoint, bufferID);
+}
+
+//======================================================================================================================
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "GLHandles.h"
+
+#include <glad/glad.h>
+
+
+// A uniform buffer object attached to a fixed binding point (see UniformBlocks.hpp)
+class UniformBuffer {
+
+public:
+	explicit UniformBuffer(GLuint bindingPoint);
+
+	// Because we're using the VertexBufferHandle to do RAII for the buffer for us
+	// and our other types are trivial or provide their own RAII
+	// we don't have to provide any specialized functions here. Rule of zero
+	//
+	// https://en.cppreference.com/w/cpp/language/rule_of_three
+	// https://github.com/isocpp/CppCoreGuidelines/blob/master/CppCoreGuidelines.md#Rc-zero
+
+	// Public interface
+	void bind() const { glBindBuffer(GL_UNIFORM_BUFFER, bufferID); }
+
+	// Overwrites the contents. Storage is only reallocated when it has to grow,
+	// otherwise it is orphaned so the driver doesn't wait for draws still reading it.
+	void uploadData(GLsizeiptr size, const void* data);
+
+	// Attaches the whole buffer to its binding point
+	void bindBase() const;
+
+private:
+	VertexBufferHandle bufferID;
+	GLuint bindingPoint;
+	GLsizeiptr capacity = 0;
+};
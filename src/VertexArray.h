@@ -18,6 +18,7 @@ public:
 
 	// Public interface
 	void bind() const { glBindVertexArray(arrayID); }
+	GLuint getID() const { return arrayID; }
 
 private:
 	VertexArrayHandle arrayID;
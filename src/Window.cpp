@@ -1,6 +1,7 @@
 #include "Window.h"
 
 #include "Log.h"
+#include "SurfacelessContext.h"
 #include "imgui.h"
 #include "backends/imgui_impl_glfw.h"
 #include "backends/imgui_impl_opengl3.h"
@@ -101,11 +102,7 @@ Window::Window(
 	, callbacks(callbacks)
 {
 	// specify OpenGL version
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE); // needed for mac?
-	glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GL_TRUE);
+	hintContextVersion();
 
 	// create window
 	window = std::unique_ptr<GLFWwindow, WindowDeleter>(glfwCreateWindow(width, height, title, monitor, share));
@@ -116,7 +113,7 @@ Window::Window(
 	glfwMakeContextCurrent(window.get());
 
 	// initialize OpenGL extensions for the current context (this window)
-	if (!gladLoadGL()) {
+	if (!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(glfwGetProcAddress))) {
 		throw std::runtime_error("Failed to initialize GLAD");
 	}
 
@@ -134,6 +131,98 @@ Window::Window(int width, int height, const char* title, GLFWmonitor* monitor, G
 {}
 
 
+Window::Window(int width, int height, const char* title, ContextApi api)
+	: window(nullptr)
+	, callbacks(nullptr)
+	, headless(true)
+{
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	if (api == ContextApi::EGL) {
+		// GLFW can only make EGL contexts for window surfaces, so the window gets none
+		glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+	}
+	else {
+		hintContextVersion();
+		glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_OSMESA_CONTEXT_API);
+	}
+
+	window = std::unique_ptr<GLFWwindow, WindowDeleter>(glfwCreateWindow(width, height, title, NULL, NULL));
+	glfwDefaultWindowHints();
+	if (window == nullptr) {
+		Log::error("WINDOW failed to create headless GLFW window");
+		throw std::runtime_error("Failed to create headless GLFW window.");
+	}
+
+	GLADloadproc loader = reinterpret_cast<GLADloadproc>(glfwGetProcAddress);
+	if (api == ContextApi::EGL) {
+		surfaceless = std::make_unique<SurfacelessContext>(3, 3);
+		loader = SurfacelessContext::getProcAddress;
+	}
+	else {
+		glfwMakeContextCurrent(window.get());
+	}
+
+	if (!gladLoadGLLoader(loader)) {
+		throw std::runtime_error("Failed to initialize GLAD");
+	}
+	Log::info("WINDOW headless {}x{} on {}", width, height, reinterpret_cast<const char*>(glGetString(GL_RENDERER)));
+}
+
+
+Window::~Window() = default;
+
+
+void Window::hintContextVersion() {
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE); // needed for mac?
+	glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GL_TRUE);
+}
+
+
+void Window::makeContextCurrent() {
+	// the surfaceless context never stops being current
+	if (surfaceless == nullptr) {
+		glfwMakeContextCurrent(window.get());
+	}
+}
+
+
+void Window::swapBuffers() {
+	// nothing is presented without a display
+	if (!headless) {
+		glfwSwapBuffers(window.get());
+	}
+}
+
+
+void Window::setSwapInterval(int interval) {
+	if (headless) {
+		return;
+	}
+	if (interval < 0 && !glfwExtensionSupported("WGL_EXT_swap_control_tear") && !glfwExtensionSupported("GLX_EXT_swap_control_tear")) {
+		Log::warn("WINDOW adaptive vsync is not supported, using vsync");
+		interval = 1;
+	}
+	makeContextCurrent();
+	glfwSwapInterval(interval);
+}
+
+
+int Window::getRefreshRate() const {
+	if (headless) {
+		return 0;
+	}
+	GLFWmonitor* monitor = glfwGetWindowMonitor(window.get());
+	if (monitor == nullptr) {
+		monitor = glfwGetPrimaryMonitor();
+	}
+	const GLFWvidmode* mode = monitor != nullptr ? glfwGetVideoMode(monitor) : nullptr;
+	return mode != nullptr ? mode->refreshRate : 0;
+}
+
+
 void Window::connectCallbacks() {
 	// set userdata of window to point to the object that carries out the callbacks
 	glfwSetWindowUserPointer(window.get(), callbacks.get());
@@ -11,6 +11,8 @@
 
 #include <memory>
 
+class SurfacelessContext;
+
 
 // Class that specifies the interface for the most common GLFW callbacks
 //
@@ -42,12 +44,26 @@ struct WindowDeleter {
 class Window {
 
 public:
+	// Where a headless window's context comes from. Headless windows need GLFW's null
+	// platform (glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL) before glfwInit), are never
+	// shown and have no usable default framebuffer, so everything is drawn into framebuffer
+	// objects. Input callbacks and sizes still work as for a real window.
+	enum class ContextApi {
+		EGL,    // surfaceless EGL context, see SurfacelessContext
+		OSMesa  // OSMesa context created by GLFW, libOSMesa is loaded at runtime
+	};
+
 	Window(
 		std::shared_ptr<CallbackInterface> callbacks, int width, int height,
 		const char* title, GLFWmonitor* monitor = NULL, GLFWwindow* share = NULL
 	);
 	Window(int width, int height, const char* title, GLFWmonitor* monitor = NULL, GLFWwindow* share = NULL);
 
+	// A headless window of that size
+	Window(int width, int height, const char* title, ContextApi api);
+
+	~Window();
+
 	void setCallbacks(std::shared_ptr<CallbackInterface> callbacks);
 
 	glm::ivec2 getPos() const;
@@ -60,14 +76,28 @@ public:
 	int getHeight() const { return getSize().y; }
 
 	int shouldClose() { return glfwWindowShouldClose(window.get()); }
-	void makeContextCurrent() { glfwMakeContextCurrent(window.get()); }
-	void swapBuffers() { glfwSwapBuffers(window.get()); }
+	void makeContextCurrent();
+	void swapBuffers();
+
+	// 0 presents at once, 1 waits for the vertical blank, -1 is adaptive vsync (late frames tear
+	// instead of waiting), which falls back to 1 without EXT_swap_control_tear. Ignored headless.
+	void setSwapInterval(int interval);
+
+	// Of the monitor the window is on, or the primary one for windowed mode. 0 when unknown.
+	int getRefreshRate() const;
+
+	bool isHeadless() const { return headless; }
 
 	GLFWwindow* getGLFWwindow() const { return window.get(); }
 
 private:
 	std::unique_ptr<GLFWwindow, WindowDeleter> window; // owning ptr (from GLFW)
 	std::shared_ptr<CallbackInterface> callbacks;      // optional shared owning ptr (user provided)
+	std::unique_ptr<SurfacelessContext> surfaceless;   // the context of headless EGL windows
+	bool headless = false;
+
+	// the context hints shared by every window
+	static void hintContextVersion();
 
 	void connectCallbacks();
 
@@ -2,14 +2,114 @@
 #include "SolarSystem.hpp"
 
 #include "GLFW/glfw3.h"
+#include <argh.h>
 
-int main() {
+#include <sstream>
+#include <string>
+
+int main(int argc, char* argv[]) {
     Log::debug("Starting main");
 
+    // solarsystem [--width 800] [--height 800]
+    //             [--headless [--context egl|osmesa] [--frames 1] [--output frame.ppm]]
+    //             [--capture directory | --capture-pipe "command"] [--fps 60]
+    //             [--poster 16384x16384 [--poster-tile 2048] --output poster.ppm]
+    //             [--aa off|msaa|fxaa|taa] [--samples 8] [--profile-output gpu.csv|gpu.json]
+    //             [--pacing vsync|adaptive|uncapped|limit] [--max-fps 120]
+    argh::parser cmdl;
+    cmdl.add_params({
+        "--width", "--height", "--context", "--frames", "--output", "--capture", "--capture-pipe", "--fps",
+        "--poster", "--poster-tile", "--aa", "--samples", "--profile-output", "--pacing", "--max-fps"
+    });
+    cmdl.parse(argc, argv);
+
+    SolarSystem::Options options{};
+    cmdl("--width", options.size.x) >> options.size.x;
+    cmdl("--height", options.size.y) >> options.size.y;
+    options.headless = cmdl["--headless"];
+    cmdl("--frames", options.frames) >> options.frames;
+    options.output = cmdl("--output").str();
+    options.capture = cmdl("--capture").str();
+    options.capturePipe = cmdl("--capture-pipe").str();
+    options.profileOutput = cmdl("--profile-output").str();
+    cmdl("--fps", options.captureFps) >> options.captureFps;
+    cmdl("--poster-tile", options.posterTile) >> options.posterTile;
+    cmdl("--samples", options.msaaSamples) >> options.msaaSamples;
+    cmdl("--max-fps", options.maxFps) >> options.maxFps;
+
+    std::string const poster = cmdl("--poster").str();
+    if (!poster.empty()) {
+        char separator = 0;
+        std::istringstream stream(poster);
+        if (!(stream >> options.posterSize.x >> separator >> options.posterSize.y) || separator != 'x'
+            || options.posterSize.x <= 0 || options.posterSize.y <= 0 || options.posterTile <= 0) {
+            Log::error("--poster expects a size like 16384x16384");
+            return 1;
+        }
+        if (options.output.empty()) {
+            Log::error("--poster needs an --output file");
+            return 1;
+        }
+    }
+
+    std::string const aa = cmdl("--aa", "msaa").str();
+    if (aa == "off") {
+        options.antiAliasing = AntiAliasing::Mode::Off;
+    }
+    else if (aa == "fxaa") {
+        options.antiAliasing = AntiAliasing::Mode::Fxaa;
+    }
+    else if (aa == "taa") {
+        options.antiAliasing = AntiAliasing::Mode::Taa;
+    }
+    else if (aa != "msaa") {
+        Log::error("Unknown --aa {}, expected off, msaa, fxaa or taa", aa);
+        return 1;
+    }
+
+    std::string const pacing = cmdl("--pacing", "vsync").str();
+    if (pacing == "adaptive") {
+        options.pacing = FramePacer::Mode::AdaptiveVsync;
+    }
+    else if (pacing == "uncapped") {
+        options.pacing = FramePacer::Mode::Uncapped;
+    }
+    else if (pacing == "limit") {
+        options.pacing = FramePacer::Mode::Limited;
+    }
+    else if (pacing != "vsync") {
+        Log::error("Unknown --pacing {}, expected vsync, adaptive, uncapped or limit", pacing);
+        return 1;
+    }
+
+    std::string const context = cmdl("--context", "egl").str();
+    if (context == "osmesa") {
+        options.contextApi = Window::ContextApi::OSMesa;
+    }
+    else if (context != "egl") {
+        Log::error("Unknown --context {}, expected egl or osmesa", context);
+        return 1;
+    }
+    if (options.size.x <= 0 || options.size.y <= 0 || options.frames <= 0 || options.captureFps <= 0 || options.maxFps <= 0.0f) {
+        Log::error("--width, --height, --frames, --fps and --max-fps have to be positive");
+        return 1;
+    }
+
+    glfwSetErrorCallback([](int const error, const char* const description) {
+        Log::error("GLFW {:#x}: {}", error, description);
+    });
+
+    // headless runs need no display server, GLFW's null platform only tracks window state
+    if (options.headless) {
+        glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+    }
+
     // WINDOW
-    glfwInit();
+    if (glfwInit() == GLFW_FALSE) {
+        return 1;
+    }
     {
-        SolarSystem solarSystem{};
+        SolarSystem solarSystem{options};
         solarSystem.Run();
     }
     glfwTerminate();